@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Run the Matrix32 microbenchmarks and check them against a baseline.
+
+Host (builds main/bench.c once per matrix size, times in ns):
+    bench/bench.py
+    bench/bench.py --save-baseline
+
+Device (fetches GET /bench from a running panel, times in CPU cycles):
+    bench/bench.py --device http://matrix32.local
+
+The JSON benchmarks need cJSON; on the host it is taken from
+$IDF_PATH/components/json/cJSON and skipped if that is not available.
+bench/baseline_host.json was recorded without it, so it has no json/*
+entries, and there is no bench/baseline_device.json yet: results with no
+baseline are listed as "new" and not checked until one is saved.
+Exits non-zero if any result is slower than baseline by more than the
+threshold, or if a render/* result at 32x32 or smaller would not fit a
+60 fps frame.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import urllib.request
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAIN = os.path.join(ROOT, "main")
+HOST_SOURCES = ["matrix_state.c", "effects.c", "expr_vm.c", "compositor.c", "life.c", "noise.c", "calibration.c", "pixel_pipeline.cpp", "frame_cache.c", "gif.c", "bench.c"]
+JSON_SOURCES = ["draw.c", "pixel_json.c"]
+FRAME_BUDGET_US = 1e6 / 60
+BUDGET_MAX_CELLS = 32 * 32
+
+
+def cjson_dir():
+    idf = os.environ.get("IDF_PATH")
+    path = os.path.join(idf, "components", "json", "cJSON") if idf else None
+    return path if path and os.path.exists(os.path.join(path, "cJSON.c")) else None
+
+
+def run_host(size, cc, workdir):
+    exe = os.path.join(workdir, "bench_%d" % size)
+    cmd = [cc, "-O2", "-DMATRIX_ROWS=%d" % size, "-DMATRIX_COLS=%d" % size,
+           "-I", MAIN, "-o", exe, os.path.join(ROOT, "bench", "host_main.c")]
+    cmd += [os.path.join(MAIN, f) for f in HOST_SOURCES]
+    cj = cjson_dir()
+    if cj:
+        cmd += ["-I", cj, os.path.join(cj, "cJSON.c")]
+        cmd += [os.path.join(MAIN, f) for f in JSON_SOURCES]
+    else:
+        cmd += ["-DBENCH_NO_CJSON"]
+    cmd += ["-lm"]
+    subprocess.run(cmd, check=True)
+    out = subprocess.run([exe], check=True, capture_output=True, text=True).stdout
+    return json.loads(out)
+
+
+def run_device(url):
+    with urllib.request.urlopen(url.rstrip("/") + "/bench", timeout=120) as resp:
+        return json.loads(resp.read())
+
+
+def over_budget(reports):
+    """render/* results that would not fit a 60 fps frame on their own."""
+    over = []
+    for report in reports:
+        cols, rows = (int(n) for n in report["size"].split("x"))
+        if cols * rows > BUDGET_MAX_CELLS:
+            continue
+        per_us = 1000.0 if report["unit"] == "ns" else report.get("cpu_mhz", 240)
+        for r in report["results"]:
+            us = r["per_iter"] / per_us
+            if r["name"].startswith("render/") and us > FRAME_BUDGET_US:
+                over.append(("%s@%s" % (r["name"], report["size"]), us))
+    return over
+
+
+def flatten(reports):
+    results = {}
+    for report in reports:
+        for r in report["results"]:
+            results["%s@%s" % (r["name"], report["size"])] = r["per_iter"]
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--device", help="base URL of a panel to benchmark instead of the host")
+    parser.add_argument("--sizes", default="8,16,32,64", help="host matrix sizes (square)")
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"))
+    parser.add_argument("--baseline", help="baseline file (default bench/baseline_<host|device>.json)")
+    parser.add_argument("--save-baseline", action="store_true", help="write results as the new baseline")
+    parser.add_argument("--threshold", type=float, default=0.15, help="allowed slowdown, 0.15 = 15%%")
+    parser.add_argument("--out", help="also write the raw results here")
+    args = parser.parse_args()
+
+    target = "device" if args.device else "host"
+    baseline_path = args.baseline or os.path.join(ROOT, "bench", "baseline_%s.json" % target)
+
+    if args.device:
+        reports = [run_device(args.device)]
+    else:
+        if not cjson_dir():
+            print("cJSON not found under $IDF_PATH, skipping json/*", file=sys.stderr)
+        with tempfile.TemporaryDirectory() as workdir:
+            reports = [run_host(int(s), args.cc, workdir) for s in args.sizes.split(",")]
+    unit = reports[0]["unit"]
+    results = flatten(reports)
+
+    if args.out:
+        with open(args.out, "w") as f:
+            json.dump({"unit": unit, "results": results}, f, indent=2, sort_keys=True)
+    if args.save_baseline:
+        with open(baseline_path, "w") as f:
+            json.dump({"unit": unit, "results": results}, f, indent=2, sort_keys=True)
+            f.write("\n")
+        print("baseline written to %s" % baseline_path)
+        return 0
+
+    baseline = {}
+    if os.path.exists(baseline_path):
+        with open(baseline_path) as f:
+            stored = json.load(f)
+        if stored.get("unit") == unit:
+            baseline = stored["results"]
+    else:
+        print("no baseline at %s, nothing to compare against" % baseline_path)
+
+    regressions = 0
+    print("%-44s %12s %12s %8s" % ("benchmark", unit, "baseline", "change"))
+    for key in sorted(results):
+        value = results[key]
+        base = baseline.get(key)
+        if base:
+            change = (value - base) / base
+            flag = "  REGRESSION" if change > args.threshold else ""
+            regressions += bool(flag)
+            print("%-44s %12d %12d %+7.1f%%%s" % (key, value, base, change * 100, flag))
+        else:
+            print("%-44s %12d %12s %8s" % (key, value, "-", "new"))
+
+    over = over_budget(reports)
+    for key, us in over:
+        print("%s takes %.0f us, over the %.0f us frame budget" % (key, us, FRAME_BUDGET_US))
+
+    if regressions:
+        print("%d benchmark(s) regressed by more than %.0f%%" % (regressions, args.threshold * 100))
+    return 1 if regressions or over else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
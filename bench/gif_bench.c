@@ -0,0 +1,324 @@
+// Host benchmark for the streaming GIF player (main/gif.c).
+//
+//   cc -O2 -Imain -DMATRIX_ROWS=32 -DMATRIX_COLS=32 bench/gif_bench.c
+//      main/gif.c -lm -o gif_bench
+//   ./gif_bench            # built-in animations at common sizes
+//   ./gif_bench a.gif ...  # real files
+//
+// Encodes an animation at each size (a scrolling 256-colour plasma, full
+// frames, and the same as the small transparent patches an optimising
+// encoder leaves), then times decoding it into the compiled geometry (8x8
+// by default) through a memory source, as the display mode plays it from
+// flash. Prints the file size and the time per frame.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gif.h"
+
+#define BENCH_FRAMES    16
+#define BENCH_MIN_TIME  0.5     // seconds of decoding per case
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t cap;
+} out_t;
+
+static void put(out_t *o, uint8_t b)
+{
+    if (o->len == o->cap) {
+        o->cap = o->cap ? o->cap * 2 : 4096;
+        o->data = realloc(o->data, o->cap);
+        if (!o->data) exit(1);
+    }
+    o->data[o->len++] = b;
+}
+
+static void put16(out_t *o, uint16_t v)
+{
+    put(o, v & 0xff);
+    put(o, v >> 8);
+}
+
+// LZW coder state: codes are packed LSB first into 255-byte sub-blocks.
+typedef struct {
+    out_t *out;
+    uint8_t block[255];
+    int block_len;
+    uint32_t bits;
+    int nbits;
+} packer_t;
+
+static void pack_flush_block(packer_t *p)
+{
+    if (p->block_len == 0) return;
+    put(p->out, p->block_len);
+    for (int i = 0; i < p->block_len; i++) put(p->out, p->block[i]);
+    p->block_len = 0;
+}
+
+static void pack(packer_t *p, uint16_t code, int width)
+{
+    p->bits |= (uint32_t)code << p->nbits;
+    p->nbits += width;
+    while (p->nbits >= 8) {
+        p->block[p->block_len++] = p->bits & 0xff;
+        if (p->block_len == 255) pack_flush_block(p);
+        p->bits >>= 8;
+        p->nbits -= 8;
+    }
+}
+
+#define HASH_SIZE 5003
+
+static void lzw_encode(out_t *o, const uint8_t *px, size_t n, int min_size)
+{
+    static int32_t keys[HASH_SIZE];
+    static uint16_t codes[HASH_SIZE];
+    const uint16_t clear = 1 << min_size;
+    uint16_t next = clear + 2;
+    int width = min_size + 1;
+    packer_t p = { .out = o };
+
+    put(o, min_size);
+    memset(keys, -1, sizeof(keys));
+    pack(&p, clear, width);
+    uint16_t prefix = px[0];
+    for (size_t i = 1; i < n; i++) {
+        int32_t key = (prefix << 8) | px[i];
+        uint32_t h = (uint32_t)key % HASH_SIZE;
+        while (keys[h] >= 0 && keys[h] != key) h = (h + 1) % HASH_SIZE;
+        if (keys[h] == key) {
+            prefix = codes[h];
+            continue;
+        }
+        pack(&p, prefix, width);
+        if (next < 4096) {
+            keys[h] = key;
+            codes[h] = next++;
+            if (next > (1u << width) && width < 12) width++;
+        } else {
+            pack(&p, clear, width);
+            memset(keys, -1, sizeof(keys));
+            next = clear + 2;
+            width = min_size + 1;
+        }
+        prefix = px[i];
+    }
+    pack(&p, prefix, width);
+    pack(&p, clear + 1, width);
+    if (p.nbits > 0) pack(&p, 0, 8 - p.nbits);
+    pack_flush_block(&p);
+    put(o, 0);
+}
+
+typedef struct {
+    uint16_t left, top, width, height;
+    uint8_t disposal;
+    int transparent;            // -1 for none
+    uint16_t delay_cs;
+    bool interlaced;
+} gif_frame_t;
+
+static void gif_begin(out_t *o, uint16_t width, uint16_t height, const pixel_color_t *pal)
+{
+    for (const char *s = "GIF89a"; *s; s++) put(o, *s);
+    put16(o, width);
+    put16(o, height);
+    put(o, 0xf7);               // global palette of 256 entries
+    put(o, 0);
+    put(o, 0);
+    for (int i = 0; i < 256; i++) {
+        put(o, pal[i].r);
+        put(o, pal[i].g);
+        put(o, pal[i].b);
+    }
+}
+
+// px holds the frame's own width x height indices, in display row order.
+static void gif_add_frame(out_t *o, const gif_frame_t *f, const uint8_t *px)
+{
+    put(o, 0x21);
+    put(o, 0xf9);
+    put(o, 4);
+    put(o, (f->disposal << 2) | (f->transparent >= 0));
+    put16(o, f->delay_cs);
+    put(o, f->transparent >= 0 ? f->transparent : 0);
+    put(o, 0);
+
+    put(o, 0x2c);
+    put16(o, f->left);
+    put16(o, f->top);
+    put16(o, f->width);
+    put16(o, f->height);
+    put(o, f->interlaced ? 0x40 : 0);
+
+    size_t n = (size_t)f->width * f->height;
+    const uint8_t *rows = px;
+    uint8_t *order = NULL;
+    if (f->interlaced) {
+        static const int start[4] = { 0, 4, 2, 1 }, step[4] = { 8, 8, 4, 2 };
+        order = malloc(n);
+        size_t at = 0;
+        for (int pass = 0; pass < 4; pass++) {
+            for (int y = start[pass]; y < f->height; y += step[pass]) {
+                memcpy(order + at, px + (size_t)y * f->width, f->width);
+                at += f->width;
+            }
+        }
+        rows = order;
+    }
+    lzw_encode(o, rows, n, 8);
+    free(order);
+}
+
+static void gif_end(out_t *o)
+{
+    put(o, 0x3b);
+}
+
+static void plasma_palette(pixel_color_t *pal)
+{
+    for (int i = 0; i < 256; i++) {
+        double a = i * 2 * M_PI / 256;
+        pal[i] = (pixel_color_t){
+            (uint8_t)(127.5 + 127.5 * sin(a)),
+            (uint8_t)(127.5 + 127.5 * sin(a + 2.1)),
+            (uint8_t)(127.5 + 127.5 * sin(a + 4.2)),
+        };
+    }
+}
+
+static uint8_t plasma(int x, int y, int t, int width, int height)
+{
+    double u = x * 8.0 / width, v = y * 8.0 / height;
+    double s = sin(u + t * 0.4) + sin(v * 0.7 + t * 0.3) + sin((u + v) * 0.5 + t * 0.2);
+    return (uint8_t)((s + 3) * 255 / 6);
+}
+
+// Full frames, or (patches) one full frame then a small square per frame
+// drawn over the previous one, the rest transparent.
+static out_t make_animation(uint16_t width, uint16_t height, bool patches)
+{
+    pixel_color_t pal[256];
+    plasma_palette(pal);
+    out_t o = { 0 };
+    gif_begin(&o, width, height, pal);
+    uint8_t *px = malloc((size_t)width * height);
+    for (int t = 0; t < BENCH_FRAMES; t++) {
+        gif_frame_t f = { 0, 0, width, height, 1, -1, 5, false };
+        if (patches && t > 0) {
+            f.width = width / 4;
+            f.height = height / 4;
+            f.left = (t * width / BENCH_FRAMES) % (width - f.width + 1);
+            f.top = (t * height / BENCH_FRAMES) % (height - f.height + 1);
+            f.transparent = 0;
+        }
+        for (int y = 0; y < f.height; y++) {
+            for (int x = 0; x < f.width; x++) {
+                uint8_t c = plasma(f.left + x, f.top + y, t, width, height);
+                if (f.transparent >= 0 && c == 0) c = 1;
+                if (f.transparent >= 0 && ((x ^ y) & 4)) c = 0;
+                px[y * f.width + x] = c;
+            }
+        }
+        gif_add_frame(&o, &f, px);
+    }
+    gif_end(&o);
+    free(px);
+    return o;
+}
+
+static int memory_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    memcpy(dst, (const uint8_t *)ctx + offset, len);
+    return 0;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long sink;
+
+static int run(const char *name, const uint8_t *data, size_t len)
+{
+    gif_source_t src = { memory_read, (void *)data, len };
+    int err = gif_open(&src);
+    if (err < 0) {
+        printf("%-28s error %d\n", name, err);
+        return 1;
+    }
+    gif_info_t info;
+    gif_get_info(&info);
+
+    static pixel_color_t frame[RGB_COUNT];
+    unsigned long frames = 0;
+    double start = now_seconds(), elapsed;
+    do {
+        for (int i = 0; i < BENCH_FRAMES; i++) {
+            err = gif_next_frame(frame);
+            if (err < 0) {
+                printf("%-28s error %d after %lu frames\n", name, err, frames);
+                return 1;
+            }
+            sink += frame[frames % RGB_COUNT].g;
+            frames++;
+        }
+        elapsed = now_seconds() - start;
+    } while (elapsed < BENCH_MIN_TIME);
+
+    double us = elapsed * 1e6 / frames;
+    printf("%-28s %4ux%-4u %8zu %10.1f %8.0f\n", name, info.width, info.height,
+           len, us, 1e6 / us);
+    return 0;
+}
+
+static void header(void)
+{
+    printf("decoding into %dx%d\n%-28s %9s %8s %10s %8s\n", MATRIX_ROWS, MATRIX_COLS,
+           "gif", "size", "bytes", "us/frame", "fps");
+}
+
+int main(int argc, char **argv)
+{
+    int failed = 0;
+    header();
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            FILE *f = fopen(argv[i], "rb");
+            if (!f) {
+                perror(argv[i]);
+                return 1;
+            }
+            out_t o = { 0 };
+            int c;
+            while ((c = fgetc(f)) != EOF) put(&o, c);
+            fclose(f);
+            failed |= run(argv[i], o.data, o.len);
+            free(o.data);
+        }
+    } else {
+        static const uint16_t sizes[][2] = {
+            { 32, 32 }, { 64, 64 }, { 128, 128 }, { 320, 240 }, { 480, 270 }, { 640, 480 },
+        };
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            for (int patches = 0; patches < 2; patches++) {
+                char name[32];
+                snprintf(name, sizeof(name), "plasma %ux%u%s", sizes[i][0], sizes[i][1],
+                         patches ? " patches" : "");
+                out_t o = make_animation(sizes[i][0], sizes[i][1], patches);
+                failed |= run(name, o.data, o.len);
+                free(o.data);
+            }
+        }
+    }
+    printf("(checksum %lu)\n", sink);
+    return failed;
+}
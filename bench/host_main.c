@@ -0,0 +1,28 @@
+// Host entry point for the microbenchmarks in main/bench.c. Built and run
+// once per matrix size by bench/bench.py; prints one JSON object.
+
+#include <stdio.h>
+#include "matrix_state.h"
+#include "effects.h"
+#include "compositor.h"
+#include "bench.h"
+
+static int first = 1;
+
+static void report(const char *name, uint32_t per_iter, uint32_t iters, void *ctx)
+{
+    (void)ctx;
+    printf("%s\n    {\"name\": \"%s\", \"per_iter\": %u, \"iters\": %u}",
+           first ? "" : ",", name, per_iter, iters);
+    first = 0;
+}
+
+int main(void)
+{
+    effects_init();
+    compositor_init();
+    printf("{\"unit\": \"%s\", \"size\": \"%dx%d\", \"results\": [", bench_unit(), MATRIX_COLS, MATRIX_ROWS);
+    bench_run(report, NULL);
+    printf("\n]}\n");
+    return 0;
+}
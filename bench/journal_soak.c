@@ -0,0 +1,152 @@
+// Host soak test for the undo journal (main/journal.c).
+//
+//   cc -O2 -Imain -DMATRIX_ROWS=8 -DMATRIX_COLS=8 -DJOURNAL_BUFFER_SIZE=512
+//      bench/journal_soak.c main/journal.c main/matrix_state.c -lm -o journal_soak
+//   ./journal_soak 20000
+//
+// Runs random strokes (some committed over several writes, as a stroke
+// sent in several /pixel requests is), rectangles, fills, undos and redos
+// against the journal and checks the framebuffer after every step against
+// a model that keeps a full snapshot per step. Steps the journal drops to
+// make room are dropped from the oldest end of the model. Build it with a
+// small JOURNAL_BUFFER_SIZE to exercise eviction and wraparound, and at a
+// few geometries; exits nonzero at the first mismatch.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "journal.h"
+
+#define MAX_STEPS (JOURNAL_BUFFER_SIZE / 14 + 2)   // records are at least 14 bytes
+
+typedef pixel_color_t image_t[MATRIX_ROWS][MATRIX_COLS];
+
+// states[0..depth] are the drawing after each undoable step, oldest first,
+// then the redoable ones up to states[depth + redo].
+static image_t states[MAX_STEPS + 1];
+static int depth = 0;
+static int redo = 0;
+
+static uint32_t seed = 1;
+
+static uint32_t next_random(void)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+// Few colours, so strokes often cross pixels that already have theirs.
+static pixel_color_t random_color(void)
+{
+    static const pixel_color_t colors[] = {
+        { 0, 0, 0 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 }, { 255, 255, 255 },
+    };
+    return colors[next_random() % (sizeof(colors) / sizeof(colors[0]))];
+}
+
+static void stroke(void)
+{
+    pixel_color_t c = random_color();
+    int row = next_random() % MATRIX_ROWS, col = next_random() % MATRIX_COLS;
+    for (int n = next_random() % 12; n >= 0; n--) {
+        framebuffer[row][col] = c;
+        row = (row + MATRIX_ROWS + (int)(next_random() % 3) - 1) % MATRIX_ROWS;
+        col = (col + MATRIX_COLS + (int)(next_random() % 3) - 1) % MATRIX_COLS;
+    }
+}
+
+static void rect(void)
+{
+    pixel_color_t c = random_color();
+    int row = next_random() % MATRIX_ROWS, col = next_random() % MATRIX_COLS;
+    int rows = 1 + next_random() % (MATRIX_ROWS - row), cols = 1 + next_random() % (MATRIX_COLS - col);
+    for (int r = row; r < row + rows; r++) {
+        for (int k = col; k < col + cols; k++) framebuffer[r][k] = c;
+    }
+}
+
+static void fill(void)
+{
+    pixel_color_t c = random_color();
+    for (int i = 0; i < RGB_COUNT; i++) framebuffer[i / MATRIX_COLS][i % MATRIX_COLS] = c;
+}
+
+static void fail(unsigned long step, const char *what)
+{
+    printf("step %lu: %s (depth %d, redo %d)\n", step, what, depth, redo);
+    exit(1);
+}
+
+static void check(unsigned long step, const image_t expect)
+{
+    if (memcmp(framebuffer, expect, sizeof(image_t)) != 0) fail(step, "framebuffer differs from model");
+    journal_stats_t stats;
+    journal_get_stats(&stats);
+    if ((int)stats.undo_steps != depth || (int)stats.redo_steps != redo) fail(step, "step counts differ");
+}
+
+static void commit(unsigned long step)
+{
+    bool changed = memcmp(framebuffer, states[depth], sizeof(image_t)) != 0;
+    journal_commit();
+    if (!changed) return;
+    redo = 0;
+    if (depth == MAX_STEPS) fail(step, "more steps than records fit");
+    memcpy(states[++depth], framebuffer, sizeof(image_t));
+
+    // Mirror whatever the journal dropped to make room.
+    journal_stats_t stats;
+    journal_get_stats(&stats);
+    int keep = stats.undo_steps;
+    if (keep > depth) fail(step, "journal kept steps the model never had");
+    memmove(states[0], states[depth - keep], (keep + 1) * sizeof(image_t));
+    depth = keep;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long steps = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000;
+    unsigned long undos = 0, redos = 0, grouped = 0;
+    journal_stats_t stats;
+    for (unsigned long step = 0; step < steps; step++) {
+        uint32_t op = next_random() % 16;
+        if (op < 5) {
+            stroke();
+            commit(step);
+        } else if (op < 7) {
+            // One stroke over several requests, committed by the last.
+            for (int n = 1 + next_random() % 4; n > 0; n--) stroke();
+            commit(step);
+            grouped++;
+        } else if (op < 9) {
+            rect();
+            commit(step);
+        } else if (op < 10) {
+            fill();
+            commit(step);
+        } else if (op < 14) {
+            int pixels = journal_undo();
+            if ((pixels < 0) != (depth == 0)) fail(step, "undo availability differs");
+            if (pixels >= 0) {
+                depth--;
+                redo++;
+                undos++;
+            }
+        } else {
+            int pixels = journal_redo();
+            if ((pixels < 0) != (redo == 0)) fail(step, "redo availability differs");
+            if (pixels >= 0) {
+                depth++;
+                redo--;
+                redos++;
+            }
+        }
+        check(step, states[depth]);
+    }
+    journal_get_stats(&stats);
+    printf("%dx%d, %u byte ring: %lu steps ok (%lu undos, %lu redos, %lu grouped strokes, "
+           "%lu steps dropped)\n", MATRIX_ROWS, MATRIX_COLS, (unsigned)JOURNAL_BUFFER_SIZE, steps,
+           undos, redos, grouped, (unsigned long)stats.dropped);
+    return 0;
+}
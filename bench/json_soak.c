@@ -0,0 +1,282 @@
+// Host soak test for the per-request JSON arena (main/json_arena.c).
+//
+//   CJSON=$IDF_PATH/components/json/cJSON
+//   cc -O2 -Imain -I$CJSON bench/json_soak.c main/pixel_json.c main/draw.c
+//      main/batch.c main/tween.c main/matrix_state.c $CJSON/cJSON.c -lm -o json_soak
+//   ./json_soak 2000000
+//
+// Replays a mix of the web server's JSON requests (colour, mode and
+// brightness bodies, batches, /stats and /pixels replies) against a model
+// heap, once with cJSON allocating straight from it and once through the
+// arenas, and prints the largest free block as the run goes on. Long-lived
+// allocations come and go between requests, as client entries and socket
+// buffers do on the panel, so scattered JSON nodes can pin holes between
+// them.
+//
+// The model is a first-fit allocator with coalescing, not the TLSF heap of
+// ESP-IDF, so compare the trend rather than the numbers. Exits nonzero if
+// the arena run's largest free block ends more than FLAT_TOLERANCE below
+// where it was at the first checkpoint; the long-lived churn alone moves
+// it by a few percent between checkpoints.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cJSON.h"
+#include "batch.h"
+#include "pixel_json.h"
+
+#define HEAP_SIZE    (160 * 1024)
+#define CHECKPOINTS  10
+#define LONG_LIVED   64
+#define FLAT_TOLERANCE 0.05
+
+// Heap model. Every block starts with its size and its lower neighbour's
+// size (boundary tags, low bit of size = in use), so frees merge with both
+// neighbours in constant time. Free blocks are kept on a list threaded
+// through their payload.
+typedef struct block {
+    uint32_t size;
+    uint32_t prev_size;
+    struct block *next_free;
+    struct block *prev_free;
+} block_t;
+
+#define HEADER    8
+#define MIN_BLOCK ((uint32_t)sizeof(block_t))
+
+static _Alignas(8) uint8_t heap[HEAP_SIZE];
+static block_t *free_list;
+static size_t heap_used;
+static unsigned long failed;
+
+static uint32_t block_size(const block_t *b) { return b->size & ~1u; }
+static int block_used(const block_t *b) { return b->size & 1; }
+static block_t *block_next(block_t *b) { return (block_t *)((uint8_t *)b + block_size(b)); }
+static block_t *block_prev(block_t *b) { return (block_t *)((uint8_t *)b - b->prev_size); }
+static int in_heap(const block_t *b) { return (const uint8_t *)b < heap + HEAP_SIZE; }
+
+static void list_remove(block_t *b)
+{
+    if (b->prev_free) b->prev_free->next_free = b->next_free;
+    else free_list = b->next_free;
+    if (b->next_free) b->next_free->prev_free = b->prev_free;
+}
+
+static void list_push(block_t *b)
+{
+    b->prev_free = NULL;
+    b->next_free = free_list;
+    if (free_list) free_list->prev_free = b;
+    free_list = b;
+}
+
+static void set_size(block_t *b, uint32_t size, int used)
+{
+    b->size = size | (used ? 1 : 0);
+    block_t *next = block_next(b);
+    if (in_heap(next)) next->prev_size = size;
+}
+
+static void model_reset(void)
+{
+    block_t *b = (block_t *)heap;
+    b->prev_size = 0;
+    set_size(b, HEAP_SIZE, 0);
+    free_list = NULL;
+    list_push(b);
+    heap_used = 0;
+    failed = 0;
+}
+
+static void *model_malloc(size_t size)
+{
+    uint32_t need = (uint32_t)((size + HEADER + 7) & ~(size_t)7);
+    if (need < MIN_BLOCK) need = MIN_BLOCK;
+    for (block_t *b = free_list; b; b = b->next_free) {
+        uint32_t have = block_size(b);
+        if (have < need) continue;
+        list_remove(b);
+        if (have - need >= MIN_BLOCK) {
+            set_size(b, need, 1);
+            block_t *rest = block_next(b);
+            rest->prev_size = need;
+            set_size(rest, have - need, 0);
+            list_push(rest);
+        } else {
+            set_size(b, have, 1);
+        }
+        heap_used += block_size(b);
+        return (uint8_t *)b + HEADER;
+    }
+    failed++;
+    return NULL;
+}
+
+static void model_free(void *p)
+{
+    if (!p) return;
+    block_t *b = (block_t *)((uint8_t *)p - HEADER);
+    uint32_t size = block_size(b);
+    heap_used -= size;
+    block_t *next = block_next(b);
+    if (in_heap(next) && !block_used(next)) {
+        list_remove(next);
+        size += block_size(next);
+    }
+    if (b->prev_size && !block_used(block_prev(b))) {
+        b = block_prev(b);
+        list_remove(b);
+        size += block_size(b);
+    }
+    set_size(b, size, 0);
+    list_push(b);
+}
+
+static size_t largest_free(void)
+{
+    size_t largest = 0;
+    for (block_t *b = free_list; b; b = b->next_free) {
+        if (block_size(b) > largest) largest = block_size(b);
+    }
+    return largest > HEADER ? largest - HEADER : 0;
+}
+
+// The arena under test, with its fallback pointed at the model.
+#define JSON_ARENA_MALLOC model_malloc
+#define JSON_ARENA_FREE   model_free
+#include "json_arena.c"
+
+static const char *const bodies[] = {
+    "{\"brightness\":40,\"transition\":250}",
+    "{\"mode\":\"plasma\",\"transition\":400,\"easing\":\"in_out\"}",
+    "{\"r\":255,\"g\":64,\"b\":0,\"transition\":250}",
+    "{\"speed\":96,\"scale\":40}",
+};
+
+static const char batch_body[] =
+    "{\"commands\":[{\"cmd\":\"mode\",\"mode\":\"gradient\"},"
+    "{\"cmd\":\"primarycolor\",\"r\":255,\"g\":0,\"b\":0},"
+    "{\"cmd\":\"pixel\",\"updates\":[{\"row\":1,\"col\":2,\"r\":9,\"g\":9,\"b\":9},"
+    "{\"row\":3,\"col\":4,\"r\":9,\"g\":9,\"b\":9}]}]}";
+
+static unsigned long sink;
+
+// A /stats-sized reply: nested objects and a client list.
+static void build_stats(unsigned n)
+{
+    cJSON *root = cJSON_CreateObject();
+    const char *sections[] = { "async", "output", "heap", "json_arena", "journal", "frame_cache" };
+    for (int s = 0; s < 6; s++) {
+        cJSON *obj = cJSON_AddObjectToObject(root, sections[s]);
+        for (int k = 0; k < 6; k++) {
+            char key[12];
+            snprintf(key, sizeof(key), "field%d", k);
+            cJSON_AddNumberToObject(obj, key, n * (k + 1));
+        }
+    }
+    cJSON *clients = cJSON_AddArrayToObject(root, "clients");
+    for (unsigned c = 0; c < 1 + n % 4; c++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "addr", "192.168.4.2");
+        cJSON_AddNumberToObject(item, "requests", n);
+        cJSON_AddNumberToObject(item, "bytes_per_s", n / 3.0);
+        cJSON_AddItemToArray(clients, item);
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    sink += json ? strlen(json) : 0;
+    cJSON_free(json);
+    cJSON_Delete(root);
+}
+
+static void request(unsigned n)
+{
+    // The body buffer recv_body() holds for the length of the request.
+    void *body = model_malloc(64 + n % 200);
+    unsigned kind = n % 40;
+    if (kind < 30) {
+        cJSON *root = cJSON_Parse(bodies[n % 4]);
+        sink += cJSON_GetObjectItem(root, "transition") != NULL;
+        cJSON_Delete(root);
+    } else if (kind < 35) {
+        static batch_t batch;
+        char error[48];
+        cJSON *root = cJSON_Parse(batch_body);
+        sink += batch_parse(root, &batch, error, sizeof(error)) == 0;
+        cJSON_Delete(root);
+    } else if (kind < 39) {
+        build_stats(n);
+    } else {
+        char *json = pixel_json_serialize();
+        sink += json ? strlen(json) : 0;
+        cJSON_free(json);
+    }
+    model_free(body);
+}
+
+// Returns how far the largest free block fell from the first checkpoint
+// to the last, as a fraction of the first.
+static double soak(const char *name, int use_arena, unsigned long requests)
+{
+    static void *long_lived[LONG_LIVED];
+    memset(long_lived, 0, sizeof(long_lived));
+    model_reset();
+    srand(1);
+    if (use_arena) {
+        json_arena_init();
+    } else {
+        cJSON_Hooks hooks = { .malloc_fn = model_malloc, .free_fn = model_free };
+        cJSON_InitHooks(&hooks);
+    }
+
+    size_t first = 0, last = 0;
+    printf("%s\n%12s %10s %10s %8s\n", name, "requests", "free", "largest", "frag%");
+    for (unsigned long n = 1; n <= requests; n++) {
+        if (use_arena) json_arena_begin();
+        request(n);
+        if (use_arena) json_arena_end();
+
+        if (rand() % 8 == 0) {
+            int slot = rand() % LONG_LIVED;
+            model_free(long_lived[slot]);
+            long_lived[slot] = model_malloc(32 + rand() % 480);
+        }
+        if (n % (requests / CHECKPOINTS) == 0) {
+            size_t free_bytes = HEAP_SIZE - heap_used;
+            size_t largest = largest_free();
+            printf("%12lu %10zu %10zu %8.1f\n", n, free_bytes, largest,
+                   100.0 - largest * 100.0 / free_bytes);
+            if (!first) first = largest;
+            last = largest;
+        }
+    }
+    for (int i = 0; i < LONG_LIVED; i++) {
+        model_free(long_lived[i]);
+    }
+    if (use_arena) {
+        json_arena_stats_t stats;
+        json_arena_get_stats(&stats);
+        printf("arena high water %u of %u bytes, %u allocations overflowed\n",
+               stats.high_water, stats.arena_size, stats.overflow);
+    }
+    printf("failed allocations: %lu\n\n", failed);
+    return first > last ? (double)(first - last) / first : 0;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long requests = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+    if (requests < CHECKPOINTS) requests = CHECKPOINTS;
+    for (int i = 0; i < RGB_COUNT; i++) {
+        framebuffer[i / MATRIX_COLS][i % MATRIX_COLS] = (pixel_color_t){ i, i * 3, i * 7 };
+    }
+    soak("malloc", 0, requests);
+    double drop = soak("arena", 1, requests);
+    printf("(checksum %lu)\n", sink);
+    if (drop > FLAT_TOLERANCE) {
+        printf("arena: largest free block fell %.1f%%, more than %.0f%%\n",
+               drop * 100, FLAT_TOLERANCE * 100);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+// Host benchmark for the bitboard cellular automata (main/life.c).
+//
+//   cc -O2 -Imain -DMATRIX_ROWS=64 -DMATRIX_COLS=64 bench/life_bench.c
+//      main/life.c main/matrix_state.c main/noise.c -lm -o life_bench
+//   ./life_bench
+//
+// Prints generations per second for each rule at the compiled geometry
+// (8x8 by default), both for the bitboard step alone and for a full frame
+// (step, cycle check, ages and colour mapping) as the display mode runs it.
+
+#include <stdio.h>
+#include <time.h>
+#include "life.h"
+#include "noise.h"
+
+#define BENCH_GENERATIONS 200000
+#define BENCH_FRAMES      20000
+
+static const char *const rule_names[LIFE_RULE_COUNT] = {
+    [LIFE_RULE_LIFE] = "life",
+    [LIFE_RULE_HIGHLIFE] = "highlife",
+    [LIFE_RULE_BRAIN] = "brain",
+};
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(void)
+{
+    static life_board_t board;
+    static pixel_color_t frame[RGB_COUNT];
+    unsigned checksum = 0;
+
+    life_init();
+    printf("%dx%d (%d tiles)\n", MATRIX_COLS, MATRIX_ROWS, LIFE_TILES);
+    printf("%-10s %16s %16s\n", "rule", "step gens/s", "frame gens/s");
+    for (int rule = 0; rule < LIFE_RULE_COUNT; rule++) {
+        prng_seed(1);
+        life_seed_random(&board, 35);
+        double start = now_seconds();
+        for (int g = 0; g < BENCH_GENERATIONS; g++) {
+            life_step(&board, rule);
+            checksum += (unsigned)board.alive[0];
+        }
+        double step_rate = BENCH_GENERATIONS / (now_seconds() - start);
+
+        prng_seed(1);
+        life_seed_random(&board, 35);
+        start = now_seconds();
+        for (int f = 0; f < BENCH_FRAMES; f++) {
+            life_step(&board, rule);
+            if (life_population(&board) == 0 || life_check_cycle(&board)) {
+                life_seed_random(&board, 35);
+            }
+            life_update_ages(&board);
+            life_render(&board, frame);
+            checksum += frame[f % RGB_COUNT].r;
+        }
+        double frame_rate = BENCH_FRAMES / (now_seconds() - start);
+        printf("%-10s %16.0f %16.0f\n", rule_names[rule], step_rate, frame_rate);
+    }
+    printf("(checksum %u)\n", checksum);
+    return 0;
+}
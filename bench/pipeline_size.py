@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""Compare the code size of the C output path and the C++ pixel pipeline.
+
+Compiles main/calibration.c (calibration_apply, the C path) and
+main/pixel_pipeline.cpp (one instantiation per colour stage) for each
+matrix size and prints the size of every function in them:
+
+    bench/pipeline_size.py
+    bench/pipeline_size.py --cc xtensa-esp32s3-elf-gcc --nm xtensa-esp32s3-elf-nm
+
+Cycle counts for the same paths are the output/* cases of bench/bench.py.
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+MAIN = os.path.join(ROOT, "main")
+SOURCES = ["calibration.c", "pixel_pipeline.cpp"]
+
+
+def symbol_sizes(obj, nm):
+    out = subprocess.run([nm, "-S", "-C", "--size-sort", obj], check=True,
+                         capture_output=True, text=True).stdout
+    sizes = {}
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) == 4 and parts[2] in "tTW":
+            name = parts[3].split("(")[0].replace("pixel_pipeline::", "")
+            sizes[name.replace("void ", "")] = int(parts[1], 16)
+    return sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"))
+    parser.add_argument("--nm", default="nm")
+    parser.add_argument("--opt", default="-Os", help="optimisation flag (ESP-IDF builds with -Os)")
+    parser.add_argument("--sizes", default="8,16,32")
+    args = parser.parse_args()
+
+    print("%-8s %-56s %8s" % ("size", "function", "bytes"))
+    with tempfile.TemporaryDirectory() as workdir:
+        for size in args.sizes.split(","):
+            for src in SOURCES:
+                obj = os.path.join(workdir, src + ".o")
+                subprocess.run([args.cc, args.opt, "-c", "-I", MAIN,
+                                "-DMATRIX_ROWS=%s" % size, "-DMATRIX_COLS=%s" % size,
+                                "-o", obj, os.path.join(MAIN, src)], check=True)
+                for name, n in sorted(symbol_sizes(obj, args.nm).items()):
+                    print("%-8s %-56s %8d" % ("%sx%s" % (size, size), name, n))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
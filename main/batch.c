@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <string.h>
+#include "tween.h"
+#include "batch.h"
+
+static bool get_int(const cJSON *obj, const char *key, int min, int max, int *out)
+{
+    const cJSON *item = cJSON_GetObjectItem(obj, key);
+    if (!cJSON_IsNumber(item) || item->valueint < min || item->valueint > max) return false;
+    *out = item->valueint;
+    return true;
+}
+
+static bool get_color(const cJSON *obj, pixel_color_t *color)
+{
+    int r, g, b;
+    if (!get_int(obj, "r", 0, 255, &r) || !get_int(obj, "g", 0, 255, &g) ||
+        !get_int(obj, "b", 0, 255, &b)) {
+        return false;
+    }
+    *color = (pixel_color_t){ r, g, b };
+    return true;
+}
+
+static bool parse_transition(const cJSON *obj, batch_cmd_t *cmd)
+{
+    const cJSON *transition = cJSON_GetObjectItem(obj, "transition");
+    const cJSON *ease = cJSON_GetObjectItem(obj, "easing");
+    cmd->transition_ms = BATCH_DEFAULT_TRANSITION;
+    cmd->easing = EASE_IN_OUT;
+    if (transition) {
+        if (!cJSON_IsNumber(transition) || transition->valueint < 0) return false;
+        cmd->transition_ms = transition->valueint;
+    }
+    if (ease) {
+        int e = cJSON_IsString(ease) ? easing_from_name(ease->valuestring) : -1;
+        if (e < 0) return false;
+        cmd->easing = e;
+    }
+    return true;
+}
+
+static bool parse_pixels(const cJSON *obj, batch_t *batch, batch_cmd_t *cmd)
+{
+    const cJSON *fill = cJSON_GetObjectItem(obj, "fill");
+    if (cJSON_IsString(fill) && strcmp(fill->valuestring, "yes") == 0) {
+        cmd->op = BATCH_FILL;
+        return get_color(obj, &cmd->color);
+    }
+
+    const cJSON *updates = cJSON_GetObjectItem(obj, "updates");
+    if (!cJSON_IsArray(updates)) return false;
+    cmd->op = BATCH_PIXELS;
+    cmd->pixels.first = batch->pixel_count;
+    cmd->pixels.count = 0;
+    const cJSON *update;
+    cJSON_ArrayForEach(update, updates) {
+        if (batch->pixel_count >= BATCH_MAX_PIXELS) return false;
+        batch_pixel_t *px = &batch->pixels[batch->pixel_count];
+        int row, col;
+        if (!get_int(update, "row", 0, MATRIX_ROWS - 1, &row) ||
+            !get_int(update, "col", 0, MATRIX_COLS - 1, &col) ||
+            !get_color(update, &px->color)) {
+            return false;
+        }
+        px->row = row;
+        px->col = col;
+        batch->pixel_count++;
+        cmd->pixels.count++;
+    }
+    return true;
+}
+
+static bool parse_command(const cJSON *obj, batch_t *batch, batch_cmd_t *cmd)
+{
+    const cJSON *name = cJSON_GetObjectItem(obj, "cmd");
+    if (!cJSON_IsString(name) || !parse_transition(obj, cmd)) return false;
+    const char *op = name->valuestring;
+
+    if (strcmp(op, "mode") == 0) {
+        const cJSON *mode = cJSON_GetObjectItem(obj, "mode");
+        int m = cJSON_IsString(mode) ? mode_from_name(mode->valuestring) : -1;
+        cmd->op = BATCH_MODE;
+        cmd->mode = m;
+        return m >= 0;
+    }
+    if (strcmp(op, "primarycolor") == 0) {
+        cmd->op = BATCH_PRIMARY;
+        return get_color(obj, &cmd->color);
+    }
+    if (strcmp(op, "secondarycolor") == 0) {
+        cmd->op = BATCH_SECONDARY;
+        return get_color(obj, &cmd->color);
+    }
+    if (strcmp(op, "brightness") == 0) {
+        int percent;
+        if (!get_int(obj, "brightness", 0, 100, &percent)) return false;
+        cmd->op = BATCH_BRIGHTNESS;
+        cmd->brightness = (percent * 63) / 100;     // same scale as /brightness
+        return true;
+    }
+    if (strcmp(op, "params") == 0) {
+        int v;
+        cmd->op = BATCH_PARAMS;
+        cmd->params.speed = get_int(obj, "speed", 0, 255, &v) ? v : -1;
+        cmd->params.scale = get_int(obj, "scale", 0, 255, &v) ? v : -1;
+        return cmd->params.speed >= 0 || cmd->params.scale >= 0;
+    }
+    if (strcmp(op, "pixel") == 0) {
+        return parse_pixels(obj, batch, cmd);
+    }
+    return false;
+}
+
+int batch_parse(const cJSON *root, batch_t *batch, char *error, size_t error_len)
+{
+    batch->count = 0;
+    batch->pixel_count = 0;
+    const cJSON *commands = cJSON_GetObjectItem(root, "commands");
+    if (!cJSON_IsArray(commands)) {
+        snprintf(error, error_len, "Missing commands");
+        return -1;
+    }
+    const cJSON *obj;
+    cJSON_ArrayForEach(obj, commands) {
+        if (batch->count >= BATCH_MAX_COMMANDS) {
+            snprintf(error, error_len, "More than %d commands", BATCH_MAX_COMMANDS);
+            return -1;
+        }
+        if (!parse_command(obj, batch, &batch->cmds[batch->count])) {
+            snprintf(error, error_len, "Bad command %d", batch->count);
+            return -1;
+        }
+        batch->count++;
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "cJSON.h"
+#include "matrix_state.h"
+
+// Several settings changed in one request (POST /batch or a /ws message),
+// applied together at one frame boundary:
+//   {"commands": [
+//       {"cmd": "mode", "mode": "rainbow"},
+//       {"cmd": "primarycolor", "r": 255, "g": 0, "b": 0},
+//       {"cmd": "secondarycolor", "r": 0, "g": 0, "b": 255},
+//       {"cmd": "brightness", "brightness": 40},
+//       {"cmd": "params", "speed": 64, "scale": 64},
+//       {"cmd": "pixel", "updates": [{"row", "col", "r", "g", "b"}, ...]},
+//       {"cmd": "pixel", "fill": "yes", "r": 0, "g": 0, "b": 0}
+//   ]}
+// Each command takes the same fields, "transition" and "easing" included,
+// as the endpoint of the same name. Unlike those endpoints, anything
+// missing or out of range rejects the whole batch.
+#define BATCH_MAX_COMMANDS 16
+#define BATCH_MAX_PIXELS   RGB_COUNT
+#define BATCH_MAX_BODY     (1024 + BATCH_MAX_PIXELS * 48)
+
+// transition_ms when the command gave none: the endpoint's own default.
+#define BATCH_DEFAULT_TRANSITION UINT32_MAX
+
+typedef enum {
+    BATCH_MODE = 0,
+    BATCH_PRIMARY,
+    BATCH_SECONDARY,
+    BATCH_BRIGHTNESS,
+    BATCH_PARAMS,
+    BATCH_PIXELS,
+    BATCH_FILL
+} batch_op_t;
+
+typedef struct {
+    uint8_t op;                 // batch_op_t
+    uint8_t easing;             // easing_t
+    uint32_t transition_ms;
+    union {
+        uint8_t mode;           // display_mode_t
+        pixel_color_t color;    // PRIMARY, SECONDARY, FILL
+        uint8_t brightness;     // in current_brightness units
+        struct {
+            int16_t speed;      // -1 leaves it alone
+            int16_t scale;
+        } params;
+        struct {
+            uint16_t first;     // range of batch_t.pixels
+            uint16_t count;
+        } pixels;
+    };
+} batch_cmd_t;
+
+typedef struct {
+    uint8_t row;
+    uint8_t col;
+    pixel_color_t color;
+} batch_pixel_t;
+
+typedef struct {
+    int count;
+    batch_cmd_t cmds[BATCH_MAX_COMMANDS];
+    int pixel_count;
+    batch_pixel_t pixels[BATCH_MAX_PIXELS];
+} batch_t;
+
+// Validates and decodes a whole batch without applying any of it. Returns
+// 0, or -1 with a description of the first bad command in error.
+int batch_parse(const cJSON *root, batch_t *batch, char *error, size_t error_len);
+
+#endif // BATCH_H
@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "matrix_state.h"
+#include "effects.h"
+#include "frame_cache.h"
+#include "expr_vm.h"
+#include "compositor.h"
+#include "calibration.h"
+#include "pixel_pipeline.h"
+#include "life.h"
+#include "bench.h"
+#ifndef BENCH_NO_CJSON
+#include "pixel_json.h"
+#endif
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+
+static inline uint32_t bench_now(void) { return esp_cpu_get_cycle_count(); }
+const char *bench_unit(void) { return "cycles"; }
+#else
+#include <time.h>
+
+static inline uint32_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+const char *bench_unit(void) { return "ns"; }
+#endif
+
+// Roughly this many pixels are touched per benchmark round, whatever the matrix
+// size, so every case runs for a similar time (and well inside the 32-bit
+// cycle counter's wrap on target).
+#define BENCH_PIXEL_BUDGET (64 * 1024)
+
+static uint32_t iterations(void)
+{
+    uint32_t n = BENCH_PIXEL_BUDGET / RGB_COUNT;
+    return n < 4 ? 4 : n;
+}
+
+// Each case is timed this many times and the fastest round is reported,
+// which filters out interrupts, Wi-Fi activity and host scheduler noise.
+#define BENCH_ROUNDS 5
+
+#define BENCH_TIME(best, n, body) do {                          \
+        (best) = UINT32_MAX;                                    \
+        for (int round_ = 0; round_ < BENCH_ROUNDS; round_++) { \
+            uint32_t start_ = bench_now();                      \
+            for (uint32_t i = 0; i < (n); i++) { body; }        \
+            uint32_t elapsed_ = bench_now() - start_;           \
+            if (elapsed_ < (best)) (best) = elapsed_;           \
+        }                                                       \
+    } while (0)
+
+// Keeps results observable so the compiler cannot drop the work.
+static volatile uint32_t bench_sink;
+
+static void bench_colour(bench_report_fn report, void *ctx)
+{
+    const uint32_t n = BENCH_PIXEL_BUDGET;
+    uint8_t r, g, b;
+    uint32_t acc = 0, best;
+
+    BENCH_TIME(best, n, {
+        hsv2rgb((float)(i % 360), 1.0f, 1.0f, &r, &g, &b);
+        acc += r + g + b;
+    });
+    report("colour/hsv2rgb", best / n, n, ctx);
+
+    BENCH_TIME(best, n, acc += scale_brightness((uint8_t)i));
+    report("colour/scale_brightness", best / n, n, ctx);
+    bench_sink = acc;
+}
+
+static void bench_effects(bench_report_fn report, void *ctx)
+{
+    static pixel_color_t frame[RGB_COUNT];
+    expr_program_t prog;
+    char err[64];
+    expr_compile("hsv(t*0.1 + x/8, 1, 1)", &prog, err, sizeof(err));
+
+    effect_ctx_t effect_ctx = { .time_ms = 0, .expr = &prog, .speed = 64, .scale = 64 };
+    const uint32_t n = iterations();
+
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        // Plays whatever is stored, and the player belongs to the render
+        // task; bench/gif_bench.c times decoding instead.
+        if (mode == MODE_GIF) continue;
+        // The life modes only step once a generation is due, so their
+        // clock keeps moving on by a generation per render, across rounds.
+        bool life = mode == MODE_LIFE || mode == MODE_HIGHLIFE || mode == MODE_BRAIN;
+        uint32_t best;
+        BENCH_TIME(best, n, {
+            effect_ctx.time_ms = life ? effect_ctx.time_ms + LIFE_FRAME_MS : i * 16;
+            effects_render(mode, &effect_ctx, frame);
+        });
+        bench_sink = frame[RGB_COUNT / 2].r;
+
+        char name[32];
+        snprintf(name, sizeof(name), "render/%s", mode_name(mode));
+        report(name, best / n, n, ctx);
+    }
+
+    // The periodic modes again through the frame cache. The first round
+    // fills it; the fastest round is all replays.
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        effect_key_t key;
+        uint32_t phase;
+        if (effects_period(mode, &key, &phase) == 0) continue;
+        uint32_t best;
+        frame_cache_clear();
+        BENCH_TIME(best, n, frame_cache_render(mode, &effect_ctx, frame));
+        bench_sink = frame[RGB_COUNT / 2].r;
+
+        char name[32];
+        snprintf(name, sizeof(name), "cached/%s", mode_name(mode));
+        report(name, best / n, n, ctx);
+    }
+    frame_cache_clear();
+}
+
+// Full four-layer stack: effect, a half-covered drawing and two overlays
+// with non-trivial blend modes and opacity.
+static void bench_compose(bench_report_fn report, void *ctx)
+{
+    static pixel_color_t out[RGB_COUNT];
+    static const layer_config_t configs[LAYER_COUNT] = {
+        [LAYER_EFFECT] = { .opacity = 255, .blend = BLEND_NORMAL, .visible = true },
+        [LAYER_DRAWING] = { .opacity = 255, .blend = BLEND_NORMAL, .visible = true },
+        [LAYER_OVERLAY0] = { .opacity = 160, .blend = BLEND_SCREEN, .visible = true },
+        [LAYER_OVERLAY1] = { .opacity = 255, .blend = BLEND_MULTIPLY, .visible = true },
+    };
+    // The live layers are borrowed, as bench_run does with the framebuffer.
+    static pixel_color_t saved[LAYER_COUNT][RGB_COUNT];
+    layer_config_t saved_configs[LAYER_COUNT];
+    effect_ctx_t effect_ctx = { .time_ms = 0, .expr = NULL, .speed = 64, .scale = 64 };
+
+    for (int id = 0; id < LAYER_COUNT; id++) {
+        pixel_color_t *pixels = compositor_layer(id);
+        memcpy(saved[id], pixels, sizeof(saved[id]));
+        compositor_get_config(id, &saved_configs[id]);
+        effects_render(MODE_RAINBOW, &effect_ctx, pixels);
+        if (id == LAYER_DRAWING) {
+            memset(pixels, 0, RGB_COUNT / 2 * sizeof(pixel_color_t));
+        }
+        compositor_set_config(id, &configs[id]);
+        compositor_mark_dirty(id);
+    }
+
+    const uint32_t n = iterations();
+    uint32_t best;
+    BENCH_TIME(best, n, {
+        compositor_mark_dirty(LAYER_EFFECT);
+        compositor_compose(out);
+    });
+    bench_sink = out[RGB_COUNT / 2].g;
+    report("compose/4_layers", best / n, n, ctx);
+
+    for (int id = 0; id < LAYER_COUNT; id++) {
+        memcpy(compositor_layer(id), saved[id], sizeof(saved[id]));
+        compositor_set_config(id, &saved_configs[id]);
+        compositor_mark_dirty(id);
+    }
+}
+
+// Output scaling: brightness alone (no calibration) against per-channel
+// gains and full 3x3 matrices with brightness folded in. Each is timed in
+// the plain C version and in the templated pipeline output_frame uses,
+// which also produces the wire bytes.
+static void bench_output(bench_report_fn report, void *ctx)
+{
+    static pixel_color_t in[RGB_COUNT], out[RGB_COUNT];
+    static uint8_t wire[PIXEL_PIPELINE_BYTES];
+    static uint8_t body[CALIB_MAX_BODY];
+    static calibration_t cal;
+    for (int i = 0; i < RGB_COUNT; i++) {
+        in[i] = (pixel_color_t){ (uint8_t)(i * 7), (uint8_t)(i * 13), (uint8_t)(i * 29) };
+    }
+    const uint32_t n = iterations();
+    uint32_t best;
+
+    body[0] = CALIB_NONE;
+    calibration_parse(body, 1, &cal);
+    BENCH_TIME(best, n, { calibration_apply(&cal, in, out, 128); bench_sink = out[0].r; });
+    report("output/brightness", best / n, n, ctx);
+    BENCH_TIME(best, n, { pixel_pipeline_run(in, &cal, 128, out, wire); bench_sink = wire[0]; });
+    report("output/pipeline_brightness", best / n, n, ctx);
+
+    body[0] = CALIB_GAIN;
+    for (int i = 0; i < RGB_COUNT * 3; i++) body[1 + i] = (uint8_t)(200 + i % 56);
+    calibration_parse(body, 1 + RGB_COUNT * 3, &cal);
+    BENCH_TIME(best, n, { calibration_apply(&cal, in, out, 128); bench_sink = out[0].r; });
+    report("output/gain", best / n, n, ctx);
+    BENCH_TIME(best, n, { pixel_pipeline_run(in, &cal, 128, out, wire); bench_sink = wire[0]; });
+    report("output/pipeline_gain", best / n, n, ctx);
+
+    body[0] = CALIB_MATRIX;
+    for (int i = 0; i < RGB_COUNT * 9; i++) {
+        int16_t v = (i % 4 == 0) ? 240 : 8;
+        body[1 + i * 2] = (uint8_t)v;
+        body[2 + i * 2] = (uint8_t)(v >> 8);
+    }
+    calibration_parse(body, CALIB_MAX_BODY, &cal);
+    BENCH_TIME(best, n, { calibration_apply(&cal, in, out, 128); bench_sink = out[0].r; });
+    report("output/matrix", best / n, n, ctx);
+    BENCH_TIME(best, n, { pixel_pipeline_run(in, &cal, 128, out, wire); bench_sink = wire[0]; });
+    report("output/pipeline_matrix", best / n, n, ctx);
+}
+
+#ifndef BENCH_NO_CJSON
+// Builds a /pixel body with `count` updates, like the UI sends.
+static char *make_pixel_body(int count)
+{
+    size_t cap = 32 + count * 48;
+    char *body = malloc(cap);
+    if (!body) return NULL;
+    size_t len = snprintf(body, cap, "{\"updates\":[");
+    for (int i = 0; i < count; i++) {
+        len += snprintf(body + len, cap - len, "%s{\"row\":%d,\"col\":%d,\"r\":%d,\"g\":%d,\"b\":%d}",
+                        i ? "," : "", (i / MATRIX_COLS) % MATRIX_ROWS, i % MATRIX_COLS,
+                        i & 0xff, (i * 7) & 0xff, (i * 13) & 0xff);
+    }
+    snprintf(body + len, cap - len, "]}");
+    return body;
+}
+
+static void bench_pixel_parse(const char *name, int count, bench_report_fn report, void *ctx)
+{
+    char *body = make_pixel_body(count);
+    if (!body) return;
+    size_t len = strlen(body);
+    uint32_t n = BENCH_PIXEL_BUDGET / (count * 4);
+    if (n < 4) n = 4;
+
+    uint32_t best;
+    BENCH_TIME(best, n, {
+        cJSON *root = cJSON_ParseWithLength(body, len);
+        pixel_json_apply(root);
+        cJSON_Delete(root);
+    });
+    report(name, best / n, n, ctx);
+    free(body);
+}
+
+static void bench_json(bench_report_fn report, void *ctx)
+{
+    bench_pixel_parse("json/pixel_parse_batch3", 3, report, ctx);
+    bench_pixel_parse("json/pixel_parse_frame", RGB_COUNT, report, ctx);
+
+    uint32_t n = iterations() / 4;
+    if (n < 4) n = 4;
+    uint32_t best;
+    BENCH_TIME(best, n, {
+        char *json = pixel_json_serialize();
+        bench_sink = json ? (uint8_t)json[1] : 0;
+        cJSON_free(json);
+    });
+    report("json/pixels_serialize", best / n, n, ctx);
+}
+#endif
+
+void bench_run(bench_report_fn report, void *ctx)
+{
+    // The protocol benchmarks write into the live framebuffer.
+    static pixel_color_t saved[MATRIX_ROWS][MATRIX_COLS];
+    memcpy(saved, framebuffer, sizeof(saved));
+    uint8_t saved_offset = palette_offset;
+
+    bench_colour(report, ctx);
+    bench_effects(report, ctx);
+    bench_compose(report, ctx);
+    bench_output(report, ctx);
+#ifndef BENCH_NO_CJSON
+    bench_json(report, ctx);
+#endif
+
+    memcpy(framebuffer, saved, sizeof(saved));
+    palette_offset = saved_offset;
+}
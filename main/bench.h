@@ -0,0 +1,15 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// Microbenchmarks for the render and protocol hot paths. The same code runs
+// on the device (GET /bench, timed in CPU cycles) and on the host
+// (bench/bench.py, timed in nanoseconds, once per matrix size).
+
+typedef void (*bench_report_fn)(const char *name, uint32_t per_iter, uint32_t iters, void *ctx);
+
+const char *bench_unit(void);
+void bench_run(bench_report_fn report, void *ctx);
+
+#endif // BENCH_H
@@ -0,0 +1,149 @@
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "calibration.h"
+
+#define CALIB_Q8_ONE   256
+#define CALIB_Q8_LIMIT 512
+
+static bool is_identity(const calibration_t *cal)
+{
+    for (int i = 0; i < RGB_COUNT; i++) {
+        for (int k = 0; k < 9; k++) {
+            int expected = (k % 4 == 0) ? CALIB_Q8_ONE : 0;
+            if (cal->coef[i][k] != expected) return false;
+        }
+    }
+    return true;
+}
+
+int calibration_parse(const uint8_t *body, size_t len, calibration_t *cal)
+{
+    if (len < 1) return -1;
+    const uint8_t *data = body + 1;
+    memset(cal->coef, 0, sizeof(cal->coef));
+    cal->format = body[0];
+    cal->fused_brightness = -1;
+
+    switch (body[0]) {
+        case CALIB_NONE:
+            if (len != 1) return -1;
+            return 0;
+        case CALIB_GAIN:
+            if (len != 1 + RGB_COUNT * 3) return -1;
+            for (int i = 0; i < RGB_COUNT; i++) {
+                for (int c = 0; c < 3; c++) {
+                    cal->coef[i][c * 4] = (data[i * 3 + c] * CALIB_Q8_ONE + 127) / 255;
+                }
+            }
+            break;
+        case CALIB_MATRIX:
+            if (len != 1 + RGB_COUNT * 9 * 2) return -1;
+            for (int i = 0; i < RGB_COUNT; i++) {
+                for (int k = 0; k < 9; k++) {
+                    const uint8_t *p = data + (i * 9 + k) * 2;
+                    int16_t v = (int16_t)(p[0] | (p[1] << 8));
+                    if (v < -CALIB_Q8_LIMIT || v > CALIB_Q8_LIMIT) return -1;
+                    cal->coef[i][k] = v;
+                }
+            }
+            break;
+        default:
+            return -1;
+    }
+    if (is_identity(cal)) cal->format = CALIB_NONE;
+    return 0;
+}
+
+// Folds brightness into the table, so output costs one multiply per
+// coefficient rather than two.
+void calibration_prepare(calibration_t *cal, uint8_t brightness)
+{
+    if (cal->fused_brightness == brightness) return;
+    for (int i = 0; i < RGB_COUNT; i++) {
+        if (cal->format == CALIB_GAIN) {
+            for (int c = 0; c < 3; c++) {
+                cal->fused[i][c] = cal->coef[i][c * 4] * brightness * 256 / 255;
+            }
+        } else {
+            for (int k = 0; k < 9; k++) {
+                cal->fused[i][k] = cal->coef[i][k] * brightness * 256 / 255;
+            }
+        }
+    }
+    cal->fused_brightness = brightness;
+}
+
+static inline uint8_t clamp_q16(int32_t v)
+{
+    if (v <= 0) return 0;
+    v >>= 16;
+    return v > 255 ? 255 : (uint8_t)v;
+}
+
+void calibration_apply(calibration_t *cal, const pixel_color_t *frame, pixel_color_t *out, uint8_t brightness)
+{
+    if (cal->format == CALIB_NONE) {
+        for (int i = 0; i < RGB_COUNT; i++) {
+            out[i].r = (frame[i].r * brightness) / 255;
+            out[i].g = (frame[i].g * brightness) / 255;
+            out[i].b = (frame[i].b * brightness) / 255;
+        }
+        return;
+    }
+    calibration_prepare(cal, brightness);
+
+    if (cal->format == CALIB_GAIN) {
+        // Gains never exceed 1.0, so this cannot overflow a channel.
+        for (int i = 0; i < RGB_COUNT; i++) {
+            const int32_t *k = cal->fused[i];
+            out[i].r = (uint8_t)((frame[i].r * k[0]) >> 16);
+            out[i].g = (uint8_t)((frame[i].g * k[1]) >> 16);
+            out[i].b = (uint8_t)((frame[i].b * k[2]) >> 16);
+        }
+        return;
+    }
+    for (int i = 0; i < RGB_COUNT; i++) {
+        const int32_t *k = cal->fused[i];
+        int32_t r = frame[i].r, g = frame[i].g, b = frame[i].b;
+        out[i].r = clamp_q16(k[0] * r + k[1] * g + k[2] * b);
+        out[i].g = clamp_q16(k[3] * r + k[4] * g + k[5] * b);
+        out[i].b = clamp_q16(k[6] * r + k[7] * g + k[8] * b);
+    }
+}
+
+#ifdef ESP_PLATFORM
+#include "nvs.h"
+
+#define CALIB_NVS_NAMESPACE "matrix32"
+
+esp_err_t calibration_save(const uint8_t *body, size_t len)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    err = nvs_set_blob(nvs, "calib", body, len);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
+
+esp_err_t calibration_load(calibration_t *cal)
+{
+    cal->format = CALIB_NONE;
+    nvs_handle_t nvs;
+    if (nvs_open(CALIB_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return ESP_OK;  // nothing stored yet
+    }
+    size_t len = CALIB_MAX_BODY;
+    uint8_t *body = malloc(len);
+    esp_err_t err = body ? nvs_get_blob(nvs, "calib", body, &len) : ESP_ERR_NO_MEM;
+    nvs_close(nvs);
+    if (err == ESP_OK && calibration_parse(body, len, cal) != 0) {
+        cal->format = CALIB_NONE;
+        err = ESP_ERR_INVALID_SIZE;  // stored for a different matrix size
+    }
+    free(body);
+    return err == ESP_ERR_NVS_NOT_FOUND ? ESP_OK : err;
+}
+#endif
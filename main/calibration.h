@@ -0,0 +1,50 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Per-LED colour correction, applied to every frame in the same pass as
+// brightness. Uploaded with POST /calibration as a format byte followed by:
+//   CALIB_NONE    nothing (clears the table)
+//   CALIB_GAIN    RGB_COUNT rgb triplets of channel gains, 255 = unchanged
+//   CALIB_MATRIX  RGB_COUNT 3x3 matrices, row-major, int16 little-endian in
+//                 Q8 (256 = 1.0), -512..512; out = M * in
+typedef enum {
+    CALIB_NONE = 0,
+    CALIB_GAIN,
+    CALIB_MATRIX
+} calib_format_t;
+
+#define CALIB_MAX_BODY (1 + RGB_COUNT * 9 * 2)
+
+typedef struct {
+    uint8_t format;                 // calib_format_t
+    int16_t coef[RGB_COUNT][9];     // Q8, gains on the diagonal
+    // Coefficients with brightness folded in, Q16, rebuilt whenever the
+    // table or the brightness changes. CALIB_GAIN only uses [i][0..2].
+    int32_t fused[RGB_COUNT][9];
+    int16_t fused_brightness;       // -1 = stale
+} calibration_t;
+
+// Decodes an upload. A table that works out to the identity comes back as
+// CALIB_NONE, so it costs nothing at output time. Returns 0 or -1 if the
+// body is malformed.
+int calibration_parse(const uint8_t *body, size_t len, calibration_t *cal);
+
+// Brings cal->fused up to date for this brightness.
+void calibration_prepare(calibration_t *cal, uint8_t brightness);
+
+// Scales frame into out by brightness and the calibration table.
+void calibration_apply(calibration_t *cal, const pixel_color_t *frame, pixel_color_t *out, uint8_t brightness);
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+
+// The last upload is kept in NVS as-is and parsed again at boot.
+esp_err_t calibration_save(const uint8_t *body, size_t len);
+esp_err_t calibration_load(calibration_t *cal);
+#endif
+
+#endif // CALIBRATION_H
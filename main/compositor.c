@@ -0,0 +1,198 @@
+#include <string.h>
+#include "compositor.h"
+
+typedef struct {
+    pixel_color_t pixels[RGB_COUNT];
+    layer_config_t config;
+    volatile bool dirty;    // content or config changed since the last compose
+    int16_t row_min;        // rows holding painted pixels; row_min > row_max
+    int16_t row_max;        // when the layer is empty
+} layer_t;
+
+static layer_t layers[LAYER_COUNT];
+
+static const char *const layer_names[LAYER_COUNT] = {
+    [LAYER_EFFECT] = "effect",
+    [LAYER_DRAWING] = "drawing",
+    [LAYER_OVERLAY0] = "overlay0",
+    [LAYER_OVERLAY1] = "overlay1",
+};
+
+static const char *const blend_names[BLEND_COUNT] = {
+    [BLEND_NORMAL] = "normal",
+    [BLEND_ADD] = "add",
+    [BLEND_MULTIPLY] = "multiply",
+    [BLEND_SCREEN] = "screen",
+};
+
+void compositor_init(void)
+{
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        memset(layers[i].pixels, 0, sizeof(layers[i].pixels));
+        layers[i].config = (layer_config_t){ .opacity = 255, .blend = BLEND_NORMAL, .visible = true };
+        layers[i].row_min = MATRIX_ROWS;
+        layers[i].row_max = -1;
+        layers[i].dirty = true;
+    }
+}
+
+pixel_color_t *compositor_layer(layer_id_t id)
+{
+    return layers[id].pixels;
+}
+
+static inline bool painted(pixel_color_t p)
+{
+    return p.r | p.g | p.b;
+}
+
+void compositor_mark_dirty(layer_id_t id)
+{
+    layer_t *layer = &layers[id];
+    int row_min = MATRIX_ROWS, row_max = -1;
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        const pixel_color_t *p = layer->pixels + row * MATRIX_COLS;
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            if (painted(p[col])) {
+                if (row_min == MATRIX_ROWS) row_min = row;
+                row_max = row;
+                break;
+            }
+        }
+    }
+    layer->row_min = row_min;
+    layer->row_max = row_max;
+    layer->dirty = true;
+}
+
+void compositor_clear(layer_id_t id)
+{
+    memset(layers[id].pixels, 0, sizeof(layers[id].pixels));
+    layers[id].row_min = MATRIX_ROWS;
+    layers[id].row_max = -1;
+    layers[id].dirty = true;
+}
+
+void compositor_get_config(layer_id_t id, layer_config_t *config)
+{
+    *config = layers[id].config;
+}
+
+void compositor_set_config(layer_id_t id, const layer_config_t *config)
+{
+    layers[id].config = *config;
+    layers[id].dirty = true;
+}
+
+// x / 255, rounded, for x in 0..255*255.
+static inline uint8_t div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline uint8_t blend_channel(uint8_t dst, uint8_t src, uint8_t mode, uint8_t opacity)
+{
+    uint32_t out;
+    switch (mode) {
+        case BLEND_ADD:
+            out = dst + src;
+            if (out > 255) out = 255;
+            break;
+        case BLEND_MULTIPLY:
+            out = div255(dst * src);
+            break;
+        case BLEND_SCREEN:
+            out = 255 - div255((255 - dst) * (255 - src));
+            break;
+        default:
+            out = src;
+            break;
+    }
+    if (opacity == 255) return out;
+    return div255(dst * (255 - opacity) + out * opacity);
+}
+
+bool compositor_compose(pixel_color_t *out)
+{
+    // Clear the dirty flags before reading any pixels: a layer written
+    // during the pass is then simply composed again next frame.
+    bool changed = false;
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        if (layers[i].dirty) {
+            layers[i].dirty = false;
+            changed = true;
+        }
+    }
+    if (!changed) return false;
+
+    const layer_t *active[LAYER_COUNT];
+    int active_count = 0;
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        const layer_t *layer = &layers[i];
+        if (layer->config.visible && layer->config.opacity > 0 && layer->row_min <= layer->row_max) {
+            active[active_count++] = layer;
+        }
+    }
+
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        const layer_t *row_layers[LAYER_COUNT];
+        int n = 0;
+        for (int i = 0; i < active_count; i++) {
+            if (row >= active[i]->row_min && row <= active[i]->row_max) {
+                row_layers[n++] = active[i];
+            }
+        }
+
+        pixel_color_t *dst = out + row * MATRIX_COLS;
+        if (n == 0) {
+            memset(dst, 0, MATRIX_COLS * sizeof(pixel_color_t));
+            continue;
+        }
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            int i = row * MATRIX_COLS + col;
+            pixel_color_t c = {0, 0, 0};
+            for (int l = 0; l < n; l++) {
+                pixel_color_t p = row_layers[l]->pixels[i];
+                if (!painted(p)) continue;
+                uint8_t mode = row_layers[l]->config.blend;
+                uint8_t opacity = row_layers[l]->config.opacity;
+                if (mode == BLEND_NORMAL && opacity == 255) {
+                    c = p;
+                    continue;
+                }
+                c.r = blend_channel(c.r, p.r, mode, opacity);
+                c.g = blend_channel(c.g, p.g, mode, opacity);
+                c.b = blend_channel(c.b, p.b, mode, opacity);
+            }
+            dst[col] = c;
+        }
+    }
+    return true;
+}
+
+int layer_from_name(const char *name)
+{
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        if (strcmp(name, layer_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char *layer_name(layer_id_t id)
+{
+    return id < LAYER_COUNT ? layer_names[id] : "unknown";
+}
+
+int blend_from_name(const char *name)
+{
+    for (int i = 0; i < BLEND_COUNT; i++) {
+        if (strcmp(name, blend_names[i]) == 0) return i;
+    }
+    return -1;
+}
+
+const char *blend_name(blend_mode_t mode)
+{
+    return mode < BLEND_COUNT ? blend_names[mode] : "unknown";
+}
@@ -0,0 +1,56 @@
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Layer stack, bottom to top. The effect layer holds the running mode, the
+// drawing layer the framebuffer, and overlays are free for text, badges and
+// the like (drawn with POST /draw?layer=N). Black pixels are transparent in
+// every layer, so a drawing or overlay only covers what it actually paints.
+typedef enum {
+    LAYER_EFFECT = 0,
+    LAYER_DRAWING,
+    LAYER_OVERLAY0,
+    LAYER_OVERLAY1,
+    LAYER_COUNT
+} layer_id_t;
+
+typedef enum {
+    BLEND_NORMAL = 0,
+    BLEND_ADD,
+    BLEND_MULTIPLY,
+    BLEND_SCREEN,
+    BLEND_COUNT
+} blend_mode_t;
+
+typedef struct {
+    uint8_t opacity;    // 0 = invisible, 255 = opaque
+    uint8_t blend;      // blend_mode_t
+    bool visible;
+} layer_config_t;
+
+void compositor_init(void);
+
+// Pixel buffer of a layer, RGB_COUNT entries. Call compositor_mark_dirty
+// after writing to it.
+pixel_color_t *compositor_layer(layer_id_t id);
+void compositor_mark_dirty(layer_id_t id);
+void compositor_clear(layer_id_t id);
+
+void compositor_get_config(layer_id_t id, layer_config_t *config);
+void compositor_set_config(layer_id_t id, const layer_config_t *config);
+
+// Blends every visible layer into out in one pass over the pixels. Layers
+// with zero opacity or nothing painted are skipped, as are the rows a layer
+// does not touch. Returns false, leaving out alone, if no layer changed
+// since the last call.
+bool compositor_compose(pixel_color_t *out);
+
+int layer_from_name(const char *name);
+const char *layer_name(layer_id_t id);
+int blend_from_name(const char *name);
+const char *blend_name(blend_mode_t mode);
+
+#endif // COMPOSITOR_H
@@ -0,0 +1,315 @@
+#include <stdlib.h>
+#include <string.h>
+#include "draw.h"
+
+// Sprites are copied straight into the canvas with memcpy.
+_Static_assert(sizeof(pixel_color_t) == 3, "pixel_color_t must be packed rgb");
+
+void draw_canvas_framebuffer(draw_canvas_t *canvas)
+{
+    canvas->pixels = &framebuffer[0][0];
+    canvas->width = MATRIX_COLS;
+    canvas->height = MATRIX_ROWS;
+}
+
+static inline int same_color(pixel_color_t a, pixel_color_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+// Every primitive ends up here: one clipped horizontal run per call.
+void draw_hspan(const draw_canvas_t *c, int y, int x0, int x1, pixel_color_t color)
+{
+    if (x0 > x1) { int t = x0; x0 = x1; x1 = t; }
+    if (y < 0 || y >= c->height || x1 < 0 || x0 >= c->width) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= c->width) x1 = c->width - 1;
+
+    pixel_color_t *p = c->pixels + y * c->width + x0;
+    for (int n = x1 - x0 + 1; n > 0; n--) {
+        *p++ = color;
+    }
+}
+
+void draw_pixel(const draw_canvas_t *c, int x, int y, pixel_color_t color)
+{
+    if (x < 0 || y < 0 || x >= c->width || y >= c->height) return;
+    c->pixels[y * c->width + x] = color;
+}
+
+// Bresenham, emitting each horizontal run as a single span.
+void draw_line(const draw_canvas_t *c, int x0, int y0, int x1, int y1, pixel_color_t color)
+{
+    int dx = abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    int run_start = x0;
+
+    while (1) {
+        if (x0 == x1 && y0 == y1) {
+            draw_hspan(c, y0, run_start, x0, color);
+            return;
+        }
+        int e2 = 2 * err;
+        int next_x = x0, next_y = y0;
+        if (e2 >= dy) { err += dy; next_x += sx; }
+        if (e2 <= dx) { err += dx; next_y += sy; }
+        if (next_y != y0) {
+            draw_hspan(c, y0, run_start, x0, color);
+            run_start = next_x;
+        }
+        x0 = next_x;
+        y0 = next_y;
+    }
+}
+
+void draw_fill_rect(const draw_canvas_t *c, int x, int y, int w, int h, pixel_color_t color)
+{
+    if (w <= 0 || h <= 0) return;
+    int y_end = y + h;
+    if (y < 0) y = 0;
+    if (y_end > c->height) y_end = c->height;
+    for (; y < y_end; y++) {
+        draw_hspan(c, y, x, x + w - 1, color);
+    }
+}
+
+void draw_rect(const draw_canvas_t *c, int x, int y, int w, int h, pixel_color_t color)
+{
+    if (w <= 0 || h <= 0) return;
+    draw_hspan(c, y, x, x + w - 1, color);
+    if (h > 1) draw_hspan(c, y + h - 1, x, x + w - 1, color);
+    for (int row = y + 1; row < y + h - 1; row++) {
+        draw_pixel(c, x, row, color);
+        if (w > 1) draw_pixel(c, x + w - 1, row, color);
+    }
+}
+
+// Midpoint circle outline, plotted with eight-way symmetry.
+void draw_circle(const draw_canvas_t *c, int cx, int cy, int radius, pixel_color_t color)
+{
+    if (radius < 0) return;
+    int x = radius, y = 0, err = 1 - radius;
+    while (x >= y) {
+        draw_pixel(c, cx + x, cy + y, color);
+        draw_pixel(c, cx - x, cy + y, color);
+        draw_pixel(c, cx + x, cy - y, color);
+        draw_pixel(c, cx - x, cy - y, color);
+        draw_pixel(c, cx + y, cy + x, color);
+        draw_pixel(c, cx - y, cy + x, color);
+        draw_pixel(c, cx + y, cy - x, color);
+        draw_pixel(c, cx - y, cy - x, color);
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void draw_disc(const draw_canvas_t *c, int cx, int cy, int radius, pixel_color_t color)
+{
+    if (radius < 0) return;
+    int x = radius, y = 0, err = 1 - radius;
+    while (x >= y) {
+        draw_hspan(c, cy + y, cx - x, cx + x, color);
+        draw_hspan(c, cy - y, cx - x, cx + x, color);
+        draw_hspan(c, cy + x, cx - y, cx + y, color);
+        draw_hspan(c, cy - x, cx - y, cx + y, color);
+        y++;
+        if (err < 0) {
+            err += 2 * y + 1;
+        } else {
+            x--;
+            err += 2 * (y - x) + 1;
+        }
+    }
+}
+
+// Scanline flood fill: each popped seed is grown into a full span, filled
+// in one go, and the rows above and below are scanned for new span starts.
+int draw_flood_fill(const draw_canvas_t *c, int x, int y, pixel_color_t color)
+{
+    if (x < 0 || y < 0 || x >= c->width || y >= c->height) return 0;
+    pixel_color_t target = c->pixels[y * c->width + x];
+    if (same_color(target, color)) return 0;
+
+    // Pending seeds are span starts in neighbouring rows. A pixel can be
+    // queued from both sides before it is filled, so a concave region can
+    // need more seeds than it has pixels; the stack starts at two rows'
+    // worth and doubles when full.
+    int capacity = 2 * c->width;
+    int16_t (*stack)[2] = malloc(capacity * sizeof(*stack));
+    if (!stack) return -1;
+
+    int top = 0, filled = 0;
+    stack[top][0] = x;
+    stack[top][1] = y;
+    top++;
+
+    while (top > 0) {
+        top--;
+        int sx = stack[top][0], sy = stack[top][1];
+        pixel_color_t *row = c->pixels + sy * c->width;
+        if (!same_color(row[sx], target)) continue;
+
+        int left = sx, right = sx;
+        while (left > 0 && same_color(row[left - 1], target)) left--;
+        while (right < c->width - 1 && same_color(row[right + 1], target)) right++;
+        draw_hspan(c, sy, left, right, color);
+        filled += right - left + 1;
+
+        for (int dir = -1; dir <= 1; dir += 2) {
+            int ny = sy + dir;
+            if (ny < 0 || ny >= c->height) continue;
+            pixel_color_t *nrow = c->pixels + ny * c->width;
+            int in_span = 0;
+            for (int nx = left; nx <= right; nx++) {
+                if (same_color(nrow[nx], target)) {
+                    if (!in_span && top == capacity) {
+                        void *grown = realloc(stack, 2 * capacity * sizeof(*stack));
+                        if (!grown) {
+                            free(stack);
+                            return -1;
+                        }
+                        stack = grown;
+                        capacity *= 2;
+                    }
+                    if (!in_span) {
+                        stack[top][0] = nx;
+                        stack[top][1] = ny;
+                        top++;
+                    }
+                    in_span = 1;
+                } else {
+                    in_span = 0;
+                }
+            }
+        }
+    }
+
+    free(stack);
+    return filled;
+}
+
+// Copies a packed rgb sprite, clipped to the canvas. With a key colour the
+// sprite is split into opaque runs which are copied span by span.
+void draw_blit(const draw_canvas_t *c, int x, int y, int w, int h,
+               const uint8_t *rgb, const pixel_color_t *key)
+{
+    if (w <= 0 || h <= 0) return;
+    int src_x0 = x < 0 ? -x : 0;
+    int src_y0 = y < 0 ? -y : 0;
+    int src_x1 = (x + w > c->width) ? c->width - x : w;
+    int src_y1 = (y + h > c->height) ? c->height - y : h;
+    if (src_x0 >= src_x1 || src_y0 >= src_y1) return;
+
+    for (int sy = src_y0; sy < src_y1; sy++) {
+        const uint8_t *src = rgb + (sy * w + src_x0) * 3;
+        pixel_color_t *dst = c->pixels + (y + sy) * c->width + x + src_x0;
+        int n = src_x1 - src_x0;
+
+        if (!key) {
+            memcpy(dst, src, n * sizeof(pixel_color_t));
+            continue;
+        }
+        int i = 0;
+        while (i < n) {
+            while (i < n && src[i * 3] == key->r && src[i * 3 + 1] == key->g && src[i * 3 + 2] == key->b) i++;
+            int run = i;
+            while (i < n && !(src[i * 3] == key->r && src[i * 3 + 1] == key->g && src[i * 3 + 2] == key->b)) i++;
+            if (i > run) memcpy(dst + run, src + run * 3, (i - run) * sizeof(pixel_color_t));
+        }
+    }
+}
+
+static inline int16_t rd16(const uint8_t *p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static inline pixel_color_t rdrgb(const uint8_t *p)
+{
+    return (pixel_color_t){p[0], p[1], p[2]};
+}
+
+// Length of the command at p (including opcode), or 0 if it is unknown
+// or runs past the end of the buffer.
+static size_t command_length(const uint8_t *p, size_t remaining)
+{
+    size_t len;
+    switch (p[0]) {
+        case DRAW_OP_CLEAR:     len = 1 + 3; break;
+        case DRAW_OP_PIXEL:
+        case DRAW_OP_FLOOD:     len = 1 + 4 + 3; break;
+        case DRAW_OP_CIRCLE:
+        case DRAW_OP_DISC:      len = 1 + 6 + 3; break;
+        case DRAW_OP_LINE:
+        case DRAW_OP_RECT:
+        case DRAW_OP_FILL_RECT: len = 1 + 8 + 3; break;
+        case DRAW_OP_BLIT: {
+            if (remaining < 13) return 0;
+            int w = rd16(p + 5), h = rd16(p + 7);
+            if (w < 0 || h < 0) return 0;
+            len = 13 + (size_t)w * h * 3;
+            break;
+        }
+        default:
+            return 0;
+    }
+    return len <= remaining ? len : 0;
+}
+
+int draw_exec(const draw_canvas_t *c, const uint8_t *cmds, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = command_length(cmds + pos, len - pos);
+        if (n == 0) return -1;
+        pos += n;
+    }
+
+    int count = 0;
+    pos = 0;
+    while (pos < len) {
+        const uint8_t *p = cmds + pos;
+        const uint8_t *a = p + 1;
+        switch (p[0]) {
+            case DRAW_OP_CLEAR:
+                draw_fill_rect(c, 0, 0, c->width, c->height, rdrgb(a));
+                break;
+            case DRAW_OP_PIXEL:
+                draw_pixel(c, rd16(a), rd16(a + 2), rdrgb(a + 4));
+                break;
+            case DRAW_OP_FLOOD:
+                if (draw_flood_fill(c, rd16(a), rd16(a + 2), rdrgb(a + 4)) < 0) return -2;
+                break;
+            case DRAW_OP_CIRCLE:
+                draw_circle(c, rd16(a), rd16(a + 2), rd16(a + 4), rdrgb(a + 6));
+                break;
+            case DRAW_OP_DISC:
+                draw_disc(c, rd16(a), rd16(a + 2), rd16(a + 4), rdrgb(a + 6));
+                break;
+            case DRAW_OP_LINE:
+                draw_line(c, rd16(a), rd16(a + 2), rd16(a + 4), rd16(a + 6), rdrgb(a + 8));
+                break;
+            case DRAW_OP_RECT:
+                draw_rect(c, rd16(a), rd16(a + 2), rd16(a + 4), rd16(a + 6), rdrgb(a + 8));
+                break;
+            case DRAW_OP_FILL_RECT:
+                draw_fill_rect(c, rd16(a), rd16(a + 2), rd16(a + 4), rd16(a + 6), rdrgb(a + 8));
+                break;
+            case DRAW_OP_BLIT: {
+                pixel_color_t key = rdrgb(a + 9);
+                draw_blit(c, rd16(a), rd16(a + 2), rd16(a + 4), rd16(a + 6), a + 12,
+                          (a[8] & DRAW_BLIT_KEYED) ? &key : NULL);
+                break;
+            }
+        }
+        pos += command_length(p, len - pos);
+        count++;
+    }
+    return count;
+}
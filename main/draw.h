@@ -0,0 +1,51 @@
+#ifndef DRAW_H
+#define DRAW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "matrix_state.h"
+
+// A drawable surface. Everything is clipped against width/height, so
+// callers can pass coordinates that fall partly (or fully) off-panel.
+typedef struct {
+    pixel_color_t *pixels;   // row-major, width * height entries
+    int width;
+    int height;
+} draw_canvas_t;
+
+// Command opcodes for the compact binary /draw protocol.
+// Coordinates and sizes are signed 16-bit little-endian, colours are r,g,b.
+#define DRAW_OP_PIXEL      'P'  // x y rgb
+#define DRAW_OP_LINE       'L'  // x0 y0 x1 y1 rgb
+#define DRAW_OP_RECT       'R'  // x y w h rgb
+#define DRAW_OP_FILL_RECT  'F'  // x y w h rgb
+#define DRAW_OP_CIRCLE     'C'  // cx cy radius rgb
+#define DRAW_OP_DISC       'D'  // cx cy radius rgb
+#define DRAW_OP_FLOOD      'X'  // x y rgb
+#define DRAW_OP_CLEAR      'K'  // rgb
+#define DRAW_OP_BLIT       'B'  // x y w h flags key_rgb, then w*h rgb triplets
+
+#define DRAW_BLIT_KEYED    0x01 // skip source pixels equal to key_rgb
+
+void draw_canvas_framebuffer(draw_canvas_t *canvas);
+
+void draw_hspan(const draw_canvas_t *c, int y, int x0, int x1, pixel_color_t color);
+void draw_pixel(const draw_canvas_t *c, int x, int y, pixel_color_t color);
+void draw_line(const draw_canvas_t *c, int x0, int y0, int x1, int y1, pixel_color_t color);
+void draw_rect(const draw_canvas_t *c, int x, int y, int w, int h, pixel_color_t color);
+void draw_fill_rect(const draw_canvas_t *c, int x, int y, int w, int h, pixel_color_t color);
+void draw_circle(const draw_canvas_t *c, int cx, int cy, int radius, pixel_color_t color);
+void draw_disc(const draw_canvas_t *c, int cx, int cy, int radius, pixel_color_t color);
+// Returns the number of pixels filled, or -1 if it ran out of memory part
+// way through.
+int draw_flood_fill(const draw_canvas_t *c, int x, int y, pixel_color_t color);
+void draw_blit(const draw_canvas_t *c, int x, int y, int w, int h,
+               const uint8_t *rgb, const pixel_color_t *key);
+
+// Validates and then executes a packed command stream. Nothing is drawn
+// unless the whole stream is well formed. Returns the number of commands
+// executed, -1 if the stream is malformed, or -2 if a flood fill ran out
+// of memory, in which case the commands before it have been drawn.
+int draw_exec(const draw_canvas_t *c, const uint8_t *cmds, size_t len);
+
+#endif // DRAW_H
@@ -0,0 +1,185 @@
+#include <string.h>
+#include "effects.h"
+#include "gif.h"
+#include "life.h"
+#include "noise.h"
+
+// Hue wheel for MODE_RAINBOW. Rotating the lookup offset animates the
+// rainbow without recomputing any colours per frame.
+static pixel_color_t rainbow_palette[PALETTE_SIZE];
+
+// 2 degrees of hue per frame.
+#define RAINBOW_PERIOD 180
+
+// Positions of the periodic modes in their cycles.
+static uint8_t rainbow_step = 0;
+static uint8_t gradient_offset = 0;
+
+void effects_init(void)
+{
+    palette_fill_hue_wheel(rainbow_palette);
+    palette_fill_hue_wheel(palette);
+    expr_vm_init();
+    life_init();
+    noise_init();
+}
+
+// Running time of the procedural modes. It advances by the frame interval
+// times speed, so changing the speed never makes the animation jump.
+static uint32_t advance_phase(const effect_ctx_t *ctx)
+{
+    static uint32_t last_ms = 0;
+    static uint32_t phase = 0;   // ms * 64
+    uint32_t dt = ctx->time_ms - last_ms;
+    last_ms = ctx->time_ms;
+    if (dt > 100) dt = 100;      // first frame, or after another mode ran
+    phase += dt * ctx->speed;
+    return phase >> 6;
+}
+
+void effects_enter(display_mode_t mode)
+{
+    if (mode == MODE_LIFE || mode == MODE_HIGHLIFE || mode == MODE_BRAIN) {
+        life_reset();
+    } else if (mode == MODE_GIF) {
+        gif_rewind();
+    }
+}
+
+// Copies the framebuffer (rgb or palette-expanded) into a frame.
+void effects_render_framebuffer(pixel_color_t *frame)
+{
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            frame[row * MATRIX_COLS + col] = framebuffer_pixel(row, col);
+        }
+    }
+}
+
+uint32_t effects_period(display_mode_t mode, effect_key_t *key, uint32_t *phase)
+{
+    memset(key, 0, sizeof(*key));
+    key->mode = mode;
+    key->rows = MATRIX_ROWS;
+    key->cols = MATRIX_COLS;
+    switch (mode) {
+        case MODE_RAINBOW:
+            *phase = rainbow_step;
+            return RAINBOW_PERIOD;
+        case MODE_CHECKERBOARD:
+            key->primary = current_color;
+            key->secondary = secondary_color;
+            *phase = 0;
+            return 1;
+        case MODE_GRADIENT:
+            key->primary = current_color;
+            key->secondary = secondary_color;
+            *phase = gradient_offset;
+            return MATRIX_COLS;
+        default:
+            return 0;
+    }
+}
+
+void effects_skip(display_mode_t mode)
+{
+    if (mode == MODE_RAINBOW) {
+        rainbow_step = (rainbow_step + 1) % RAINBOW_PERIOD;
+    } else if (mode == MODE_GRADIENT) {
+        gradient_offset = (gradient_offset + 1) % MATRIX_COLS;
+    }
+}
+
+int effects_render(display_mode_t mode, const effect_ctx_t *ctx, pixel_color_t *frame)
+{
+    switch (mode) {
+        case MODE_STATIC:
+            effects_render_framebuffer(frame);
+            return 100;
+        case MODE_RAINBOW: {
+            int offset = rainbow_step * PALETTE_SIZE / RAINBOW_PERIOD;
+            for (int i = 0; i < RGB_COUNT; i++) {
+                uint8_t idx = (uint8_t)((i * PALETTE_SIZE) / RGB_COUNT + offset);
+                frame[i] = rainbow_palette[idx];
+            }
+            effects_skip(mode);
+            return 50;
+        }
+        case MODE_CHECKERBOARD:
+            for (int row = 0; row < MATRIX_ROWS; row++) {
+                for (int col = 0; col < MATRIX_COLS; col++) {
+                    int led_index = row * MATRIX_COLS + col;
+                    if ((row + col) % 2 == 0) {
+                        frame[led_index] = current_color;
+                    } else {
+                        frame[led_index] = secondary_color;
+                    }
+                }
+            }
+            return 500;
+        case MODE_GRADIENT:
+            for (int row = 0; row < MATRIX_ROWS; row++) {
+                for (int col = 0; col < MATRIX_COLS; col++) {
+                    int led_index = row * MATRIX_COLS + col;
+                    float factor = ((float)((col + gradient_offset) % MATRIX_COLS)) / (MATRIX_COLS - 1);
+                    frame[led_index].r = (uint8_t)(current_color.r * (1 - factor) + secondary_color.r * factor);
+                    frame[led_index].g = (uint8_t)(current_color.g * (1 - factor) + secondary_color.g * factor);
+                    frame[led_index].b = (uint8_t)(current_color.b * (1 - factor) + secondary_color.b * factor);
+                }
+            }
+            effects_skip(mode);
+            return 100;
+        case MODE_RANDOM:
+            for (int i = 0; i < RGB_COUNT; i++) {
+                uint32_t r = prng_next();
+                frame[i] = (pixel_color_t){r, r >> 8, r >> 16};
+            }
+            return 200;
+        case MODE_EXPR:
+            if (ctx->expr && ctx->expr->len > 0) {
+                uint32_t ms = ctx->time_ms % (EXPR_T_PERIOD_S * 1000u);
+                int32_t t = (int32_t)(((int64_t)ms << 16) / 1000);
+                expr_render(ctx->expr, t, MATRIX_COLS, MATRIX_ROWS, (uint8_t *)frame);
+            } else {
+                memset(frame, 0, RGB_COUNT * sizeof(pixel_color_t));
+            }
+            return 33;
+        case MODE_PALETTE_CYCLE:
+            // One palette rotation per frame; the indexed frame itself
+            // is untouched and only expanded on the way out.
+            palette_offset++;
+            effects_render_framebuffer(frame);
+            return 50;
+        case MODE_PLASMA:
+            plasma_render(advance_phase(ctx), ctx->scale, rainbow_palette, frame);
+            return 16;
+        case MODE_NOISE:
+            flow_render(advance_phase(ctx), ctx->scale, rainbow_palette, frame);
+            return 16;
+        case MODE_FIRE: {
+            // The simulation advances one step per frame, so speed sets the
+            // frame rate: 30 fps at the default.
+            fire_render(ctx->scale, frame);
+            int delay = 33 * 64 / (ctx->speed + 1);
+            return delay < 16 ? 16 : delay > 250 ? 250 : delay;
+        }
+        case MODE_LIFE:
+            return life_effect(LIFE_RULE_LIFE, ctx->time_ms, frame);
+        case MODE_HIGHLIFE:
+            return life_effect(LIFE_RULE_HIGHLIFE, ctx->time_ms, frame);
+        case MODE_BRAIN:
+            return life_effect(LIFE_RULE_BRAIN, ctx->time_ms, frame);
+        case MODE_GIF: {
+            // Black until a GIF has been uploaded (or if it fails to decode).
+            // The render task may come early (tweens, drawing), so the
+            // player keeps the frame timing.
+            int delay = gif_frame_at(ctx->time_ms, frame);
+            if (delay >= 0) return delay;
+            memset(frame, 0, RGB_COUNT * sizeof(pixel_color_t));
+            return GIF_DEFAULT_DELAY_MS;
+        }
+        default:
+            break;
+    }
+    return 100;
+}
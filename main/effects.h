@@ -0,0 +1,49 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <stdint.h>
+#include "matrix_state.h"
+#include "expr_vm.h"
+
+// Per-frame inputs for the mode renderers, gathered by the render task.
+typedef struct {
+    uint32_t time_ms;             // render clock
+    const expr_program_t *expr;   // program for MODE_EXPR, may be NULL
+    uint8_t speed;                // procedural modes, 64 = normal
+    uint8_t scale;
+} effect_ctx_t;
+
+// Everything a periodic mode's frames depend on besides its position in
+// the cycle. Compared bytewise, so effects_period() zeroes it first.
+typedef struct {
+    uint8_t mode;
+    pixel_color_t primary;
+    pixel_color_t secondary;
+    uint16_t rows;
+    uint16_t cols;
+} effect_key_t;
+
+void effects_init(void);
+
+// Called when a mode becomes the active one, so it can restart from the
+// current framebuffer (the cellular automata seed from it).
+void effects_enter(display_mode_t mode);
+
+// Renders the next frame of a mode into frame (RGB_COUNT pixels, unscaled)
+// and returns how long that frame should stay up, in ms. Pure computation:
+// no hardware access, so it also runs in the host benchmarks.
+int effects_render(display_mode_t mode, const effect_ctx_t *ctx, pixel_color_t *frame);
+
+// Periodic modes cycle through a fixed sequence of frames that depends
+// only on key, so frame_cache can replay them. Returns the length of the
+// cycle in frames and sets *phase to the position of the next frame, or
+// returns 0 for modes whose output never repeats.
+uint32_t effects_period(display_mode_t mode, effect_key_t *key, uint32_t *phase);
+
+// Moves a periodic mode on by one frame without rendering it.
+void effects_skip(display_mode_t mode);
+
+// Copies the framebuffer (rgb or palette-expanded) into a frame.
+void effects_render_framebuffer(pixel_color_t *frame);
+
+#endif // EFFECTS_H
@@ -0,0 +1,476 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "expr_vm.h"
+
+enum {
+    OP_CONST = 0,
+    OP_X, OP_Y, OP_I, OP_W, OP_H, OP_T,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_MOD, OP_LT, OP_GT,
+    OP_NEG, OP_SIN, OP_COS, OP_ABS, OP_FLOOR, OP_FRAC,
+    OP_MIN, OP_MAX, OP_CLAMP,
+    OP_HSV, OP_RGB, OP_GRAY,
+    OP_COUNT
+};
+
+// Stack effect of every opcode: values popped, values pushed.
+static const uint8_t op_pops[OP_COUNT] = {
+    [OP_ADD] = 2, [OP_SUB] = 2, [OP_MUL] = 2, [OP_DIV] = 2, [OP_MOD] = 2,
+    [OP_LT] = 2, [OP_GT] = 2, [OP_NEG] = 1, [OP_SIN] = 1, [OP_COS] = 1,
+    [OP_ABS] = 1, [OP_FLOOR] = 1, [OP_FRAC] = 1, [OP_MIN] = 2, [OP_MAX] = 2,
+    [OP_CLAMP] = 3, [OP_HSV] = 3, [OP_RGB] = 3, [OP_GRAY] = 1,
+};
+
+static int op_pushes(int op)
+{
+    return op <= OP_T ? 1 : (op >= OP_HSV ? 0 : 1);
+}
+
+// 256 entries per turn plus linear interpolation is plenty for 8-bit LEDs.
+static int32_t sin_lut[257];
+
+void expr_vm_init(void)
+{
+    for (int i = 0; i <= 256; i++) {
+        sin_lut[i] = (int32_t)lrintf(sinf(i * (2.0f * (float)M_PI / 256.0f)) * EXPR_FIX_ONE);
+    }
+}
+
+// Fixed-point helpers. Arithmetic wraps rather than trapping, and division
+// by zero yields zero, so no input can fault the render task.
+static inline int32_t fx_add(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+static inline int32_t fx_sub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+static inline int32_t fx_mul(int32_t a, int32_t b) { return (int32_t)(((int64_t)a * b) >> 16); }
+
+static inline int32_t fx_div(int32_t a, int32_t b)
+{
+    if (b == 0) return 0;
+    int64_t q = ((int64_t)a * EXPR_FIX_ONE) / b;
+    return (int32_t)q;
+}
+
+static inline int32_t fx_floor(int32_t a) { return a & ~(EXPR_FIX_ONE - 1); }
+static inline int32_t fx_frac(int32_t a) { return a & (EXPR_FIX_ONE - 1); }
+
+static inline int32_t fx_mod(int32_t a, int32_t b)
+{
+    // INT32_MIN % -1 traps like a division overflow; the result is 0 anyway.
+    if (b == 0 || b == -1) return 0;
+    int32_t r = a % b;
+    return (r != 0 && ((r < 0) != (b < 0))) ? r + b : r;
+}
+
+static inline int32_t fx_sin(int32_t turns)
+{
+    uint32_t phase = (uint32_t)turns & 0xffff;
+    uint32_t idx = phase >> 8, frac = phase & 0xff;
+    int32_t a = sin_lut[idx], b = sin_lut[idx + 1];
+    return a + (((b - a) * (int32_t)frac) >> 8);
+}
+
+static inline uint8_t fx_to_u8(int32_t v)
+{
+    if (v <= 0) return 0;
+    if (v >= EXPR_FIX_ONE) return 255;
+    return (uint8_t)((v * 255) >> 16);
+}
+
+static inline void fx_hsv(int32_t h, int32_t s, int32_t v, uint8_t *out)
+{
+    if (s < 0) s = 0;
+    if (s > EXPR_FIX_ONE) s = EXPR_FIX_ONE;
+    if (v < 0) v = 0;
+    if (v > EXPR_FIX_ONE) v = EXPR_FIX_ONE;
+
+    int32_t h6 = fx_frac(h) * 6;
+    int sector = h6 >> 16;
+    int32_t f = h6 & 0xffff;
+    int32_t p = fx_mul(v, EXPR_FIX_ONE - s);
+    int32_t q = fx_mul(v, EXPR_FIX_ONE - fx_mul(s, f));
+    int32_t t = fx_mul(v, EXPR_FIX_ONE - fx_mul(s, EXPR_FIX_ONE - f));
+    int32_t r, g, b;
+    switch (sector) {
+        case 0:  r = v; g = t; b = p; break;
+        case 1:  r = q; g = v; b = p; break;
+        case 2:  r = p; g = v; b = t; break;
+        case 3:  r = p; g = q; b = v; break;
+        case 4:  r = t; g = p; b = v; break;
+        default: r = v; g = p; b = q; break;
+    }
+    out[0] = fx_to_u8(r);
+    out[1] = fx_to_u8(g);
+    out[2] = fx_to_u8(b);
+}
+
+static int32_t fold(int op, const int32_t *a)
+{
+    switch (op) {
+        case OP_ADD:   return fx_add(a[0], a[1]);
+        case OP_SUB:   return fx_sub(a[0], a[1]);
+        case OP_MUL:   return fx_mul(a[0], a[1]);
+        case OP_DIV:   return fx_div(a[0], a[1]);
+        case OP_MOD:   return fx_mod(a[0], a[1]);
+        case OP_LT:    return a[0] < a[1] ? EXPR_FIX_ONE : 0;
+        case OP_GT:    return a[0] > a[1] ? EXPR_FIX_ONE : 0;
+        case OP_NEG:   return fx_sub(0, a[0]);
+        case OP_SIN:   return fx_sin(a[0]);
+        case OP_COS:   return fx_sin(fx_add(a[0], EXPR_FIX_ONE / 4));
+        case OP_ABS:   return a[0] < 0 ? fx_sub(0, a[0]) : a[0];
+        case OP_FLOOR: return fx_floor(a[0]);
+        case OP_FRAC:  return fx_frac(a[0]);
+        case OP_MIN:   return a[0] < a[1] ? a[0] : a[1];
+        case OP_MAX:   return a[0] > a[1] ? a[0] : a[1];
+        case OP_CLAMP: return a[0] < a[1] ? a[1] : (a[0] > a[2] ? a[2] : a[0]);
+    }
+    return 0;
+}
+
+// --- Compiler -------------------------------------------------------------
+
+typedef struct {
+    const char *src;
+    const char *pos;
+    expr_program_t *prog;
+    int depth;
+    int nesting;
+    int recursion;          // parse_unary() calls in progress
+    char *err;
+    size_t err_len;
+    int failed;
+} parser_t;
+
+static void fail(parser_t *p, const char *msg)
+{
+    if (!p->failed) {
+        snprintf(p->err, p->err_len, "%s at offset %d", msg, (int)(p->pos - p->src));
+        p->failed = 1;
+    }
+}
+
+static void skip_ws(parser_t *p)
+{
+    while (isspace((unsigned char)*p->pos)) p->pos++;
+}
+
+static int accept(parser_t *p, char c)
+{
+    skip_ws(p);
+    if (*p->pos == c) {
+        p->pos++;
+        return 1;
+    }
+    return 0;
+}
+
+static void expect(parser_t *p, char c)
+{
+    if (!accept(p, c)) {
+        char msg[24];
+        snprintf(msg, sizeof(msg), "expected '%c'", c);
+        fail(p, msg);
+    }
+}
+
+static int is_const(const expr_program_t *prog, int back)
+{
+    return prog->len >= back && prog->code[prog->len - back][0] == OP_CONST;
+}
+
+static void emit(parser_t *p, int op, int arg)
+{
+    expr_program_t *prog = p->prog;
+    if (p->failed) return;
+
+    // Constant folding: collapse an operator whose operands are all
+    // literals back into a single literal.
+    int pops = op_pops[op];
+    if (op != OP_CONST && op < OP_HSV && pops > 0) {
+        int foldable = 1;
+        for (int k = 1; k <= pops; k++) foldable &= is_const(prog, k);
+        if (foldable) {
+            int32_t args[3];
+            for (int k = 0; k < pops; k++) {
+                args[k] = prog->consts[prog->code[prog->len - pops + k][1]];
+            }
+            int32_t value = fold(op, args);
+            // Folded operands were the most recent constants; reuse their slots.
+            prog->nconsts = prog->code[prog->len - pops][1];
+            prog->len -= pops;
+            p->depth -= pops;
+            if (prog->nconsts >= EXPR_MAX_CONSTS) { fail(p, "too many constants"); return; }
+            prog->consts[prog->nconsts] = value;
+            op = OP_CONST;
+            arg = prog->nconsts++;
+            pops = 0;
+        }
+    }
+
+    if (prog->len >= EXPR_MAX_INSNS) {
+        fail(p, "expression too long");
+        return;
+    }
+    prog->code[prog->len][0] = op;
+    prog->code[prog->len][1] = arg;
+    prog->len++;
+    p->depth += op_pushes(op) - pops;
+    if (p->depth > prog->max_stack) prog->max_stack = p->depth;
+    if (p->depth > EXPR_STACK_MAX) fail(p, "expression nested too deeply");
+}
+
+static void emit_const(parser_t *p, int32_t value)
+{
+    if (p->prog->nconsts >= EXPR_MAX_CONSTS) {
+        fail(p, "too many constants");
+        return;
+    }
+    p->prog->consts[p->prog->nconsts] = value;
+    emit(p, OP_CONST, p->prog->nconsts++);
+}
+
+static const struct {
+    const char *name;
+    uint8_t op;
+    uint8_t argc;
+} functions[] = {
+    {"sin", OP_SIN, 1}, {"cos", OP_COS, 1}, {"abs", OP_ABS, 1},
+    {"floor", OP_FLOOR, 1}, {"frac", OP_FRAC, 1},
+    {"min", OP_MIN, 2}, {"max", OP_MAX, 2}, {"clamp", OP_CLAMP, 3},
+    {"hsv", OP_HSV, 3}, {"rgb", OP_RGB, 3},
+};
+
+static const struct {
+    char name;
+    uint8_t op;
+} variables[] = {
+    {'x', OP_X}, {'y', OP_Y}, {'i', OP_I}, {'w', OP_W}, {'h', OP_H}, {'t', OP_T},
+};
+
+static void parse_expr(parser_t *p);
+
+static void parse_call(parser_t *p, const char *name, size_t name_len)
+{
+    for (size_t f = 0; f < sizeof(functions) / sizeof(functions[0]); f++) {
+        if (strlen(functions[f].name) != name_len || strncmp(functions[f].name, name, name_len) != 0) continue;
+
+        int is_color = functions[f].op >= OP_HSV;
+        if (is_color && p->nesting > 0) {
+            fail(p, "hsv()/rgb() must be the outermost call");
+            return;
+        }
+        p->nesting++;
+        for (int a = 0; a < functions[f].argc; a++) {
+            if (a > 0) expect(p, ',');
+            parse_expr(p);
+        }
+        expect(p, ')');
+        p->nesting--;
+        emit(p, functions[f].op, 0);
+        return;
+    }
+    fail(p, "unknown function");
+}
+
+static void parse_primary(parser_t *p)
+{
+    skip_ws(p);
+    const char *start = p->pos;
+
+    if (isdigit((unsigned char)*start) || *start == '.') {
+        char *end;
+        double value = strtod(start, &end);
+        if (end == start) { fail(p, "bad number"); return; }
+        p->pos = end;
+        if (value > 32767.0) value = 32767.0;
+        emit_const(p, (int32_t)lrint(value * EXPR_FIX_ONE));
+        return;
+    }
+
+    if (isalpha((unsigned char)*start)) {
+        while (isalnum((unsigned char)*p->pos)) p->pos++;
+        size_t len = p->pos - start;
+        if (accept(p, '(')) {
+            parse_call(p, start, len);
+            return;
+        }
+        if (len == 1) {
+            for (size_t v = 0; v < sizeof(variables) / sizeof(variables[0]); v++) {
+                if (variables[v].name == *start) {
+                    emit(p, variables[v].op, 0);
+                    return;
+                }
+            }
+        }
+        fail(p, "unknown variable");
+        return;
+    }
+
+    if (accept(p, '(')) {
+        p->nesting++;
+        parse_expr(p);
+        p->nesting--;
+        expect(p, ')');
+        return;
+    }
+    fail(p, "unexpected character");
+}
+
+static void parse_unary(parser_t *p)
+{
+    // Every bracket, call argument and minus sign comes back through here,
+    // so this bounds the parser's recursion on the caller's stack.
+    if (p->recursion >= EXPR_MAX_DEPTH) {
+        fail(p, "expression nested too deeply");
+        return;
+    }
+    p->recursion++;
+    if (accept(p, '-')) {
+        p->nesting++;
+        parse_unary(p);
+        p->nesting--;
+        emit(p, OP_NEG, 0);
+    } else {
+        parse_primary(p);
+    }
+    p->recursion--;
+}
+
+static void parse_binary_level(parser_t *p, int level);
+
+// Precedence levels, loosest first: comparison, additive, multiplicative.
+static const char *const level_ops[] = {"<>", "+-", "*/%"};
+static const uint8_t level_opcodes[][3] = {
+    {OP_LT, OP_GT}, {OP_ADD, OP_SUB}, {OP_MUL, OP_DIV, OP_MOD},
+};
+
+static void parse_binary_level(parser_t *p, int level)
+{
+    if (level == 3) {
+        parse_unary(p);
+        return;
+    }
+    parse_binary_level(p, level + 1);
+    while (!p->failed) {
+        skip_ws(p);
+        const char *op = strchr(level_ops[level], *p->pos);
+        if (!*p->pos || !op) break;
+        // The left operand is now part of a larger expression, so it must
+        // not have been a colour output.
+        if (p->prog->len && p->prog->code[p->prog->len - 1][0] >= OP_HSV) {
+            fail(p, "hsv()/rgb() must be the outermost call");
+            return;
+        }
+        p->pos++;
+        p->nesting++;
+        parse_binary_level(p, level + 1);
+        p->nesting--;
+        emit(p, level_opcodes[level][op - level_ops[level]], 0);
+    }
+}
+
+static void parse_expr(parser_t *p)
+{
+    parse_binary_level(p, 0);
+}
+
+int expr_compile(const char *src, expr_program_t *prog, char *err, size_t err_len)
+{
+    memset(prog, 0, sizeof(*prog));
+    parser_t p = {
+        .src = src, .pos = src, .prog = prog,
+        .err = err, .err_len = err_len,
+    };
+
+    if (strlen(src) > EXPR_SRC_MAX) {
+        snprintf(err, err_len, "expression longer than %d characters", EXPR_SRC_MAX);
+        return -1;
+    }
+
+    parse_expr(&p);
+    skip_ws(&p);
+    if (!p.failed && *p.pos) fail(&p, "unexpected trailing input");
+    if (!p.failed && (prog->len == 0 || prog->code[prog->len - 1][0] < OP_HSV)) {
+        emit(&p, OP_GRAY, 0);
+    }
+    if (!p.failed && expr_validate(prog) != 0) fail(&p, "internal compiler error");
+    return p.failed ? -1 : 0;
+}
+
+int expr_validate(const expr_program_t *prog)
+{
+    if (prog->len == 0 || prog->len > EXPR_MAX_INSNS || prog->nconsts > EXPR_MAX_CONSTS) return -1;
+
+    int depth = 0;
+    for (int pc = 0; pc < prog->len; pc++) {
+        int op = prog->code[pc][0];
+        if (op >= OP_COUNT) return -1;
+        if (op == OP_CONST && prog->code[pc][1] >= prog->nconsts) return -1;
+        if (depth < op_pops[op]) return -1;
+        depth += op_pushes(op) - op_pops[op];
+        if (depth > EXPR_STACK_MAX) return -1;
+        // Colour outputs terminate the program and must leave nothing behind.
+        if (op >= OP_HSV) return (pc == prog->len - 1 && depth == 0) ? 0 : -1;
+    }
+    return -1;
+}
+
+// --- Interpreter ----------------------------------------------------------
+
+void expr_render(const expr_program_t *prog, int32_t t, int width, int height, uint8_t *rgb)
+{
+    int32_t stack[EXPR_STACK_MAX];
+    const int32_t w_fx = width << 16, h_fx = height << 16;
+    const int len = prog->len;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++, rgb += 3) {
+            int32_t *sp = stack;
+            for (int pc = 0; pc < len; pc++) {
+                const uint8_t *insn = prog->code[pc];
+                switch (insn[0]) {
+                    case OP_CONST: *sp++ = prog->consts[insn[1]]; break;
+                    case OP_X:     *sp++ = x << 16; break;
+                    case OP_Y:     *sp++ = y << 16; break;
+                    case OP_I:     *sp++ = (y * width + x) << 16; break;
+                    case OP_W:     *sp++ = w_fx; break;
+                    case OP_H:     *sp++ = h_fx; break;
+                    case OP_T:     *sp++ = t; break;
+                    case OP_ADD:   sp--; sp[-1] = fx_add(sp[-1], sp[0]); break;
+                    case OP_SUB:   sp--; sp[-1] = fx_sub(sp[-1], sp[0]); break;
+                    case OP_MUL:   sp--; sp[-1] = fx_mul(sp[-1], sp[0]); break;
+                    case OP_DIV:   sp--; sp[-1] = fx_div(sp[-1], sp[0]); break;
+                    case OP_MOD:   sp--; sp[-1] = fx_mod(sp[-1], sp[0]); break;
+                    case OP_LT:    sp--; sp[-1] = sp[-1] < sp[0] ? EXPR_FIX_ONE : 0; break;
+                    case OP_GT:    sp--; sp[-1] = sp[-1] > sp[0] ? EXPR_FIX_ONE : 0; break;
+                    case OP_MIN:   sp--; if (sp[0] < sp[-1]) sp[-1] = sp[0]; break;
+                    case OP_MAX:   sp--; if (sp[0] > sp[-1]) sp[-1] = sp[0]; break;
+                    case OP_NEG:   sp[-1] = fx_sub(0, sp[-1]); break;
+                    case OP_SIN:   sp[-1] = fx_sin(sp[-1]); break;
+                    case OP_COS:   sp[-1] = fx_sin(fx_add(sp[-1], EXPR_FIX_ONE / 4)); break;
+                    case OP_ABS:   if (sp[-1] < 0) sp[-1] = fx_sub(0, sp[-1]); break;
+                    case OP_FLOOR: sp[-1] = fx_floor(sp[-1]); break;
+                    case OP_FRAC:  sp[-1] = fx_frac(sp[-1]); break;
+                    case OP_CLAMP:
+                        sp -= 2;
+                        sp[-1] = sp[-1] < sp[0] ? sp[0] : (sp[-1] > sp[1] ? sp[1] : sp[-1]);
+                        break;
+                    case OP_HSV:
+                        sp -= 3;
+                        fx_hsv(sp[0], sp[1], sp[2], rgb);
+                        break;
+                    case OP_RGB:
+                        sp -= 3;
+                        rgb[0] = fx_to_u8(sp[0]);
+                        rgb[1] = fx_to_u8(sp[1]);
+                        rgb[2] = fx_to_u8(sp[2]);
+                        break;
+                    case OP_GRAY:
+                        sp--;
+                        rgb[0] = rgb[1] = rgb[2] = fx_to_u8(sp[0]);
+                        break;
+                }
+            }
+        }
+    }
+}
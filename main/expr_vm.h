@@ -0,0 +1,48 @@
+#ifndef EXPR_VM_H
+#define EXPR_VM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Per-pixel effect expressions, e.g. "hsv(t*0.1 + x/8, 1, 1)".
+//
+// Source is compiled into straight-line Q16.16 stack bytecode: there are no
+// jumps or loops, so a program runs exactly `len` instructions per pixel and
+// EXPR_MAX_INSNS bounds the cost of any frame. Variables: x, y (pixel
+// column/row), i (pixel index), w, h (matrix size), t (seconds, back to 0
+// every EXPR_T_PERIOD_S).
+// Angles for sin/cos are in turns. The outermost call may be hsv(h,s,v)
+// or rgb(r,g,b) with components in 0..1; any other result is drawn as grey.
+
+#define EXPR_MAX_INSNS   64
+#define EXPR_MAX_CONSTS  16
+#define EXPR_STACK_MAX   16
+#define EXPR_SRC_MAX     256
+#define EXPR_MAX_DEPTH   8      // nested brackets, calls and minus signs;
+                                // compiling recurses on the httpd stack
+#define EXPR_T_PERIOD_S  3600   // keeps t well inside Q16.16
+
+#define EXPR_FIX_ONE     (1 << 16)
+
+typedef struct {
+    uint8_t code[EXPR_MAX_INSNS][2];   // opcode, operand
+    int32_t consts[EXPR_MAX_CONSTS];
+    uint8_t len;
+    uint8_t nconsts;
+    uint8_t max_stack;
+} expr_program_t;
+
+void expr_vm_init(void);
+
+// Returns 0 on success, otherwise -1 with a message in err.
+int expr_compile(const char *src, expr_program_t *prog, char *err, size_t err_len);
+
+// Checks that a program is well formed: known opcodes, operands in range,
+// no stack underflow or overflow, and exactly one colour output at the end.
+int expr_validate(const expr_program_t *prog);
+
+// Evaluates the program for every pixel of a width x height frame into
+// packed rgb triplets. t is the effect time in Q16.16 seconds.
+void expr_render(const expr_program_t *prog, int32_t t, int width, int height, uint8_t *rgb);
+
+#endif // EXPR_VM_H
@@ -0,0 +1,82 @@
+#include <stdbool.h>
+#include <string.h>
+#include "frame_cache.h"
+
+#define FRAME_BYTES (RGB_COUNT * sizeof(pixel_color_t))
+#define SLOT_COUNT  (FRAME_CACHE_BUDGET / FRAME_BYTES)
+
+typedef struct {
+    effect_key_t key;
+    uint16_t phase;
+    uint16_t delay_ms;
+    bool valid;
+} slot_tag_t;
+
+static pixel_color_t frames[SLOT_COUNT][RGB_COUNT];
+static slot_tag_t tags[SLOT_COUNT];
+static frame_cache_stats_t stats;
+
+// A cycle occupies consecutive slots from a start picked by its key, so two
+// modes that alternate during a cross-fade rarely land on each other.
+static uint32_t key_hash(const effect_key_t *key)
+{
+    const uint8_t *p = (const uint8_t *)key;
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < sizeof(*key); i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+void frame_cache_clear(void)
+{
+    memset(tags, 0, sizeof(tags));
+    stats.used = 0;
+}
+
+int frame_cache_render(display_mode_t mode, const effect_ctx_t *ctx, pixel_color_t *frame)
+{
+    effect_key_t key;
+    uint32_t phase;
+    uint32_t period = effects_period(mode, &key, &phase);
+    if (period == 0 || SLOT_COUNT == 0) {
+        stats.uncacheable++;
+        return effects_render(mode, ctx, frame);
+    }
+    if (phase >= SLOT_COUNT) {
+        stats.overflow++;
+        return effects_render(mode, ctx, frame);
+    }
+
+    uint32_t index = (key_hash(&key) + phase) % SLOT_COUNT;
+    slot_tag_t *tag = &tags[index];
+    if (tag->valid && tag->phase == phase && memcmp(&tag->key, &key, sizeof(key)) == 0) {
+        memcpy(frame, frames[index], FRAME_BYTES);
+        effects_skip(mode);
+        stats.hits++;
+        return tag->delay_ms;
+    }
+
+    int delay_ms = effects_render(mode, ctx, frame);
+    memcpy(frames[index], frame, FRAME_BYTES);
+    if (tag->valid) {
+        stats.evictions++;
+    } else {
+        stats.used++;
+    }
+    // Copied bytewise, so the key's padding still compares equal.
+    memcpy(&tag->key, &key, sizeof(key));
+    tag->phase = phase;
+    tag->delay_ms = delay_ms;
+    tag->valid = true;
+    stats.misses++;
+    return delay_ms;
+}
+
+void frame_cache_get_stats(frame_cache_stats_t *out)
+{
+    *out = stats;
+    out->budget_bytes = sizeof(frames) + sizeof(tags);
+    out->frame_bytes = FRAME_BYTES;
+    out->slots = SLOT_COUNT;
+}
@@ -0,0 +1,40 @@
+#ifndef FRAME_CACHE_H
+#define FRAME_CACHE_H
+
+#include <stdint.h>
+#include "effects.h"
+
+// Rendered frames of the periodic modes (see effects_period()), replayed
+// instead of recomputed. Slots fill lazily the first time round a cycle and
+// are tagged with the mode's key, so a colour change simply stops matching
+// the old frames. Frames are stored before brightness and calibration, so
+// neither of those invalidates anything.
+//
+// Memory is fixed at build time. A cycle longer than the cache keeps its
+// first frames only and renders the rest every time.
+#ifndef FRAME_CACHE_BUDGET
+#define FRAME_CACHE_BUDGET (48 * 1024)
+#endif
+
+typedef struct {
+    uint32_t budget_bytes;
+    uint32_t frame_bytes;
+    uint32_t slots;
+    uint32_t used;          // slots holding a frame
+    uint32_t hits;
+    uint32_t misses;        // rendered, then stored
+    uint32_t overflow;      // rendered, beyond the cache's share of the cycle
+    uint32_t uncacheable;   // frames of modes that never repeat
+    uint32_t evictions;     // stored over another key's frame
+} frame_cache_stats_t;
+
+// effects_render() through the cache. Render task only.
+int frame_cache_render(display_mode_t mode, const effect_ctx_t *ctx, pixel_color_t *frame);
+
+void frame_cache_clear(void);
+
+// Counters may be read from any task; each is a single word, so a reader
+// can at worst see them from slightly different frames.
+void frame_cache_get_stats(frame_cache_stats_t *stats);
+
+#endif // FRAME_CACHE_H
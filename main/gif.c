@@ -0,0 +1,632 @@
+#include <string.h>
+#include "gif.h"
+
+#define LZW_MAX_CODES 4096
+#define LZW_MAX_BITS  12
+#define NO_CODE       0xffff
+#define GIF_END       1             // next_image(): trailer or end of file
+
+// Larger sums would overflow a cell's 32-bit accumulators.
+#define MAX_CELL_AREA (UINT32_MAX / 256)
+
+typedef struct {
+    uint32_t r, g, b;
+    uint32_t n;                     // opaque source pixels summed
+} cell_sum_t;
+
+typedef struct {
+    uint16_t left, top, right, bottom;  // clipped to the screen
+} rect_t;
+
+// The image being decoded and where its next pixel goes.
+typedef struct {
+    uint16_t left, top, width, height;
+    bool interlaced;
+    uint8_t pass;
+    uint32_t row;                   // within the image
+    uint32_t x;                     // on the screen
+    uint32_t remaining;             // pixels still to come
+    const pixel_color_t *palette;
+    // Cells the current source row and column fall in, and the first
+    // column past the current cells.
+    uint16_t row_lo, row_hi;
+    uint16_t col_lo, col_hi;
+    uint32_t col_next;
+} image_t;
+
+static gif_source_t source;
+static gif_info_t info;
+static uint32_t first_block;        // offset just past the global palette
+static uint32_t loop_frames;        // frames shown since the first one
+static bool due_set;                // a frame is showing until due_ms
+static uint32_t due_ms;
+
+static uint8_t buf[GIF_READ_CHUNK];
+static uint32_t buf_offset;         // source offset of buf[0]
+static uint16_t buf_len;
+static uint16_t buf_pos;
+static bool read_error;
+static int block_left;              // in the current data sub-block, -1 after the last
+
+static pixel_color_t global_palette[256];
+static pixel_color_t local_palette[256];
+
+// Graphic control for the next image, and the disposal still owed by the
+// one on display.
+static uint16_t delay_cs;
+static int transparent;
+static uint8_t disposal;
+static uint8_t pending_disposal;
+static rect_t pending_rect;
+
+static uint16_t prefix[LZW_MAX_CODES];
+static uint8_t suffix[LZW_MAX_CODES];
+static uint8_t stack[LZW_MAX_CODES];
+
+static cell_sum_t sums[RGB_COUNT];
+static pixel_color_t canvas[RGB_COUNT];
+static pixel_color_t saved[RGB_COUNT];     // for disposal 3, restore previous
+
+// A cell's source span along one axis is [span_start, span_end): a box
+// when the GIF is larger than the matrix, a single sample when smaller.
+static uint32_t span_start(uint32_t i, uint32_t src, uint32_t dst)
+{
+    return i * src / dst;
+}
+
+static uint32_t span_end(uint32_t i, uint32_t src, uint32_t dst)
+{
+    uint32_t start = span_start(i, src, dst);
+    uint32_t end = span_start(i + 1, src, dst);
+    return end > start ? end : start + 1;
+}
+
+// Cells [*lo, *hi) whose span holds source coordinate v.
+static void cell_range(uint32_t v, uint32_t src, uint32_t dst, uint16_t *lo, uint16_t *hi)
+{
+    uint32_t h = ((v + 1) * dst + src - 1) / src;
+    if (h > dst) h = dst;
+    *hi = h;
+    *lo = src >= dst ? h - 1 : (v * dst + src - 1) / src;
+}
+
+static uint32_t overlap(uint32_t a0, uint32_t a1, uint32_t b0, uint32_t b1)
+{
+    uint32_t lo = a0 > b0 ? a0 : b0;
+    uint32_t hi = a1 < b1 ? a1 : b1;
+    return hi > lo ? hi - lo : 0;
+}
+
+static uint32_t max_cell_area(uint32_t width, uint32_t height)
+{
+    uint32_t w = width > MATRIX_COLS ? (width + MATRIX_COLS - 1) / MATRIX_COLS : 1;
+    uint32_t h = height > MATRIX_ROWS ? (height + MATRIX_ROWS - 1) / MATRIX_ROWS : 1;
+    return w * h;
+}
+
+static void seek(uint32_t offset)
+{
+    buf_offset = offset;
+    buf_len = 0;
+    buf_pos = 0;
+}
+
+static uint32_t tell(void)
+{
+    return buf_offset + buf_pos;
+}
+
+// Next byte of the file, or -1 at its end or on a read error.
+static int read_byte(void)
+{
+    if (buf_pos == buf_len) {
+        uint32_t at = buf_offset + buf_len;
+        if (at >= source.size || read_error) return -1;
+        uint32_t len = source.size - at;
+        if (len > GIF_READ_CHUNK) len = GIF_READ_CHUNK;
+        if (source.read(source.ctx, at, buf, len) != 0) {
+            read_error = true;
+            return -1;
+        }
+        buf_offset = at;
+        buf_len = len;
+        buf_pos = 0;
+    }
+    return buf[buf_pos++];
+}
+
+static bool read_bytes(uint8_t *dst, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        int b = read_byte();
+        if (b < 0) return false;
+        dst[i] = b;
+    }
+    return true;
+}
+
+static bool skip(uint32_t len)
+{
+    uint32_t in_buf = buf_len - buf_pos;
+    if (len <= in_buf) {
+        buf_pos += len;
+        return true;
+    }
+    seek(tell() + len);
+    return tell() <= source.size;
+}
+
+static bool skip_sub_blocks(void)
+{
+    int len;
+    while ((len = read_byte()) > 0) {
+        if (!skip(len)) return false;
+    }
+    return len == 0;
+}
+
+static bool read_palette(pixel_color_t *pal, int entries)
+{
+    memset(pal, 0, 256 * sizeof(pixel_color_t));
+    for (int i = 0; i < entries; i++) {
+        uint8_t rgb[3];
+        if (!read_bytes(rgb, 3)) return false;
+        pal[i] = (pixel_color_t){ rgb[0], rgb[1], rgb[2] };
+    }
+    return true;
+}
+
+// Next byte of the image data, across sub-blocks, or -1 after the last.
+static int data_byte(void)
+{
+    if (block_left == 0) {
+        block_left = read_byte();
+        if (block_left <= 0) block_left = -1;
+    }
+    if (block_left < 0) return -1;
+    block_left--;
+    return read_byte();
+}
+
+static void set_row(image_t *img)
+{
+    uint32_t y = img->top + img->row;
+    if (y < info.height) {
+        cell_range(y, info.height, MATRIX_ROWS, &img->row_lo, &img->row_hi);
+    } else {
+        img->row_lo = img->row_hi = 0;
+    }
+    img->x = img->left;
+    img->col_next = img->left;
+}
+
+static void next_row(image_t *img)
+{
+    static const uint8_t pass_start[4] = { 0, 4, 2, 1 };
+    static const uint8_t pass_step[4] = { 8, 8, 4, 2 };
+    if (!img->interlaced) {
+        img->row++;
+    } else {
+        img->row += pass_step[img->pass];
+        while (img->row >= img->height && img->pass < 3) {
+            img->pass++;
+            img->row = pass_start[img->pass];
+        }
+    }
+    set_row(img);
+}
+
+static void emit(image_t *img, uint8_t index)
+{
+    if (img->remaining == 0) return;
+    img->remaining--;
+    uint32_t x = img->x++;
+    if (index != transparent && img->row_lo < img->row_hi && x < info.width) {
+        if (x >= img->col_next) {
+            cell_range(x, info.width, MATRIX_COLS, &img->col_lo, &img->col_hi);
+            img->col_next = img->col_hi < MATRIX_COLS
+                ? span_start(img->col_hi, info.width, MATRIX_COLS) : UINT32_MAX;
+        }
+        pixel_color_t c = img->palette[index];
+        for (int row = img->row_lo; row < img->row_hi; row++) {
+            cell_sum_t *s = &sums[row * MATRIX_COLS + img->col_lo];
+            for (int col = img->col_lo; col < img->col_hi; col++, s++) {
+                s->r += c.r;
+                s->g += c.g;
+                s->b += c.b;
+                s->n++;
+            }
+        }
+    }
+    if (img->x == (uint32_t)img->left + img->width) next_row(img);
+}
+
+// Decodes one image's LZW stream into sums. Stops early, keeping what it
+// has, if the data ends; rejects codes that cannot occur.
+static int decode_lzw(image_t *img)
+{
+    int min_size = read_byte();
+    if (min_size < 1 || min_size > 8) return GIF_ERR_FORMAT;
+    const uint16_t clear = 1 << min_size;
+    const uint16_t eoi = clear + 1;
+    uint16_t next = clear + 2;
+    int width = min_size + 1;
+    uint32_t bits = 0;
+    int nbits = 0;
+    uint16_t prev = NO_CODE;
+    uint8_t first = 0;
+
+    block_left = 0;
+    while (img->remaining > 0) {
+        while (nbits < width) {
+            int b = data_byte();
+            if (b < 0) return 0;
+            bits |= (uint32_t)b << nbits;
+            nbits += 8;
+        }
+        uint16_t code = bits & ((1u << width) - 1);
+        bits >>= width;
+        nbits -= width;
+
+        if (code == clear) {
+            width = min_size + 1;
+            next = clear + 2;
+            prev = NO_CODE;
+            continue;
+        }
+        if (code == eoi) break;
+        if (prev == NO_CODE) {
+            if (code >= clear) return GIF_ERR_FORMAT;
+            first = code;
+            emit(img, first);
+            prev = code;
+            continue;
+        }
+        if (code > next) return GIF_ERR_FORMAT;
+
+        // Unwind the string backwards onto the stack; a code not yet in
+        // the table is the previous string plus its own first byte.
+        uint16_t in = code;
+        uint8_t *sp = stack;
+        if (code == next) {
+            *sp++ = first;
+            code = prev;
+        }
+        while (code >= clear) {
+            *sp++ = suffix[code];
+            code = prefix[code];
+        }
+        first = code;
+        *sp++ = first;
+
+        if (next < LZW_MAX_CODES) {
+            prefix[next] = prev;
+            suffix[next] = first;
+            next++;
+            if (next == (1u << width) && width < LZW_MAX_BITS) width++;
+        }
+        while (sp > stack) {
+            emit(img, *--sp);
+        }
+        prev = in;
+    }
+    // Whatever follows the last pixel, up to the block terminator.
+    while (data_byte() >= 0) {
+    }
+    return 0;
+}
+
+// Folds the decoded image into the canvas. The part of each cell the image
+// did not cover keeps the cell's colour.
+static void composite(void)
+{
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        uint32_t rows = span_end(row, info.height, MATRIX_ROWS) - span_start(row, info.height, MATRIX_ROWS);
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            int i = row * MATRIX_COLS + col;
+            const cell_sum_t *s = &sums[i];
+            if (s->n == 0) continue;
+            uint32_t area = rows * (span_end(col, info.width, MATRIX_COLS) - span_start(col, info.width, MATRIX_COLS));
+            uint32_t keep = area - s->n;
+            pixel_color_t *c = &canvas[i];
+            c->r = (s->r + keep * c->r + area / 2) / area;
+            c->g = (s->g + keep * c->g + area / 2) / area;
+            c->b = (s->b + keep * c->b + area / 2) / area;
+        }
+    }
+}
+
+// Disposal 2 clears the last image's rectangle to black, 3 restores what
+// was under it; cells it only partly covered are blended.
+static void apply_disposal(void)
+{
+    uint8_t method = pending_disposal;
+    pending_disposal = 0;
+    if (method != 2 && method != 3) return;
+    const rect_t *r = &pending_rect;
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        uint32_t y0 = span_start(row, info.height, MATRIX_ROWS);
+        uint32_t y1 = span_end(row, info.height, MATRIX_ROWS);
+        uint32_t rows = overlap(r->top, r->bottom, y0, y1);
+        if (rows == 0) continue;
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            uint32_t x0 = span_start(col, info.width, MATRIX_COLS);
+            uint32_t x1 = span_end(col, info.width, MATRIX_COLS);
+            uint32_t covered = rows * overlap(r->left, r->right, x0, x1);
+            if (covered == 0) continue;
+            int i = row * MATRIX_COLS + col;
+            uint32_t area = (y1 - y0) * (x1 - x0);
+            uint32_t keep = area - covered;
+            pixel_color_t to = method == 3 ? saved[i] : (pixel_color_t){ 0, 0, 0 };
+            pixel_color_t *c = &canvas[i];
+            c->r = (keep * c->r + covered * to.r + area / 2) / area;
+            c->g = (keep * c->g + covered * to.g + area / 2) / area;
+            c->b = (keep * c->b + covered * to.b + area / 2) / area;
+        }
+    }
+}
+
+static bool read_graphic_control(void)
+{
+    int len = read_byte();
+    if (len >= 4) {
+        uint8_t gce[4];
+        if (!read_bytes(gce, 4) || !skip(len - 4)) return false;
+        disposal = (gce[0] >> 2) & 7;
+        delay_cs = gce[1] | (gce[2] << 8);
+        transparent = (gce[0] & 1) ? gce[3] : -1;
+    } else if (len < 0 || !skip(len)) {
+        return false;
+    }
+    return len == 0 || skip_sub_blocks();
+}
+
+static int read_image(void)
+{
+    uint8_t d[9];
+    if (!read_bytes(d, sizeof(d))) return GIF_ERR_FORMAT;
+    image_t img = {
+        .left = d[0] | (d[1] << 8),
+        .top = d[2] | (d[3] << 8),
+        .width = d[4] | (d[5] << 8),
+        .height = d[6] | (d[7] << 8),
+        .interlaced = (d[8] & 0x40) != 0,
+        .palette = global_palette,
+    };
+    if (d[8] & 0x80) {
+        if (!read_palette(local_palette, 2 << (d[8] & 7))) return GIF_ERR_FORMAT;
+        img.palette = local_palette;
+    }
+    img.remaining = (uint32_t)img.width * img.height;
+    if (img.remaining > 0) set_row(&img);
+
+    if (disposal == 3) memcpy(saved, canvas, sizeof(canvas));
+    memset(sums, 0, sizeof(sums));
+    int err = decode_lzw(&img);
+    if (err < 0) return err;
+    composite();
+
+    pending_disposal = disposal;
+    pending_rect = (rect_t){
+        .left = img.left,
+        .top = img.top,
+        .right = img.left + img.width < info.width ? img.left + img.width : info.width,
+        .bottom = img.top + img.height < info.height ? img.top + img.height : info.height,
+    };
+    return 0;
+}
+
+// Reads blocks up to and including the next image. Returns its delay, or
+// GIF_END once the file is done.
+static int next_image(void)
+{
+    apply_disposal();
+    delay_cs = 0;
+    transparent = -1;
+    disposal = 0;
+    for (;;) {
+        int block = read_byte();
+        if (read_error) return GIF_ERR_READ;
+        if (block < 0 || block == 0x3b) return GIF_END;
+        if (block == 0x21) {
+            int label = read_byte();
+            bool ok = label == 0xf9 ? read_graphic_control() : label >= 0 && skip_sub_blocks();
+            if (!ok) return read_error ? GIF_ERR_READ : GIF_END;
+        } else if (block == 0x2c) {
+            int err = read_image();
+            if (read_error) return GIF_ERR_READ;
+            if (err < 0) return err;
+            loop_frames++;
+            uint32_t ms = delay_cs * 10u;
+            return ms < GIF_MIN_DELAY_MS ? GIF_DEFAULT_DELAY_MS : (int)ms;
+        } else {
+            // Trailing junk after the last image ends the file; anywhere
+            // else it means the file is not what it claims.
+            return loop_frames > 0 ? GIF_END : GIF_ERR_FORMAT;
+        }
+    }
+}
+
+int gif_probe(const uint8_t *head, size_t len, uint16_t *width, uint16_t *height)
+{
+    if (len < 10 || (memcmp(head, "GIF87a", 6) != 0 && memcmp(head, "GIF89a", 6) != 0)) {
+        return GIF_ERR_FORMAT;
+    }
+    *width = head[6] | (head[7] << 8);
+    *height = head[8] | (head[9] << 8);
+    if (*width == 0 || *height == 0) return GIF_ERR_FORMAT;
+    if (max_cell_area(*width, *height) > MAX_CELL_AREA) return GIF_ERR_TOO_LARGE;
+    return 0;
+}
+
+int gif_open(const gif_source_t *src)
+{
+    source = *src;
+    info = (gif_info_t){ .size = src->size };
+    read_error = false;
+    seek(0);
+
+    uint8_t header[13];
+    if (!read_bytes(header, sizeof(header))) return read_error ? GIF_ERR_READ : GIF_ERR_FORMAT;
+    int err = gif_probe(header, sizeof(header), &info.width, &info.height);
+    if (err < 0) return err;
+    if (header[10] & 0x80) {
+        if (!read_palette(global_palette, 2 << (header[10] & 7))) return GIF_ERR_FORMAT;
+    } else {
+        memset(global_palette, 0, sizeof(global_palette));
+    }
+    first_block = tell();
+    info.open = true;
+    gif_rewind();
+    return 0;
+}
+
+void gif_close(void)
+{
+    info.open = false;
+}
+
+static void restart(void)
+{
+    seek(first_block);
+    memset(canvas, 0, sizeof(canvas));
+    pending_disposal = 0;
+    loop_frames = 0;
+}
+
+void gif_rewind(void)
+{
+    restart();
+    due_set = false;
+}
+
+int gif_next_frame(pixel_color_t *frame)
+{
+    if (!info.open) return GIF_ERR_NOT_OPEN;
+    int delay_ms = next_image();
+    if (delay_ms == GIF_END) {
+        if (loop_frames == 0) {
+            delay_ms = GIF_ERR_NO_FRAMES;
+        } else {
+            info.loop_frames = loop_frames;
+            info.loops++;
+            restart();
+            delay_ms = next_image();
+            if (delay_ms == GIF_END) delay_ms = GIF_ERR_NO_FRAMES;
+        }
+    }
+    if (delay_ms < 0) {
+        info.open = false;
+        return delay_ms;
+    }
+    info.frame = loop_frames - 1;
+    memcpy(frame, canvas, sizeof(canvas));
+    return delay_ms;
+}
+
+int gif_frame_at(uint32_t now_ms, pixel_color_t *frame)
+{
+    if (!info.open) return GIF_ERR_NOT_OPEN;
+    int32_t wait = (int32_t)(due_ms - now_ms);
+    if (due_set && wait > 0) {
+        memcpy(frame, canvas, sizeof(canvas));
+        return wait;
+    }
+    int delay_ms = gif_next_frame(frame);
+    if (delay_ms < 0) return delay_ms;
+    // Scheduled from when the last frame was due, so waking late does not
+    // slow the animation down; after a stall longer than a frame it
+    // restarts from now rather than rushing to catch up.
+    due_ms = due_set && -wait < delay_ms ? due_ms + delay_ms : now_ms + delay_ms;
+    due_set = true;
+    return (int32_t)(due_ms - now_ms);
+}
+
+void gif_get_info(gif_info_t *out)
+{
+    *out = info;
+}
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+
+#define GIF_PARTITION_SUBTYPE 0x40
+#define GIF_STORE_MAGIC       0x4732334d    // "M32G"
+#define GIF_STORE_HEADER      16
+
+typedef struct {
+    uint32_t magic;
+    uint32_t length;
+} store_header_t;
+
+static const esp_partition_t *store_partition(void)
+{
+    static const esp_partition_t *part = NULL;
+    if (!part) {
+        part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                        (esp_partition_subtype_t)GIF_PARTITION_SUBTYPE, "gif");
+    }
+    return part;
+}
+
+static int store_read(void *ctx, uint32_t offset, void *dst, size_t len)
+{
+    return esp_partition_read(ctx, GIF_STORE_HEADER + offset, dst, len) != ESP_OK;
+}
+
+size_t gif_store_capacity(void)
+{
+    const esp_partition_t *part = store_partition();
+    return part ? part->size - GIF_STORE_HEADER : 0;
+}
+
+// Partition bytes erased so far in the current upload.
+static size_t erased_to;
+
+static esp_err_t erase_through(const esp_partition_t *part, size_t end)
+{
+    if (end <= erased_to) return ESP_OK;
+    size_t to = (end + part->erase_size - 1) / part->erase_size * part->erase_size;
+    esp_err_t err = esp_partition_erase_range(part, erased_to, to - erased_to);
+    if (err == ESP_OK) erased_to = to;
+    return err;
+}
+
+esp_err_t gif_store_begin(size_t len)
+{
+    const esp_partition_t *part = store_partition();
+    if (!part) return ESP_ERR_NOT_FOUND;
+    if (len > gif_store_capacity()) return ESP_ERR_INVALID_SIZE;
+    erased_to = 0;
+    return erase_through(part, GIF_STORE_HEADER);
+}
+
+esp_err_t gif_store_write(size_t offset, const void *data, size_t len)
+{
+    const esp_partition_t *part = store_partition();
+    if (!part) return ESP_ERR_NOT_FOUND;
+    esp_err_t err = erase_through(part, GIF_STORE_HEADER + offset + len);
+    if (err != ESP_OK) return err;
+    return esp_partition_write(part, GIF_STORE_HEADER + offset, data, len);
+}
+
+esp_err_t gif_store_finish(size_t len)
+{
+    const esp_partition_t *part = store_partition();
+    if (!part) return ESP_ERR_NOT_FOUND;
+    store_header_t header = { .magic = GIF_STORE_MAGIC, .length = len };
+    return esp_partition_write(part, 0, &header, sizeof(header));
+}
+
+esp_err_t gif_store_source(gif_source_t *src)
+{
+    const esp_partition_t *part = store_partition();
+    store_header_t header;
+    if (!part || esp_partition_read(part, 0, &header, sizeof(header)) != ESP_OK ||
+        header.magic != GIF_STORE_MAGIC || header.length > gif_store_capacity()) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *src = (gif_source_t){ .read = store_read, .ctx = (void *)part, .size = header.length };
+    return ESP_OK;
+}
+#endif
@@ -0,0 +1,95 @@
+#ifndef GIF_H
+#define GIF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Streaming animated GIF player. The file is read through a callback in
+// GIF_READ_CHUNK pieces and each frame is LZW-decoded straight into the
+// matrix geometry: source pixels are summed into the cell they fall in as
+// they come out of the decoder (box filter), or sampled when the GIF is
+// smaller than the matrix, so no full-size frame is ever held. Memory is
+// fixed at the decoder tables plus a few RGB_COUNT-sized buffers, whatever
+// the GIF's dimensions or frame count.
+//
+// Frames that cover only part of a cell, or are partly transparent, are
+// blended with what the cell showed, as if that part of the previous frame
+// had been the cell's colour. Disposal to background clears to black.
+//
+// One player; no locking, the render task makes every call.
+#ifndef GIF_READ_CHUNK
+#define GIF_READ_CHUNK 512
+#endif
+
+#define GIF_MIN_DELAY_MS     20     // faster frames play at GIF_DEFAULT_DELAY_MS,
+#define GIF_DEFAULT_DELAY_MS 100    // as browsers do
+
+enum {
+    GIF_ERR_NOT_OPEN = -1,
+    GIF_ERR_FORMAT = -2,        // not a GIF, or corrupt
+    GIF_ERR_TOO_LARGE = -3,     // a cell would cover too many source pixels
+    GIF_ERR_NO_FRAMES = -4,
+    GIF_ERR_READ = -5,
+};
+
+// Reads len bytes at offset; returns 0, or nonzero on failure.
+typedef int (*gif_read_fn)(void *ctx, uint32_t offset, void *dst, size_t len);
+
+typedef struct {
+    gif_read_fn read;
+    void *ctx;
+    uint32_t size;
+} gif_source_t;
+
+typedef struct {
+    bool open;
+    uint16_t width;             // logical screen
+    uint16_t height;
+    uint32_t size;              // bytes
+    uint32_t frame;             // index of the last frame shown
+    uint32_t loop_frames;       // frames per loop, 0 until the first loop ends
+    uint32_t loops;
+} gif_info_t;
+
+// Checks the signature and screen size in the first bytes of a file.
+// Returns 0 and sets width and height, or a GIF_ERR_ code.
+int gif_probe(const uint8_t *head, size_t len, uint16_t *width, uint16_t *height);
+
+// Starts playing src from its first frame. On error the player is closed.
+int gif_open(const gif_source_t *src);
+void gif_close(void);
+
+// Back to the first frame, on a black canvas, due at the next call.
+void gif_rewind(void);
+
+// Decodes the next frame into frame (RGB_COUNT pixels) and returns its
+// delay in ms, looping at the end of the file, or a GIF_ERR_ code (the
+// player is closed then).
+int gif_next_frame(pixel_color_t *frame);
+
+// As gif_next_frame(), but honours the frame delays whenever it is called:
+// until the current frame's delay has passed at now_ms it copies that frame
+// again. Returns the ms until the next frame is due, or a GIF_ERR_ code.
+int gif_frame_at(uint32_t now_ms, pixel_color_t *frame);
+
+void gif_get_info(gif_info_t *info);
+
+#ifdef ESP_PLATFORM
+#include "esp_err.h"
+
+// The uploaded file lives in the "gif" data partition behind a header that
+// is written last, so an interrupted upload leaves no file. Writes must come
+// in order; each erases the flash it reaches first, so a large upload is
+// not held up by one long erase.
+size_t gif_store_capacity(void);
+esp_err_t gif_store_begin(size_t len);
+esp_err_t gif_store_write(size_t offset, const void *data, size_t len);
+esp_err_t gif_store_finish(size_t len);
+
+// A source reading the stored file, or ESP_ERR_NOT_FOUND.
+esp_err_t gif_store_source(gif_source_t *src);
+#endif
+
+#endif // GIF_H
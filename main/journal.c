@@ -0,0 +1,214 @@
+#include <stdbool.h>
+#include <string.h>
+#include "journal.h"
+
+// A record is its entry count, the entries, then the count again so the
+// ring can be walked backwards from the undo cursor. An entry is the first
+// pixel and length of a run, then its old and new colour:
+//   u16 count | count x (u16 first, u16 run, old rgb, new rgb) | u16 count
+#define ENTRY_SIZE   10
+#define RECORD_EXTRA 4
+
+// Oldest record at ring_tail; undoable steps fill the next undo_bytes and
+// redoable ones the redo_bytes after that.
+static uint8_t ring[JOURNAL_BUFFER_SIZE];
+static size_t ring_tail = 0;
+static size_t undo_bytes = 0;
+static size_t redo_bytes = 0;
+static uint32_t undo_steps = 0;
+static uint32_t redo_steps = 0;
+static uint32_t dropped = 0;
+
+// The drawing as of the last commit, undo or redo.
+static pixel_color_t shadow[RGB_COUNT];
+
+// The drawing as the commit in progress saw it. Writers to the framebuffer
+// do not take the journal's lock, so it is read once and both encoding
+// passes work from this copy.
+static pixel_color_t snapshot[RGB_COUNT];
+
+static bool same_color(pixel_color_t a, pixel_color_t b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+static size_t wrap(size_t pos)
+{
+    return pos % JOURNAL_BUFFER_SIZE;
+}
+
+static void ring_read(size_t pos, uint8_t *dst, size_t len)
+{
+    size_t first = JOURNAL_BUFFER_SIZE - pos;
+    if (first > len) first = len;
+    memcpy(dst, ring + pos, first);
+    memcpy(dst + first, ring, len - first);
+}
+
+static void ring_write(size_t pos, const uint8_t *src, size_t len)
+{
+    size_t first = JOURNAL_BUFFER_SIZE - pos;
+    if (first > len) first = len;
+    memcpy(ring + pos, src, first);
+    memcpy(ring, src + first, len - first);
+}
+
+static uint16_t read_u16(size_t pos)
+{
+    uint8_t b[2];
+    ring_read(pos, b, 2);
+    return b[0] | (b[1] << 8);
+}
+
+static void write_u16(size_t pos, uint16_t v)
+{
+    uint8_t b[2] = { v & 0xff, v >> 8 };
+    ring_write(pos, b, 2);
+}
+
+static size_t record_size(uint16_t entries)
+{
+    return RECORD_EXTRA + (size_t)entries * ENTRY_SIZE;
+}
+
+// Walks the runs that differ from the shadow. Only counts them unless
+// write is set, so the record can be sized before anything is evicted.
+static uint32_t encode(size_t pos, bool write, uint32_t *changed)
+{
+    uint32_t entries = 0;
+    *changed = 0;
+    for (int i = 0; i < RGB_COUNT; ) {
+        pixel_color_t old = shadow[i], cur = snapshot[i];
+        if (same_color(old, cur)) {
+            i++;
+            continue;
+        }
+        int run = 1;
+        while (i + run < RGB_COUNT && same_color(shadow[i + run], old) &&
+               same_color(snapshot[i + run], cur)) {
+            run++;
+        }
+        if (write) {
+            uint8_t entry[ENTRY_SIZE] = {
+                i & 0xff, i >> 8, run & 0xff, run >> 8,
+                old.r, old.g, old.b, cur.r, cur.g, cur.b
+            };
+            ring_write(pos, entry, ENTRY_SIZE);
+            pos = wrap(pos + ENTRY_SIZE);
+        }
+        entries++;
+        *changed += run;
+        i += run;
+    }
+    return entries;
+}
+
+static void take_snapshot(void)
+{
+    for (int i = 0; i < RGB_COUNT; i++) {
+        snapshot[i] = framebuffer_pixel(i / MATRIX_COLS, i % MATRIX_COLS);
+    }
+}
+
+static void drop_oldest(void)
+{
+    size_t len = record_size(read_u16(ring_tail));
+    ring_tail = wrap(ring_tail + len);
+    undo_bytes -= len;
+    undo_steps--;
+    dropped++;
+}
+
+int journal_commit(void)
+{
+    uint32_t changed;
+    take_snapshot();
+    uint32_t entries = encode(0, false, &changed);
+    if (entries == 0) return 0;
+
+    // A new step ends whatever could have been redone.
+    redo_bytes = 0;
+    redo_steps = 0;
+
+    size_t len = record_size(entries);
+    if (len > JOURNAL_BUFFER_SIZE) {
+        dropped += undo_steps;
+        ring_tail = 0;
+        undo_bytes = 0;
+        undo_steps = 0;
+        memcpy(shadow, snapshot, sizeof(shadow));
+        return changed;
+    }
+    while (JOURNAL_BUFFER_SIZE - undo_bytes < len) {
+        drop_oldest();
+    }
+
+    size_t start = wrap(ring_tail + undo_bytes);
+    write_u16(start, entries);
+    encode(wrap(start + 2), true, &changed);
+    write_u16(wrap(start + len - 2), entries);
+    undo_bytes += len;
+    undo_steps++;
+    memcpy(shadow, snapshot, sizeof(shadow));
+    return changed;
+}
+
+// Writes each entry's old (undo) or new (redo) colour over its run.
+static int apply(size_t pos, uint16_t entries, bool redo)
+{
+    framebuffer_to_rgb();
+    int pixels = 0;
+    for (uint16_t n = 0; n < entries; n++) {
+        uint8_t e[ENTRY_SIZE];
+        ring_read(pos, e, ENTRY_SIZE);
+        pos = wrap(pos + ENTRY_SIZE);
+        int first = e[0] | (e[1] << 8);
+        int run = e[2] | (e[3] << 8);
+        pixel_color_t c = redo ? (pixel_color_t){ e[7], e[8], e[9] }
+                               : (pixel_color_t){ e[4], e[5], e[6] };
+        for (int i = first; i < first + run && i < RGB_COUNT; i++) {
+            framebuffer[i / MATRIX_COLS][i % MATRIX_COLS] = c;
+            shadow[i] = c;
+        }
+        pixels += run;
+    }
+    return pixels;
+}
+
+int journal_undo(void)
+{
+    if (undo_steps == 0) return -1;
+    size_t end = wrap(ring_tail + undo_bytes);
+    uint16_t entries = read_u16(wrap(end + JOURNAL_BUFFER_SIZE - 2));
+    size_t len = record_size(entries);
+    size_t start = wrap(end + JOURNAL_BUFFER_SIZE - len);
+    int pixels = apply(wrap(start + 2), entries, false);
+    undo_bytes -= len;
+    redo_bytes += len;
+    undo_steps--;
+    redo_steps++;
+    return pixels;
+}
+
+int journal_redo(void)
+{
+    if (redo_steps == 0) return -1;
+    size_t start = wrap(ring_tail + undo_bytes);
+    uint16_t entries = read_u16(start);
+    size_t len = record_size(entries);
+    int pixels = apply(wrap(start + 2), entries, true);
+    undo_bytes += len;
+    redo_bytes -= len;
+    undo_steps++;
+    redo_steps--;
+    return pixels;
+}
+
+void journal_get_stats(journal_stats_t *stats)
+{
+    stats->undo_steps = undo_steps;
+    stats->redo_steps = redo_steps;
+    stats->bytes_used = undo_bytes + redo_bytes;
+    stats->buffer_size = JOURNAL_BUFFER_SIZE;
+    stats->dropped = dropped;
+}
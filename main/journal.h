@@ -0,0 +1,45 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Undo history for the drawing (the framebuffer). Each committed change is
+// stored as the pixels it touched, never as a snapshot: runs of consecutive
+// pixels that went from one colour to one other colour share an entry, so
+// a fill over a plain background costs a single entry.
+//
+// Records live in a fixed ring of JOURNAL_BUFFER_SIZE bytes; the oldest
+// steps are dropped to make room, and a change too large for the whole ring
+// clears the history instead of being recorded.
+//
+// Indexed frames are journaled as the colours they showed, so undoing past
+// an indexed upload leaves an rgb framebuffer.
+//
+// No locking: led_control serialises every call.
+#ifndef JOURNAL_BUFFER_SIZE
+#define JOURNAL_BUFFER_SIZE (16 * 1024)
+#endif
+
+typedef struct {
+    uint32_t undo_steps;
+    uint32_t redo_steps;
+    uint32_t bytes_used;
+    uint32_t buffer_size;
+    uint32_t dropped;           // steps lost to make room
+} journal_stats_t;
+
+// Records whatever changed in the framebuffer since the last commit, undo
+// or redo as one step, and discards anything there was to redo. Changes
+// made while it runs go into the next step. Returns the number of pixels
+// that changed (0 records nothing).
+int journal_commit(void);
+
+// Steps the framebuffer back or forward by one commit, touching only the
+// pixels that commit changed. Return that count, or -1 if there is no step.
+int journal_undo(void);
+int journal_redo(void);
+
+void journal_get_stats(journal_stats_t *stats);
+
+#endif // JOURNAL_H
@@ -0,0 +1,97 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "cJSON.h"
+#include "json_arena.h"
+
+// Where allocations go that no arena takes. The host soak test points
+// these at its heap model.
+#ifndef JSON_ARENA_MALLOC
+#define JSON_ARENA_MALLOC malloc
+#define JSON_ARENA_FREE   free
+#endif
+
+#define ALIGN 8
+
+typedef struct {
+    size_t used;
+    uint32_t requests;
+    uint32_t high_water;
+    uint32_t overflow;
+} arena_t;
+
+static _Alignas(ALIGN) uint8_t memory[JSON_ARENA_COUNT][JSON_ARENA_SIZE];
+static arena_t arenas[JSON_ARENA_COUNT];
+static atomic_bool taken[JSON_ARENA_COUNT];
+static atomic_uint unserved;
+
+// The calling task's arena, if it is inside a request that got one.
+static __thread arena_t *current = NULL;
+static __thread int depth = 0;
+
+static void *arena_malloc(size_t size)
+{
+    arena_t *a = current;
+    if (a) {
+        size_t need = (size + ALIGN - 1) & ~(size_t)(ALIGN - 1);
+        if (need <= JSON_ARENA_SIZE - a->used) {
+            void *p = memory[a - arenas] + a->used;
+            a->used += need;
+            return p;
+        }
+        a->overflow++;
+    }
+    return JSON_ARENA_MALLOC(size);
+}
+
+static void arena_free(void *p)
+{
+    const uint8_t *byte = p;
+    if (byte >= &memory[0][0] && byte < &memory[0][0] + sizeof(memory)) return;
+    JSON_ARENA_FREE(p);
+}
+
+void json_arena_init(void)
+{
+    cJSON_Hooks hooks = { .malloc_fn = arena_malloc, .free_fn = arena_free };
+    cJSON_InitHooks(&hooks);
+}
+
+void json_arena_begin(void)
+{
+    if (depth++ > 0) return;
+    for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+        if (!atomic_exchange(&taken[i], true)) {
+            current = &arenas[i];
+            current->used = 0;
+            return;
+        }
+    }
+    atomic_fetch_add(&unserved, 1);
+}
+
+void json_arena_end(void)
+{
+    if (depth == 0 || --depth > 0) return;
+    arena_t *a = current;
+    if (!a) return;
+    current = NULL;
+    a->requests++;
+    if (a->used > a->high_water) a->high_water = a->used;
+    atomic_store(&taken[a - arenas], false);
+}
+
+void json_arena_get_stats(json_arena_stats_t *stats)
+{
+    *stats = (json_arena_stats_t){
+        .arena_size = JSON_ARENA_SIZE,
+        .arena_count = JSON_ARENA_COUNT,
+        .unserved = atomic_load(&unserved),
+    };
+    for (int i = 0; i < JSON_ARENA_COUNT; i++) {
+        stats->in_use += atomic_load(&taken[i]);
+        stats->requests += arenas[i].requests;
+        stats->overflow += arenas[i].overflow;
+        if (arenas[i].high_water > stats->high_water) stats->high_water = arenas[i].high_water;
+    }
+}
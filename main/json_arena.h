@@ -0,0 +1,42 @@
+#ifndef JSON_ARENA_H
+#define JSON_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator behind cJSON for the length of one request. A request
+// claims an arena, every cJSON allocation on its task comes from that
+// arena, frees are no-ops, and the whole arena is reset when the request
+// ends, so parsing and printing JSON never leave holes in the heap.
+//
+// Anything allocated in a request must be done with by json_arena_end():
+// cJSON strings are freed with cJSON_free(), never free(). Allocations the
+// arena cannot take, and cJSON use outside any request, go to the heap.
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE  (12 * 1024)
+#endif
+#ifndef JSON_ARENA_COUNT
+#define JSON_ARENA_COUNT 3          // the httpd task and two async workers
+#endif
+
+typedef struct {
+    uint32_t arena_size;
+    uint32_t arena_count;
+    uint32_t in_use;
+    uint32_t requests;          // ran with an arena
+    uint32_t unserved;          // found every arena taken
+    uint32_t high_water;        // most bytes one request used
+    uint32_t overflow;          // allocations that did not fit
+} json_arena_stats_t;
+
+// Installs the cJSON hooks.
+void json_arena_init(void);
+
+// Brackets one request on the calling task. Nested calls are counted, so
+// a handler that calls another shares its arena.
+void json_arena_begin(void);
+void json_arena_end(void);
+
+void json_arena_get_stats(json_arena_stats_t *stats);
+
+#endif // JSON_ARENA_H
@@ -0,0 +1,273 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_timer.h"
+#include "ws2812.h"
+#include "latency.h"
+
+typedef enum {
+    OPEN_FREE = 0,
+    OPEN_PENDING,           // waiting for a frame
+    OPEN_CLAIMED,           // in the frame being rendered
+    OPEN_SENT,              // in the frame on the wire
+} open_state_t;
+
+typedef struct {
+    latency_trace_t trace;
+    uint8_t state;
+    uint32_t frame;         // ws2812 frame count once it is out
+} open_trace_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+    uint32_t hist[LATENCY_BUCKETS];
+} series_t;
+
+static const char *const stage_names[LATENCY_STAGE_COUNT] = {
+    [LATENCY_RECV] = "recv",
+    [LATENCY_PARSE] = "parse",
+    [LATENCY_APPLY] = "apply",
+    [LATENCY_WAKE] = "wake",
+    [LATENCY_RENDER] = "render",
+    [LATENCY_QUEUE] = "queue",
+    [LATENCY_TRANSMIT] = "transmit",
+};
+
+static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+static uint32_t next_id = 1;
+static open_trace_t open_traces[LATENCY_MAX_OPEN];
+static series_t series[LATENCY_STAGE_COUNT + 1];
+static latency_trace_t recent[LATENCY_RECENT];
+static uint32_t completed = 0;
+static uint32_t dropped = 0;
+
+// Values below 4 us get a bucket each; above that, each power of two is
+// split in four.
+static int bucket_of(uint32_t us)
+{
+    if (us < 4) return us;
+    int octave = 31 - __builtin_clz(us);
+    int bucket = 4 * (octave - 1) + ((us >> (octave - 2)) & 3);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+uint32_t latency_bucket_limit_us(int bucket)
+{
+    if (bucket < 4) return bucket + 1;
+    int octave = bucket / 4 + 1;
+    return (uint32_t)(5 + bucket % 4) << (octave - 2);
+}
+
+static uint32_t bucket_floor_us(int bucket)
+{
+    return bucket == 0 ? 0 : latency_bucket_limit_us(bucket - 1);
+}
+
+static void series_add(series_t *s, int64_t us)
+{
+    uint32_t v = us < 0 ? 0 : us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    s->count++;
+    s->sum_us += v;
+    if (v > s->max_us) s->max_us = v;
+    s->hist[bucket_of(v)]++;
+}
+
+static uint32_t quantile(const series_t *s, uint32_t permille)
+{
+    if (s->count == 0) return 0;
+    uint32_t rank = (uint32_t)(((uint64_t)s->count * permille + 999) / 1000);
+    uint32_t seen = 0;
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += s->hist[b];
+        if (seen >= rank) {
+            uint32_t lo = bucket_floor_us(b), hi = latency_bucket_limit_us(b);
+            uint32_t mid = lo + (hi - lo) / 2;
+            return mid < s->max_us ? mid : s->max_us;
+        }
+    }
+    return s->max_us;
+}
+
+void latency_begin(latency_trace_t *trace)
+{
+    memset(trace, 0, sizeof(*trace));
+    portENTER_CRITICAL(&lock);
+    trace->id = next_id++;
+    portEXIT_CRITICAL(&lock);
+    trace->start_us = esp_timer_get_time();
+}
+
+void latency_stamp(latency_trace_t *trace, latency_stage_t stage)
+{
+    int64_t now = esp_timer_get_time();
+    for (int s = 0; s <= (int)stage; s++) {
+        if (trace->end_us[s] == 0) trace->end_us[s] = now;
+    }
+}
+
+void latency_submit(const latency_trace_t *trace)
+{
+    portENTER_CRITICAL(&lock);
+    // A full set loses its oldest trace (lowest id).
+    open_trace_t *slot = NULL;
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        open_trace_t *o = &open_traces[i];
+        if (o->state == OPEN_FREE) {
+            slot = o;
+            break;
+        }
+        if (!slot || o->trace.id < slot->trace.id) slot = o;
+    }
+    if (slot->state != OPEN_FREE) dropped++;
+    slot->trace = *trace;
+    slot->state = OPEN_PENDING;
+    portEXIT_CRITICAL(&lock);
+}
+
+// Stamps every open trace in state from and moves it on to state to.
+static void advance(open_state_t from, open_state_t to, latency_stage_t stage, uint32_t frame)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        open_trace_t *o = &open_traces[i];
+        if (o->state != from) continue;
+        o->trace.end_us[stage] = now;
+        o->state = to;
+        o->frame = frame;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+// Completes the traces whose frame has finished going out. Also run when
+// reporting, as an idle render task may not start another frame for a while.
+static void finish_sent(void)
+{
+    ws2812_stats_t out;
+    ws2812_get_stats(&out);
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        open_trace_t *o = &open_traces[i];
+        if (o->state != OPEN_SENT || (int32_t)(out.frames - o->frame) < 0) continue;
+        latency_trace_t *t = &o->trace;
+        t->end_us[LATENCY_TRANSMIT] = out.last_done_us;
+        int64_t from = t->start_us;
+        for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+            series_add(&series[s], t->end_us[s] - from);
+            from = t->end_us[s];
+        }
+        series_add(&series[LATENCY_TOTAL], t->end_us[LATENCY_TRANSMIT] - t->start_us);
+        memmove(&recent[1], &recent[0], sizeof(recent) - sizeof(recent[0]));
+        recent[0] = *t;
+        completed++;
+        o->state = OPEN_FREE;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void latency_frame_start(void)
+{
+    finish_sent();
+    advance(OPEN_PENDING, OPEN_CLAIMED, LATENCY_WAKE, 0);
+}
+
+void latency_frame_encoded(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        if (open_traces[i].state == OPEN_CLAIMED) open_traces[i].trace.end_us[LATENCY_RENDER] = now;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void latency_frame_sending(void)
+{
+    finish_sent();
+    ws2812_stats_t out;
+    ws2812_get_stats(&out);
+    advance(OPEN_CLAIMED, OPEN_SENT, LATENCY_QUEUE, out.frames + 1);
+}
+
+static void drop(open_state_t state)
+{
+    portENTER_CRITICAL(&lock);
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        if (open_traces[i].state == state) {
+            open_traces[i].state = OPEN_FREE;
+            dropped++;
+        }
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void latency_frame_failed(void)
+{
+    drop(OPEN_SENT);
+}
+
+void latency_frame_skipped(void)
+{
+    drop(OPEN_CLAIMED);
+}
+
+const char *latency_stage_name(latency_stage_t stage)
+{
+    return stage < LATENCY_STAGE_COUNT ? stage_names[stage] : "total";
+}
+
+void latency_get_summary(int index, latency_summary_t *out)
+{
+    portENTER_CRITICAL(&lock);
+    const series_t *s = &series[index];
+    *out = (latency_summary_t){
+        .count = s->count,
+        .mean_us = s->count ? (uint32_t)(s->sum_us / s->count) : 0,
+        .p50_us = quantile(s, 500),
+        .p99_us = quantile(s, 990),
+        .max_us = s->max_us,
+    };
+    portEXIT_CRITICAL(&lock);
+}
+
+void latency_get_histogram(uint32_t hist[LATENCY_BUCKETS])
+{
+    portENTER_CRITICAL(&lock);
+    memcpy(hist, series[LATENCY_TOTAL].hist, sizeof(series[LATENCY_TOTAL].hist));
+    portEXIT_CRITICAL(&lock);
+}
+
+void latency_get_counts(latency_counts_t *out)
+{
+    finish_sent();
+    portENTER_CRITICAL(&lock);
+    out->completed = completed;
+    out->dropped = dropped;
+    out->open = 0;
+    for (int i = 0; i < LATENCY_MAX_OPEN; i++) {
+        out->open += open_traces[i].state != OPEN_FREE;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+int latency_get_recent(latency_trace_t *out, int max)
+{
+    finish_sent();
+    portENTER_CRITICAL(&lock);
+    int n = completed < LATENCY_RECENT ? (int)completed : LATENCY_RECENT;
+    if (n > max) n = max;
+    memcpy(out, recent, n * sizeof(recent[0]));
+    portEXIT_CRITICAL(&lock);
+    return n;
+}
+
+void latency_reset(void)
+{
+    portENTER_CRITICAL(&lock);
+    memset(series, 0, sizeof(series));
+    memset(recent, 0, sizeof(recent));
+    completed = 0;
+    dropped = 0;
+    portEXIT_CRITICAL(&lock);
+}
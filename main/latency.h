@@ -0,0 +1,92 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Input-to-photon tracing for drawing requests. A handler starts a trace
+// when the request arrives and stamps the end of each stage it runs, then
+// submits it once the change is in the framebuffer. The render task stamps
+// the frame that picks it up and the RMT transmission carrying that frame,
+// and the trace completes when the transmission (latch included) is out.
+//
+// Stages, each ending at its own stamp:
+typedef enum {
+    LATENCY_RECV = 0,       // request body received
+    LATENCY_PARSE,          // JSON parsed
+    LATENCY_APPLY,          // framebuffer written, undo step recorded
+    LATENCY_WAKE,           // render task starts a frame that includes it
+    LATENCY_RENDER,         // layers composed and encoded to wire bytes
+    LATENCY_QUEUE,          // previous frame off the wire, this one starts
+    LATENCY_TRANSMIT,       // RMT transmission and latch complete
+    LATENCY_STAGE_COUNT
+} latency_stage_t;
+
+#define LATENCY_TOTAL    LATENCY_STAGE_COUNT   // series index for end to end
+#define LATENCY_MAX_OPEN 16     // submitted traces not yet on the LEDs
+#define LATENCY_RECENT   8      // completed traces kept for GET /latency
+#define LATENCY_BUCKETS  96     // 4 per power of two, 1 us to ~30 s
+
+typedef struct {
+    uint32_t id;
+    int64_t start_us;
+    int64_t end_us[LATENCY_STAGE_COUNT];
+} latency_trace_t;
+
+typedef struct {
+    uint32_t count;
+    uint32_t mean_us;
+    uint32_t p50_us;            // bucket midpoints, so within ~12%
+    uint32_t p99_us;
+    uint32_t max_us;
+} latency_summary_t;
+
+typedef struct {
+    uint32_t completed;
+    uint32_t dropped;           // pushed out of the open set unfinished,
+                                // or their frame was not sent
+    uint32_t open;
+} latency_counts_t;
+
+// Gives the trace a new id and starts it now.
+void latency_begin(latency_trace_t *trace);
+
+// Ends a request-side stage now. Stages skipped by a handler (no JSON to
+// parse) are stamped together with the next one.
+void latency_stamp(latency_trace_t *trace, latency_stage_t stage);
+
+// Hands a trace whose change is in the framebuffer to the render task.
+void latency_submit(const latency_trace_t *trace);
+
+// Render task, once per frame: at its start, once its wire bytes are
+// ready, and around ws2812_send() (after the previous frame has finished).
+// Traces must be submitted before the render task is woken for them, or
+// an earlier frame may claim them.
+void latency_frame_start(void);
+void latency_frame_encoded(void);
+void latency_frame_sending(void);
+void latency_frame_failed(void);
+
+// The frame turned out to change nothing and was not sent. Its traces are
+// dropped rather than left for a later frame, which in static mode may
+// only come with the next request.
+void latency_frame_skipped(void);
+
+const char *latency_stage_name(latency_stage_t stage);
+
+// Summary of one stage, or of LATENCY_TOTAL.
+void latency_get_summary(int series, latency_summary_t *out);
+
+// End-to-end histogram counts; bucket b holds totals below
+// latency_bucket_limit_us(b).
+void latency_get_histogram(uint32_t hist[LATENCY_BUCKETS]);
+uint32_t latency_bucket_limit_us(int bucket);
+
+void latency_get_counts(latency_counts_t *out);
+
+// Most recent completed traces, newest first. Returns how many.
+int latency_get_recent(latency_trace_t *out, int max);
+
+void latency_reset(void);
+
+#endif // LATENCY_H
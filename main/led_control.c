@@ -1,143 +1,528 @@
 #include <stdio.h>
-#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/rmt_tx.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
-#include "led_strip.h"
 #include "matrix_state.h"
 #include "led_control.h"
+#include "effects.h"
+#include "playlist.h"
+#include "recorder.h"
+#include "compositor.h"
+#include "tween.h"
+#include "noise.h"
+#include "calibration.h"
+#include "pixel_pipeline.h"
+#include "ws2812.h"
+#include "profiler.h"
+#include "frame_cache.h"
+#include "journal.h"
+#include "gif.h"
+#include "latency.h"
+#include "esp_timer.h"
+#include "esp_random.h"
 
 static const char *TAG = "matrix32";
 
+// Program for MODE_EXPR. Swapped in by the web server, copied out by the
+// render task at the start of each frame.
+static expr_program_t expr_program;
+static portMUX_TYPE expr_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t mode_task = NULL;
+
+// Colour calibration, double-buffered: the render task uses *calibration
+// while a new table is copied into the other one, which it switches to at
+// the next frame once calibration_pending points at it. The lock only
+// covers the pointers; calibration_mutex lets one writer at a time have
+// the spare table.
+static calibration_t calibration_tables[2];
+static calibration_t *calibration = &calibration_tables[0];
+static calibration_t *volatile calibration_pending = NULL;
+static portMUX_TYPE calibration_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t calibration_mutex = NULL;
+
+// A batch handed to the render task, applied between two frames while the
+// submitter waits. batch_mutex lets one batch through at a time.
+static const batch_t *pending_batch = NULL;
+static portMUX_TYPE batch_lock = portMUX_INITIALIZER_UNLOCKED;
+static SemaphoreHandle_t batch_mutex = NULL;
+static SemaphoreHandle_t batch_done = NULL;
+
+// Serialises the undo journal between the web server and the render task
+// (batches commit from there).
+static SemaphoreHandle_t journal_mutex = NULL;
+
+// Set when the stored GIF changed; the render task reopens it before its
+// next frame. Starts set so a GIF stored earlier plays after a reboot.
+static volatile bool gif_reload = true;
+
+// Bumped by every change to what is displayed.
+static volatile uint32_t state_version = 0;
+
+// Set when static content changed and the panel needs a redraw.
+static volatile bool static_dirty = true;
+
+// Tweens are started by the web server and advanced by the render task.
+static portMUX_TYPE tween_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// Cross-fade settings for the next mode change, and the fade in progress.
+static volatile uint16_t mode_fade_request_ms = LED_DEFAULT_MODE_TRANSITION_MS;
+static volatile uint8_t mode_fade_request_easing = EASE_IN_OUT;
+static bool mode_fading = false;
+static display_mode_t fade_from_mode;
+static uint32_t fade_start_ms;
+static uint16_t fade_ms;
+static uint8_t fade_easing;
+static pixel_color_t fade_frame[RGB_COUNT];
+
 void rgb_init(void)
 {
-    led_strip_config_t strip_config = {
-        .strip_gpio_num = RGB_CONTROL_PIN,
-        .max_leds = RGB_COUNT,
-        .led_pixel_format = LED_PIXEL_FORMAT_GRB,
-        .led_model = LED_MODEL_WS2812
-    };
-    
-    led_strip_rmt_config_t rmt_config = {
-        .resolution_hz = 10 * 1000 * 1000,
-        .flags.with_dma = false
-    };
-    
     ESP_LOGI(TAG, "Initializing LED strip on GPIO %d", RGB_CONTROL_PIN);
-    esp_err_t err = led_strip_new_rmt_device(&strip_config, &rmt_config, &strip);
+    esp_err_t err = ws2812_init(RGB_CONTROL_PIN);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "LED strip init failed: %s", esp_err_to_name(err));
     }
-    rmt_mutex = xSemaphoreCreateMutex();
+    ESP_ERROR_CHECK(recorder_init());
+    compositor_init();
+    tween_init();
+    profiler_init();
+
+    effects_init();
+    prng_seed(esp_random());
+
+    batch_mutex = xSemaphoreCreateMutex();
+    batch_done = xSemaphoreCreateBinary();
+    journal_mutex = xSemaphoreCreateMutex();
+    calibration_mutex = xSemaphoreCreateMutex();
+
+    err = calibration_load(calibration);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Stored calibration ignored: %s", esp_err_to_name(err));
+    }
 }
 
-void update_display(void)
+void led_set_calibration(const calibration_t *cal)
 {
-    ESP_LOGI(TAG, "Attempting display update");
-    
-    if (current_mode == MODE_STATIC) {
-        for (int row = 0; row < MATRIX_ROWS; row++) {
-            for (int col = 0; col < MATRIX_COLS; col++) {
-                int led_index = row * MATRIX_COLS + col;
-                pixel_color_t color = framebuffer[row][col];
-                ESP_ERROR_CHECK(led_strip_set_pixel(strip, led_index,
-                    scale_brightness(color.g),
-                    scale_brightness(color.r),
-                    scale_brightness(color.b)));
-            }
+    xSemaphoreTake(calibration_mutex, portMAX_DELAY);
+    // Withdraw a table not yet picked up, so the spare is ours to fill.
+    portENTER_CRITICAL(&calibration_lock);
+    calibration_pending = NULL;
+    calibration_t *spare = calibration == &calibration_tables[0] ? &calibration_tables[1] : &calibration_tables[0];
+    portEXIT_CRITICAL(&calibration_lock);
+
+    spare->format = cal->format;
+    memcpy(spare->coef, cal->coef, sizeof(cal->coef));
+    spare->fused_brightness = -1;
+
+    portENTER_CRITICAL(&calibration_lock);
+    calibration_pending = spare;
+    portEXIT_CRITICAL(&calibration_lock);
+    xSemaphoreGive(calibration_mutex);
+    update_display();
+}
+
+// Only verified programs reach the render task. Bytecode is straight-line,
+// so a frame costs at most EXPR_MAX_INSNS steps per pixel whatever the source.
+esp_err_t led_set_expression(const expr_program_t *prog)
+{
+    if (expr_validate(prog) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    portENTER_CRITICAL(&expr_lock);
+    expr_program = *prog;
+    portEXIT_CRITICAL(&expr_lock);
+    return ESP_OK;
+}
+
+// Sends a finished frame to the strip through the pixel pipeline
+// (brightness, calibration, byte order and wiring) and hands what was sent
+// to the flight recorder. The pipeline writes one wire buffer while the
+// RMT channel may still be sending the other, so rendering the next frame
+// never waits on the previous one going out.
+static void output_frame(const pixel_color_t *frame, uint8_t mode, recorder_source_t source)
+{
+    static pixel_color_t sent[RGB_COUNT];
+    static uint8_t wire[2][PIXEL_PIPELINE_BYTES];
+    static int back = 0;
+    if (calibration_pending) {
+        portENTER_CRITICAL(&calibration_lock);
+        if (calibration_pending) {
+            calibration = calibration_pending;
+            calibration_pending = NULL;
         }
+        portEXIT_CRITICAL(&calibration_lock);
+    }
+    pixel_pipeline_run(frame, calibration, current_brightness, sent, wire[back]);
+    latency_frame_encoded();
+    // Waited for here rather than in ws2812_send() so traced requests can
+    // tell this wait from the transmission.
+    ws2812_wait(100);
+    latency_frame_sending();
+    esp_err_t ret = ws2812_send(wire[back], PIXEL_PIPELINE_BYTES);
+    if (ret != ESP_OK) {
+        latency_frame_failed();
+        ESP_LOGE(TAG, "Refresh failed: %s", esp_err_to_name(ret));
+    }
+    back ^= 1;
+    recorder_record(sent, mode, source);
+}
+
+// Called by the web server after it changes the framebuffer, palette or
+// brightness. Rendering and the RMT refresh happen on the render task, so
+// request handlers never wait for the strip.
+void update_display(void)
+{
+    static_dirty = true;
+    state_version++;
+    led_request_frame();
+}
+
+void led_update_drawing(latency_trace_t *trace)
+{
+    if (trace) {
+        latency_stamp(trace, LATENCY_APPLY);
+        latency_submit(trace);
     }
+    update_display();
+}
+
+void led_commit_drawing(latency_trace_t *trace)
+{
+    xSemaphoreTake(journal_mutex, portMAX_DELAY);
+    journal_commit();
+    xSemaphoreGive(journal_mutex);
+    led_update_drawing(trace);
+}
+
+static int journal_step(int (*step)(void))
+{
+    xSemaphoreTake(journal_mutex, portMAX_DELAY);
+    int pixels = step();
+    xSemaphoreGive(journal_mutex);
+    if (pixels >= 0) update_display();
+    return pixels;
+}
+
+int led_undo(void)
+{
+    return journal_step(journal_undo);
+}
+
+int led_redo(void)
+{
+    return journal_step(journal_redo);
+}
+
+void led_journal_stats(journal_stats_t *stats)
+{
+    xSemaphoreTake(journal_mutex, portMAX_DELAY);
+    journal_get_stats(stats);
+    xSemaphoreGive(journal_mutex);
+}
 
-    if (xSemaphoreTake(rmt_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        ESP_LOGI(TAG, "Mutex acquired, refreshing strip");
-        esp_err_t ret = led_strip_refresh(strip);
-        xSemaphoreGive(rmt_mutex);
-        
-        if (ret != ESP_OK) {
-            ESP_LOGE(TAG, "Refresh failed: %s", esp_err_to_name(ret));
+uint32_t led_state_version(void)
+{
+    return state_version;
+}
+
+void led_request_frame(void)
+{
+    if (mode_task) {
+        xTaskNotifyGive(mode_task);
+    }
+}
+
+uint32_t led_now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+void led_tween(void *target, tween_type_t type, int32_t to, uint32_t duration_ms, easing_t easing)
+{
+    portENTER_CRITICAL(&tween_lock);
+    tween_start(target, type, to, duration_ms, easing, led_now_ms());
+    portEXIT_CRITICAL(&tween_lock);
+    state_version++;
+    led_request_frame();
+}
+
+void led_set_mode(display_mode_t mode, uint32_t transition_ms, easing_t easing)
+{
+    mode_fade_request_ms = transition_ms > UINT16_MAX ? UINT16_MAX : transition_ms;
+    mode_fade_request_easing = easing;
+    current_mode = mode;
+    state_version++;
+    led_request_frame();
+}
+
+esp_err_t led_apply_batch(const batch_t *batch, uint32_t *version)
+{
+    if (xSemaphoreTake(batch_mutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    portENTER_CRITICAL(&batch_lock);
+    pending_batch = batch;
+    portEXIT_CRITICAL(&batch_lock);
+    led_request_frame();
+
+    esp_err_t err = ESP_OK;
+    if (xSemaphoreTake(batch_done, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        // Withdraw it, unless the render task picked it up just now.
+        portENTER_CRITICAL(&batch_lock);
+        bool taken = pending_batch == NULL;
+        pending_batch = NULL;
+        portEXIT_CRITICAL(&batch_lock);
+        if (taken) {
+            xSemaphoreTake(batch_done, portMAX_DELAY);
+        } else {
+            err = ESP_ERR_TIMEOUT;
         }
-    } else {
-        ESP_LOGW(TAG, "Failed to acquire RMT mutex");
     }
+    *version = state_version;
+    xSemaphoreGive(batch_mutex);
+    return err;
 }
 
-void mode_update_task(void *param) {
-    ESP_LOGI(TAG, "Mode task started");
-    float hue_offset = 0;
-    while (1) {
-        ESP_LOGI(TAG, "Mode loop iteration - current mode: %d", current_mode);
-        switch (current_mode) {
-            case MODE_STATIC:
-                vTaskDelay(100 / portTICK_PERIOD_MS);
+static uint32_t batch_transition(const batch_cmd_t *cmd, uint32_t default_ms)
+{
+    return cmd->transition_ms == BATCH_DEFAULT_TRANSITION ? default_ms : cmd->transition_ms;
+}
+
+// Render task, between frames: settings first, under the tween lock so
+// every tween starts on the same tick, then the drawing.
+static void apply_batch(const batch_t *batch)
+{
+    uint32_t now = led_now_ms();
+    portENTER_CRITICAL(&tween_lock);
+    for (int i = 0; i < batch->count; i++) {
+        const batch_cmd_t *cmd = &batch->cmds[i];
+        uint32_t ms = batch_transition(cmd, LED_DEFAULT_TRANSITION_MS);
+        pixel_color_t *color = cmd->op == BATCH_PRIMARY ? &current_color : &secondary_color;
+        switch (cmd->op) {
+            case BATCH_MODE:
+                ms = batch_transition(cmd, LED_DEFAULT_MODE_TRANSITION_MS);
+                mode_fade_request_ms = ms > UINT16_MAX ? UINT16_MAX : ms;
+                mode_fade_request_easing = cmd->easing;
+                current_mode = cmd->mode;
                 break;
-            case MODE_RAINBOW:
-                for (int i = 0; i < RGB_COUNT; i++) {
-                    float h = fmodf(hue_offset + (i * (360.0f / RGB_COUNT)), 360.0f);
-                    uint8_t r_val, g_val, b_val;
-                    hsv2rgb(h, 1.0f, 1.0f, &r_val, &g_val, &b_val);
-                    ESP_ERROR_CHECK(led_strip_set_pixel(strip, i, 
-                        scale_brightness(g_val),
-                        scale_brightness(r_val),
-                        scale_brightness(b_val)));
-                }
-                ESP_ERROR_CHECK(led_strip_refresh(strip));
-                hue_offset += 2.0f;
-                if (hue_offset >= 360.0f) hue_offset -= 360.0f;
-                vTaskDelay(50 / portTICK_PERIOD_MS);
+            case BATCH_PRIMARY:
+            case BATCH_SECONDARY:
+                tween_start(&color->r, TWEEN_U8, cmd->color.r, ms, cmd->easing, now);
+                tween_start(&color->g, TWEEN_U8, cmd->color.g, ms, cmd->easing, now);
+                tween_start(&color->b, TWEEN_U8, cmd->color.b, ms, cmd->easing, now);
                 break;
-            case MODE_CHECKERBOARD:
-                for (int row = 0; row < MATRIX_ROWS; row++) {
-                    for (int col = 0; col < MATRIX_COLS; col++) {
-                        int led_index = row * MATRIX_COLS + col;
-                        pixel_color_t color;
-                        if ((row + col) % 2 == 0) {
-                            color = current_color;
-                        } else {
-                            color = secondary_color;
-                        }
-                        ESP_ERROR_CHECK(led_strip_set_pixel(strip, led_index,
-                            scale_brightness(color.g),
-                            scale_brightness(color.r),
-                            scale_brightness(color.b)));
-                    }
-                }
-                ESP_ERROR_CHECK(led_strip_refresh(strip));
-                vTaskDelay(500 / portTICK_PERIOD_MS);
+            case BATCH_BRIGHTNESS:
+                tween_start(&current_brightness, TWEEN_U8, cmd->brightness, ms, cmd->easing, now);
                 break;
-            case MODE_GRADIENT: {
-                static uint8_t gradient_offset = 0;
-                for (int row = 0; row < MATRIX_ROWS; row++) {
-                    for (int col = 0; col < MATRIX_COLS; col++) {
-                        int led_index = row * MATRIX_COLS + col;
-                        float factor = ((float)((col + gradient_offset) % MATRIX_COLS)) / (MATRIX_COLS - 1);
-                        uint8_t r = (uint8_t)(current_color.r * (1 - factor) + secondary_color.r * factor);
-                        uint8_t g = (uint8_t)(current_color.g * (1 - factor) + secondary_color.g * factor);
-                        uint8_t b = (uint8_t)(current_color.b * (1 - factor) + secondary_color.b * factor);
-                        r = scale_brightness(r);
-                        g = scale_brightness(g);
-                        b = scale_brightness(b);
-                        ESP_ERROR_CHECK(led_strip_set_pixel(strip, led_index, g, r, b));
-                    }
+            case BATCH_PARAMS:
+                if (cmd->params.speed >= 0) {
+                    tween_start(&effect_speed, TWEEN_U8, cmd->params.speed, ms, cmd->easing, now);
                 }
-                gradient_offset = (gradient_offset + 1) % MATRIX_COLS;
-                ESP_ERROR_CHECK(led_strip_refresh(strip));
-                vTaskDelay(100 / portTICK_PERIOD_MS);
-                break;
-            }
-            case MODE_RANDOM:
-                for (int i = 0; i < RGB_COUNT; i++) {
-                    uint8_t r_rand = (uint8_t)(rand() % 256);
-                    uint8_t g_rand = (uint8_t)(rand() % 256);
-                    uint8_t b_rand = (uint8_t)(rand() % 256);
-                    ESP_ERROR_CHECK(led_strip_set_pixel(strip, i,
-                        scale_brightness(g_rand),
-                        scale_brightness(r_rand),
-                        scale_brightness(b_rand)));
+                if (cmd->params.scale >= 0) {
+                    tween_start(&effect_scale, TWEEN_U8, cmd->params.scale, ms, cmd->easing, now);
                 }
-                ESP_ERROR_CHECK(led_strip_refresh(strip));
-                vTaskDelay(200 / portTICK_PERIOD_MS);
+                break;
+            default:
                 break;
         }
     }
-} 
\ No newline at end of file
+    portEXIT_CRITICAL(&tween_lock);
+
+    bool drawn = false;
+    for (int i = 0; i < batch->count; i++) {
+        const batch_cmd_t *cmd = &batch->cmds[i];
+        if (cmd->op == BATCH_FILL) {
+            framebuffer_to_rgb();
+            for (int j = 0; j < RGB_COUNT; j++) {
+                framebuffer[j / MATRIX_COLS][j % MATRIX_COLS] = cmd->color;
+            }
+            static_dirty = true;
+            drawn = true;
+        } else if (cmd->op == BATCH_PIXELS) {
+            framebuffer_to_rgb();
+            for (int j = cmd->pixels.first; j < cmd->pixels.first + cmd->pixels.count; j++) {
+                const batch_pixel_t *px = &batch->pixels[j];
+                framebuffer[px->row][px->col] = px->color;
+            }
+            static_dirty = true;
+            drawn = true;
+        }
+    }
+    // The whole batch is one undo step.
+    if (drawn) {
+        xSemaphoreTake(journal_mutex, portMAX_DELAY);
+        journal_commit();
+        xSemaphoreGive(journal_mutex);
+    }
+    state_version++;
+}
+
+static void take_batch(void)
+{
+    portENTER_CRITICAL(&batch_lock);
+    const batch_t *batch = pending_batch;
+    pending_batch = NULL;
+    portEXIT_CRITICAL(&batch_lock);
+    if (batch) {
+        apply_batch(batch);
+        xSemaphoreGive(batch_done);
+    }
+}
+
+void led_reload_gif(void)
+{
+    gif_reload = true;
+    update_display();
+}
+
+static void load_gif(void)
+{
+    gif_reload = false;
+    gif_source_t src;
+    if (gif_store_source(&src) != ESP_OK) {
+        gif_close();
+        return;
+    }
+    int err = gif_open(&src);
+    if (err < 0) {
+        ESP_LOGW(TAG, "Stored GIF ignored: error %d", err);
+    }
+}
+
+int led_render_mode(display_mode_t mode, pixel_color_t *frame)
+{
+    expr_program_t prog;
+    effect_ctx_t ctx = {
+        .time_ms = led_now_ms(),
+        .expr = NULL,
+        .speed = effect_speed,
+        .scale = effect_scale
+    };
+    if (mode == MODE_EXPR) {
+        portENTER_CRITICAL(&expr_lock);
+        prog = expr_program;
+        portEXIT_CRITICAL(&expr_lock);
+        ctx.expr = &prog;
+    }
+    if (!profiler_running()) {
+        return frame_cache_render(mode, &ctx, frame);
+    }
+    int64_t start = esp_timer_get_time();
+    int delay_ms = frame_cache_render(mode, &ctx, frame);
+    profiler_effect_time(mode, (uint32_t)(esp_timer_get_time() - start));
+    return delay_ms;
+}
+
+static bool is_framebuffer_mode(display_mode_t mode)
+{
+    return mode == MODE_STATIC || mode == MODE_PALETTE_CYCLE;
+}
+
+// Blends the outgoing mode, still animating, into the effect layer while a
+// mode change cross-fades.
+static int fade_effect_layer(pixel_color_t *effect, uint32_t now)
+{
+    uint32_t k = tween_ease(fade_easing, now - fade_start_ms, fade_ms) >> 8;
+    if (k >= 255) {
+        mode_fading = false;
+        return LED_TWEEN_FRAME_MS;
+    }
+    if (!is_framebuffer_mode(fade_from_mode)) {
+        led_render_mode(fade_from_mode, fade_frame);
+    }
+    for (int i = 0; i < RGB_COUNT; i++) {
+        effect[i].r = fade_frame[i].r + (((effect[i].r - fade_frame[i].r) * (int)k) >> 8);
+        effect[i].g = fade_frame[i].g + (((effect[i].g - fade_frame[i].g) * (int)k) >> 8);
+        effect[i].b = fade_frame[i].b + (((effect[i].b - fade_frame[i].b) * (int)k) >> 8);
+    }
+    return LED_TWEEN_FRAME_MS;
+}
+
+// Fills the effect and drawing layers for this frame and returns the frame
+// delay. The framebuffer modes have no effect of their own: their content
+// is the drawing layer, which palette cycling re-renders every frame.
+static int render_layers(display_mode_t mode, display_mode_t last_mode)
+{
+    int delay_ms = 100;
+    bool mode_changed = mode != last_mode;
+    uint32_t now = led_now_ms();
+    pixel_color_t *effect = compositor_layer(LAYER_EFFECT);
+
+    if (mode_changed) {
+        effects_enter(mode);
+        // No fade when coming back from a playlist (last_mode MODE_COUNT).
+        mode_fading = last_mode < MODE_COUNT && mode_fade_request_ms > 0;
+        if (mode_fading) {
+            fade_from_mode = last_mode;
+            fade_start_ms = now;
+            fade_ms = mode_fade_request_ms;
+            fade_easing = mode_fade_request_easing;
+            memset(fade_frame, 0, sizeof(fade_frame));
+        }
+    }
+
+    if (!is_framebuffer_mode(mode)) {
+        delay_ms = led_render_mode(mode, effect);
+    } else if (mode_changed || mode_fading) {
+        memset(effect, 0, RGB_COUNT * sizeof(pixel_color_t));
+    }
+    if (mode_fading) {
+        int fade_delay = fade_effect_layer(effect, now);
+        if (delay_ms > fade_delay) delay_ms = fade_delay;
+    }
+    if (!is_framebuffer_mode(mode) || mode_changed || mode_fading) {
+        compositor_mark_dirty(LAYER_EFFECT);
+    }
+
+    if (mode == MODE_PALETTE_CYCLE) {
+        static_dirty = false;
+        int cycle_delay = led_render_mode(mode, compositor_layer(LAYER_DRAWING));
+        if (delay_ms > cycle_delay) delay_ms = cycle_delay;
+        compositor_mark_dirty(LAYER_DRAWING);
+    } else if (static_dirty || mode_changed) {
+        // Clear the flag first so a change made while we copy is not lost.
+        static_dirty = false;
+        effects_render_framebuffer(compositor_layer(LAYER_DRAWING));
+        compositor_mark_dirty(LAYER_DRAWING);
+    }
+    return delay_ms;
+}
+
+void mode_update_task(void *param) {
+    ESP_LOGI(TAG, "Mode task started");
+    mode_task = xTaskGetCurrentTaskHandle();
+    pixel_color_t frame[RGB_COUNT];
+    display_mode_t last_mode = MODE_COUNT;
+    while (1) {
+        int delay_ms;
+        latency_frame_start();
+        take_batch();
+        if (gif_reload) load_gif();
+        if (playlist_render(frame, &delay_ms)) {
+            output_frame(frame, RECORDER_MODE_NONE, RECORDER_SOURCE_PLAYLIST);
+            last_mode = MODE_COUNT;
+        } else {
+            portENTER_CRITICAL(&tween_lock);
+            bool tweening = tween_tick(led_now_ms());
+            portEXIT_CRITICAL(&tween_lock);
+
+            display_mode_t mode = current_mode;
+            delay_ms = render_layers(mode, last_mode);
+            last_mode = mode;
+            if (tweening && delay_ms > LED_TWEEN_FRAME_MS) delay_ms = LED_TWEEN_FRAME_MS;
+            // Nothing changed in any layer (e.g. an idle static drawing) and
+            // no brightness tween running: the strip already shows this frame.
+            if (compositor_compose(frame) || tweening) {
+                output_frame(frame, mode, mode == MODE_STATIC ? RECORDER_SOURCE_HTTP : RECORDER_SOURCE_EFFECT);
+            } else {
+                latency_frame_skipped();
+            }
+        }
+        // Sleep until the next frame is due, or until someone (e.g. the
+        // playlist timer) asks for one early.
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(delay_ms));
+    }
+}
@@ -2,9 +2,70 @@
 #define LED_CONTROL_H
 
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "expr_vm.h"
+#include "matrix_state.h"
+#include "tween.h"
+#include "calibration.h"
+#include "batch.h"
+#include "journal.h"
+#include "latency.h"
+
+#define LED_DEFAULT_TRANSITION_MS      250
+#define LED_DEFAULT_MODE_TRANSITION_MS 400
+#define LED_TWEEN_FRAME_MS             16   // frame period while anything animates
 
 void rgb_init(void);
 void update_display(void);
 void mode_update_task(void *param);
+esp_err_t led_set_expression(const expr_program_t *prog);
+
+// effects_render() with the live render clock and expression program.
+int led_render_mode(display_mode_t mode, pixel_color_t *frame);
+
+// The render clock, in ms.
+uint32_t led_now_ms(void);
+
+// Animates a display parameter (brightness, a colour channel) to a new
+// value on the render clock; see tween.h.
+void led_tween(void *target, tween_type_t type, int32_t to, uint32_t duration_ms, easing_t easing);
+
+// Switches mode, cross-fading from the current one over transition_ms.
+void led_set_mode(display_mode_t mode, uint32_t transition_ms, easing_t easing);
+
+// Replaces the colour calibration from the next frame on.
+void led_set_calibration(const calibration_t *cal);
+
+// Hands a validated batch to the render task and waits until it has been
+// applied, all at once, before the next frame. version receives the state
+// version that results. Gives up with ESP_ERR_TIMEOUT if other batches or
+// the render task keep it waiting for about a second.
+esp_err_t led_apply_batch(const batch_t *batch, uint32_t *version);
+
+// update_display() for changes to the drawing: whatever changed since the
+// last commit becomes one undo step. trace, if not NULL, is stamped and
+// submitted after that and before the render task is woken.
+void led_commit_drawing(latency_trace_t *trace);
+
+// As led_commit_drawing() without the commit: the change becomes part of
+// the next undo step, so a stroke sent in several requests undoes as one.
+void led_update_drawing(latency_trace_t *trace);
+
+// Undoes or redoes one drawing step. Return the number of pixels changed,
+// or -1 if there was nothing to undo or redo.
+int led_undo(void);
+int led_redo(void);
+
+void led_journal_stats(journal_stats_t *stats);
+
+// Reopens the stored GIF (see gif.h) before the next frame, after an
+// upload.
+void led_reload_gif(void);
+
+// Counter bumped by every change to what is displayed.
+uint32_t led_state_version(void);
+
+// Wakes the render task so the next frame is produced immediately.
+void led_request_frame(void);
 
 #endif // LED_CONTROL_H 
\ No newline at end of file
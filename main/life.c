@@ -0,0 +1,258 @@
+#include <string.h>
+#include "life.h"
+#include "noise.h"
+
+#define COL0 0x0101010101010101ull
+#define COL7 0x8080808080808080ull
+#define AGE_COLORS 16
+
+typedef struct {
+    uint16_t birth;     // bit n: a dead cell with n neighbours is born
+    uint16_t survive;   // bit n: a live cell with n neighbours survives
+    bool brain;         // live cells go through a dying state instead
+} life_rule_def_t;
+
+static const life_rule_def_t rules[LIFE_RULE_COUNT] = {
+    [LIFE_RULE_LIFE]     = { .birth = 1 << 3,              .survive = (1 << 2) | (1 << 3) },
+    [LIFE_RULE_HIGHLIFE] = { .birth = (1 << 3) | (1 << 6), .survive = (1 << 2) | (1 << 3) },
+    [LIFE_RULE_BRAIN]    = { .birth = 1 << 2,              .survive = 0, .brain = true },
+};
+
+// Cells of each tile that lie on the matrix.
+static uint64_t valid_mask[LIFE_TILES];
+static pixel_color_t age_colors[AGE_COLORS];
+static const pixel_color_t dying_color = {0, 40, 120};
+
+void life_init(void)
+{
+    for (int ty = 0; ty < LIFE_TILES_Y; ty++) {
+        for (int tx = 0; tx < LIFE_TILES_X; tx++) {
+            uint64_t mask = 0;
+            for (int r = 0; r < 8 && ty * 8 + r < MATRIX_ROWS; r++) {
+                for (int c = 0; c < 8 && tx * 8 + c < MATRIX_COLS; c++) {
+                    mask |= 1ull << (r * 8 + c);
+                }
+            }
+            valid_mask[ty * LIFE_TILES_X + tx] = mask;
+        }
+    }
+    // Newborn cells are yellow and cool through red and magenta to blue.
+    for (int i = 0; i < AGE_COLORS; i++) {
+        hsv2rgb((float)((60 + 360 - i * 12) % 360), 1.0f, 1.0f - i * 0.025f,
+                &age_colors[i].r, &age_colors[i].g, &age_colors[i].b);
+    }
+}
+
+static inline int tile_index(int tx, int ty)
+{
+    tx = (tx + LIFE_TILES_X) % LIFE_TILES_X;
+    ty = (ty + LIFE_TILES_Y) % LIFE_TILES_Y;
+    return ty * LIFE_TILES_X + tx;
+}
+
+// Each cell takes the value of its neighbour to the west/east/north/south;
+// the edge column or row comes from the adjacent tile.
+static inline uint64_t from_west(uint64_t t, uint64_t w)  { return ((t << 1) & ~COL0) | ((w >> 7) & COL0); }
+static inline uint64_t from_east(uint64_t t, uint64_t e)  { return ((t >> 1) & ~COL7) | ((e << 7) & COL7); }
+static inline uint64_t from_north(uint64_t t, uint64_t n) { return (t << 8) | (n >> 56); }
+static inline uint64_t from_south(uint64_t t, uint64_t s) { return (t >> 8) | (s << 56); }
+
+// Adds one neighbour bitboard into a 4-bit-per-cell counter held as bit
+// planes s0 (1s) .. s3 (8s).
+static inline void count_add(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3, uint64_t x)
+{
+    uint64_t c0 = *s0 & x;
+    *s0 ^= x;
+    uint64_t c1 = *s1 & c0;
+    *s1 ^= c0;
+    uint64_t c2 = *s2 & c1;
+    *s2 ^= c1;
+    *s3 |= c2;
+}
+
+// Cells whose neighbour count is one of the counts set in `counts`.
+static inline uint64_t count_in(uint64_t s0, uint64_t s1, uint64_t s2, uint64_t s3, uint16_t counts)
+{
+    uint64_t match = 0;
+    for (int n = 0; n <= 8; n++) {
+        if (!(counts & (1 << n))) continue;
+        match |= ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) &
+                 ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+    }
+    return match;
+}
+
+void life_step(life_board_t *board, life_rule_t rule)
+{
+    const life_rule_def_t *def = &rules[rule];
+    uint64_t next[LIFE_TILES];
+
+    for (int ty = 0; ty < LIFE_TILES_Y; ty++) {
+        for (int tx = 0; tx < LIFE_TILES_X; tx++) {
+            const uint64_t *a = board->alive;
+            uint64_t t = a[tile_index(tx, ty)];
+            uint64_t w = a[tile_index(tx - 1, ty)], e = a[tile_index(tx + 1, ty)];
+            uint64_t n = a[tile_index(tx, ty - 1)], s = a[tile_index(tx, ty + 1)];
+            uint64_t nw = a[tile_index(tx - 1, ty - 1)], ne = a[tile_index(tx + 1, ty - 1)];
+            uint64_t sw = a[tile_index(tx - 1, ty + 1)], se = a[tile_index(tx + 1, ty + 1)];
+
+            uint64_t row_w = from_west(t, w), row_e = from_east(t, e);
+            uint64_t north_w = from_west(n, nw), north_e = from_east(n, ne);
+            uint64_t south_w = from_west(s, sw), south_e = from_east(s, se);
+
+            uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            count_add(&s0, &s1, &s2, &s3, from_north(row_w, north_w));
+            count_add(&s0, &s1, &s2, &s3, from_north(t, n));
+            count_add(&s0, &s1, &s2, &s3, from_north(row_e, north_e));
+            count_add(&s0, &s1, &s2, &s3, row_w);
+            count_add(&s0, &s1, &s2, &s3, row_e);
+            count_add(&s0, &s1, &s2, &s3, from_south(row_w, south_w));
+            count_add(&s0, &s1, &s2, &s3, from_south(t, s));
+            count_add(&s0, &s1, &s2, &s3, from_south(row_e, south_e));
+
+            int i = ty * LIFE_TILES_X + tx;
+            uint64_t born = count_in(s0, s1, s2, s3, def->birth);
+            if (def->brain) {
+                next[i] = born & ~t & ~board->dying[i] & valid_mask[i];
+                board->dying[i] = t;
+            } else {
+                uint64_t kept = count_in(s0, s1, s2, s3, def->survive);
+                next[i] = ((born & ~t) | (kept & t)) & valid_mask[i];
+            }
+        }
+    }
+    memcpy(board->alive, next, sizeof(next));
+    board->generation++;
+}
+
+void life_clear(life_board_t *board)
+{
+    memset(board, 0, sizeof(*board));
+}
+
+void life_seed_random(life_board_t *board, int density_percent)
+{
+    life_clear(board);
+    for (int i = 0; i < LIFE_TILES; i++) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (prng_next() % 100 < (uint32_t)density_percent) board->alive[i] |= 1ull << bit;
+        }
+        board->alive[i] &= valid_mask[i];
+    }
+}
+
+int life_seed_framebuffer(life_board_t *board)
+{
+    life_clear(board);
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            pixel_color_t p = framebuffer_pixel(row, col);
+            if (p.r | p.g | p.b) {
+                board->alive[(row / 8) * LIFE_TILES_X + col / 8] |= 1ull << ((row % 8) * 8 + col % 8);
+            }
+        }
+    }
+    return life_population(board);
+}
+
+int life_population(const life_board_t *board)
+{
+    int count = 0;
+    for (int i = 0; i < LIFE_TILES; i++) {
+        count += __builtin_popcountll(board->alive[i]);
+    }
+    return count;
+}
+
+bool life_check_cycle(life_board_t *board)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (int i = 0; i < LIFE_TILES; i++) {
+        hash = (hash ^ board->alive[i]) * 0x100000001b3ull;
+        hash = (hash ^ board->dying[i]) * 0x100000001b3ull;
+    }
+    // Only generations actually recorded are compared.
+    int recorded = board->generation < LIFE_HISTORY ? board->generation : LIFE_HISTORY;
+    for (int i = 0; i < recorded; i++) {
+        if (board->history[i] == hash) return true;
+    }
+    board->history[board->generation % LIFE_HISTORY] = hash;
+    return false;
+}
+
+void life_update_ages(life_board_t *board)
+{
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            uint64_t tile = board->alive[(row / 8) * LIFE_TILES_X + col / 8];
+            uint8_t *age = &board->age[row * MATRIX_COLS + col];
+            if (tile >> ((row % 8) * 8 + col % 8) & 1) {
+                if (*age < 255) (*age)++;
+            } else {
+                *age = 0;
+            }
+        }
+    }
+}
+
+void life_render(const life_board_t *board, pixel_color_t *frame)
+{
+    static const pixel_color_t dead = {0, 0, 0};
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            int tile = (row / 8) * LIFE_TILES_X + col / 8;
+            int bit = (row % 8) * 8 + col % 8;
+            int i = row * MATRIX_COLS + col;
+            uint8_t age = board->age[i];
+            if (age) {
+                int idx = (age - 1) / 2;
+                frame[i] = age_colors[idx < AGE_COLORS ? idx : AGE_COLORS - 1];
+            } else if (board->dying[tile] >> bit & 1) {
+                frame[i] = dying_color;
+            } else {
+                frame[i] = dead;
+            }
+        }
+    }
+}
+
+static life_board_t board;
+static int active_rule = -1;
+static uint32_t due_ms;     // when the next generation is due
+
+void life_reset(void)
+{
+    active_rule = -1;
+}
+
+int life_effect(life_rule_t rule, uint32_t now_ms, pixel_color_t *frame)
+{
+    int32_t wait = (int32_t)(due_ms - now_ms);
+    if (active_rule < 0) {
+        // Start from whatever is drawn, or from noise on an empty canvas.
+        if (life_seed_framebuffer(&board) == 0) {
+            life_seed_random(&board, 35);
+        }
+        wait = -LIFE_FRAME_MS;
+    } else if (wait > 0) {
+        // Rendered again before the next generation: during a cross-fade,
+        // which renders at its own rate and, between two of these modes,
+        // renders both from the one board.
+        active_rule = rule;
+        life_render(&board, frame);
+        return wait;
+    } else {
+        // A change of rule carries the board on rather than reseeding it.
+        life_step(&board, rule);
+        if (life_population(&board) == 0 || life_check_cycle(&board)) {
+            life_seed_random(&board, 35);
+        }
+    }
+    active_rule = rule;
+    life_update_ages(&board);
+    life_render(&board, frame);
+    // As for GIF frames: scheduled from when this generation was due, or
+    // from now after a stall.
+    due_ms = -wait < LIFE_FRAME_MS ? due_ms + LIFE_FRAME_MS : now_ms + LIFE_FRAME_MS;
+    return (int32_t)(due_ms - now_ms);
+}
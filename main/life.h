@@ -0,0 +1,61 @@
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Cellular automata on bitboards. The matrix is split into 8x8 tiles, one
+// uint64_t each (bit row * 8 + col), and a generation is computed for all
+// 64 cells of a tile at once with shifts and a bit-sliced neighbour adder.
+// An 8x8 panel is a single tile. The board wraps around at its edges; with
+// a geometry that is not a multiple of 8 the padding cells stay dead.
+#define LIFE_TILES_X  ((MATRIX_COLS + 7) / 8)
+#define LIFE_TILES_Y  ((MATRIX_ROWS + 7) / 8)
+#define LIFE_TILES    (LIFE_TILES_X * LIFE_TILES_Y)
+// Longest cycle period that is detected: long enough for a glider to come
+// back round the torus.
+#define LIFE_HISTORY  (4 * (MATRIX_ROWS > MATRIX_COLS ? MATRIX_ROWS : MATRIX_COLS))
+#define LIFE_FRAME_MS 120
+
+typedef enum {
+    LIFE_RULE_LIFE = 0,     // B3/S23
+    LIFE_RULE_HIGHLIFE,     // B36/S23
+    LIFE_RULE_BRAIN,        // Brian's Brain: B2/S/dying
+    LIFE_RULE_COUNT
+} life_rule_t;
+
+typedef struct {
+    uint64_t alive[LIFE_TILES];
+    uint64_t dying[LIFE_TILES];     // Brian's Brain refractory cells
+    uint8_t age[RGB_COUNT];         // generations each cell has been alive
+    uint64_t history[LIFE_HISTORY]; // recent board hashes
+    uint32_t generation;
+} life_board_t;
+
+void life_init(void);
+
+void life_clear(life_board_t *board);
+void life_seed_random(life_board_t *board, int density_percent);
+// Live cells wherever the framebuffer is not black. Returns the population.
+int life_seed_framebuffer(life_board_t *board);
+
+void life_step(life_board_t *board, life_rule_t rule);
+int life_population(const life_board_t *board);
+
+// Records the current board and returns true if it repeats one of the
+// last LIFE_HISTORY generations (still lifes, oscillators, extinction).
+bool life_check_cycle(life_board_t *board);
+
+void life_update_ages(life_board_t *board);
+void life_render(const life_board_t *board, pixel_color_t *frame);
+
+// The display modes: steps the shared board once every LIFE_FRAME_MS of
+// render clock, reseeding it when it dies out or settles into a cycle, and
+// renders it coloured by cell age. Calls in between only render. The board
+// is seeded on the first call after life_reset(); switching rules after
+// that keeps it. Returns the time until the next generation.
+void life_reset(void);
+int life_effect(life_rule_t rule, uint32_t now_ms, pixel_color_t *frame);
+
+#endif // LIFE_H
@@ -1,10 +1,13 @@
 #include <stdio.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "nvs_flash.h"
 #include "esp_log.h"
 #include "matrix_state.h"
 #include "led_control.h"
 #include "wifi_setup.h"
 #include "web_server.h"
+#include "playlist.h"
 
 void app_main(void)
 {
@@ -17,6 +20,7 @@ void app_main(void)
     ESP_ERROR_CHECK(ret);
     
     rgb_init();
+    ESP_ERROR_CHECK(playlist_init());
     wifi_init_softap();
     start_webserver();
 
@@ -1,14 +1,50 @@
 #include <math.h>
+#include <string.h>
 #include "matrix_state.h"
 
 // Global state definitions
 pixel_color_t framebuffer[MATRIX_ROWS][MATRIX_COLS] = {{{0}}};
+uint8_t index_framebuffer[MATRIX_ROWS][MATRIX_COLS] = {{0}};
+pixel_color_t palette[PALETTE_SIZE];
+uint8_t palette_offset = 0;
+framebuffer_format_t framebuffer_format = FB_FORMAT_RGB;
 uint8_t current_brightness = DEFAULT_BRIGHTNESS;
 pixel_color_t current_color = {255, 0, 0};
 pixel_color_t secondary_color = {0, 0, 255};
 display_mode_t current_mode = MODE_STATIC;
-led_strip_handle_t strip = NULL;
-SemaphoreHandle_t rmt_mutex = NULL;
+uint8_t effect_speed = 64;
+uint8_t effect_scale = 64;
+
+// Names used by the HTTP API, indexed by display_mode_t.
+static const char *const mode_names[MODE_COUNT] = {
+    [MODE_STATIC] = "static",
+    [MODE_RAINBOW] = "rainbow",
+    [MODE_CHECKERBOARD] = "checkerboard",
+    [MODE_GRADIENT] = "gradient",
+    [MODE_RANDOM] = "random",
+    [MODE_PALETTE_CYCLE] = "palette",
+    [MODE_EXPR] = "expr",
+    [MODE_LIFE] = "life",
+    [MODE_HIGHLIFE] = "highlife",
+    [MODE_BRAIN] = "brain",
+    [MODE_PLASMA] = "plasma",
+    [MODE_NOISE] = "noise",
+    [MODE_FIRE] = "fire",
+    [MODE_GIF] = "gif",
+};
+
+int mode_from_name(const char *name) {
+    for (int i = 0; i < MODE_COUNT; i++) {
+        if (mode_names[i] && strcmp(name, mode_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char *mode_name(display_mode_t mode) {
+    return (mode < MODE_COUNT && mode_names[mode]) ? mode_names[mode] : "unknown";
+}
 
 uint8_t scale_brightness(uint8_t value) {
     return (value * current_brightness) / 255;
@@ -35,4 +71,25 @@ void hsv2rgb(float h, float s, float v, uint8_t *r, uint8_t *g, uint8_t *b) {
     *r = (uint8_t)((rp + m) * 255);
     *g = (uint8_t)((gp + m) * 255);
     *b = (uint8_t)((bp + m) * 255);
-} 
\ No newline at end of file
+}
+
+// Colour of a framebuffer cell in whichever format is active. Indexed
+// frames are only expanded here, at output time, through the rotated palette.
+pixel_color_t framebuffer_pixel(int row, int col) {
+    if (framebuffer_format == FB_FORMAT_INDEXED) {
+        return palette[(uint8_t)(index_framebuffer[row][col] + palette_offset)];
+    }
+    return framebuffer[row][col];
+}
+
+// Bakes the indexed frame into the rgb framebuffer so per-pixel edits
+// can continue on top of it.
+void framebuffer_to_rgb(void) {
+    if (framebuffer_format != FB_FORMAT_INDEXED) return;
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            framebuffer[row][col] = framebuffer_pixel(row, col);
+        }
+    }
+    framebuffer_format = FB_FORMAT_RGB;
+}
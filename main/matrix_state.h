@@ -2,14 +2,21 @@
 #define MATRIX_STATE_H
 
 #include <stdint.h>
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
-#include "led_strip.h"
 
 #define RGB_CONTROL_PIN   14
+// Geometry can be overridden at build time (the host benchmarks do this).
+#ifndef MATRIX_ROWS
 #define MATRIX_ROWS      8
+#endif
+#ifndef MATRIX_COLS
 #define MATRIX_COLS      8
-#define RGB_COUNT        64
+#endif
+// 0: every row of the strip runs left to right. 1: alternate rows run
+// right to left (serpentine wiring).
+#ifndef MATRIX_SERPENTINE
+#define MATRIX_SERPENTINE 0
+#endif
+#define RGB_COUNT        (MATRIX_ROWS * MATRIX_COLS)
 #define DEFAULT_BRIGHTNESS 12.8  // 5% of 255
 
 typedef struct {
@@ -23,20 +30,47 @@ typedef enum {
     MODE_RAINBOW,
     MODE_CHECKERBOARD,
     MODE_GRADIENT,
-    MODE_RANDOM
+    MODE_RANDOM,
+    MODE_PALETTE_CYCLE,
+    MODE_EXPR,
+    MODE_LIFE,
+    MODE_HIGHLIFE,
+    MODE_BRAIN,
+    MODE_PLASMA,
+    MODE_NOISE,
+    MODE_FIRE,
+    MODE_GIF,
+    MODE_COUNT
 } display_mode_t;
 
+typedef enum {
+    FB_FORMAT_RGB = 0,
+    FB_FORMAT_INDEXED
+} framebuffer_format_t;
+
+#define PALETTE_SIZE 256
+
 // Global state declarations
 extern pixel_color_t framebuffer[MATRIX_ROWS][MATRIX_COLS];
+extern uint8_t index_framebuffer[MATRIX_ROWS][MATRIX_COLS];
+extern pixel_color_t palette[PALETTE_SIZE];
+extern uint8_t palette_offset;
+extern framebuffer_format_t framebuffer_format;
 extern uint8_t current_brightness;
 extern pixel_color_t current_color;
 extern pixel_color_t secondary_color;
 extern display_mode_t current_mode;
-extern led_strip_handle_t strip;
-extern SemaphoreHandle_t rmt_mutex;
+// Procedural mode controls, 64 = normal speed / zoom.
+extern uint8_t effect_speed;
+extern uint8_t effect_scale;
 
 // Utility functions
 uint8_t scale_brightness(uint8_t value);
 void hsv2rgb(float h, float s, float v, uint8_t *r, uint8_t *g, uint8_t *b);
+void palette_fill_hue_wheel(pixel_color_t *pal);   // pixel_pipeline.cpp
+pixel_color_t framebuffer_pixel(int row, int col);
+int mode_from_name(const char *name);
+const char *mode_name(display_mode_t mode);
+void framebuffer_to_rgb(void);
 
 #endif // MATRIX_STATE_H 
\ No newline at end of file
@@ -134,32 +134,15 @@ const char MATRIX_UI_HTML[] = R"=====(
             color: #121212;
         }
 
-        /* Grid & Pixel Styles */
-        .grid {
-            display: grid;
-            grid-template-columns: repeat(8, 1fr);
-            gap: 4px;
-            margin: 20px auto;
-            max-width: 300px;
-        }
-
-        .pixel {
+        /* Matrix Canvas */
+        #matrix {
+            display: block;
             width: 100%;
-            padding-top: 100%; /* maintain square shape */
-            position: relative;
-            background-color: #000;
+            max-width: 300px;
+            margin: 20px auto;
             border-radius: 4px;
             touch-action: none;
-        }
-
-        .pixel::after {
-            content: "";
-            display: block;
-            position: absolute;
-            top: 0;
-            left: 0;
-            right: 0;
-            bottom: 0;
+            cursor: crosshair;
         }
 
         /* Debug Console */
@@ -172,12 +155,19 @@ const char MATRIX_UI_HTML[] = R"=====(
             text-align: left;
         }
 
+        #latency {
+            font-family: monospace;
+            font-size: 0.8rem;
+            color: #888;
+            margin-top: 8px;
+        }
+
         /* Responsive Adjustments */
         @media (max-width: 480px) {
             h1 { font-size: 1.5rem; }
             .btn { padding: 8px 16px; font-size: 0.9rem; }
             .color-picker input[type="color"] { width: 40px; height: 40px; }
-            .grid { max-width: 250px; }
+            #matrix { max-width: 250px; }
         }
     </style>
 </head>
@@ -198,6 +188,14 @@ const char MATRIX_UI_HTML[] = R"=====(
                 <option value="checkerboard">Checkerboard</option>
                 <option value="gradient">Gradient</option>
                 <option value="random">Random</option>
+                <option value="palette">Palette Cycle</option>
+                <option value="life">Game of Life</option>
+                <option value="highlife">HighLife</option>
+                <option value="brain">Brian's Brain</option>
+                <option value="plasma">Plasma</option>
+                <option value="noise">Noise Flow</option>
+                <option value="fire">Fire</option>
+                <option value="gif">GIF</option>
             </select>
         </div>
         <div class="controls">
@@ -205,13 +203,24 @@ const char MATRIX_UI_HTML[] = R"=====(
             <input type="range" id="brightness" min="0" max="255" value="12">
             <span id="brightness-value">5%</span>
         </div>
+        <div class="controls">
+            <span>Speed:</span>
+            <input type="range" id="effect-speed" min="0" max="255" value="64">
+            <span>Scale:</span>
+            <input type="range" id="effect-scale" min="0" max="255" value="64">
+        </div>
         <div class="tools">
             <button class="btn" id="clear">Clear All</button>
             <button class="btn" id="fill">Fill All</button>
+            <button class="btn" id="undo">Undo</button>
+            <button class="btn" id="redo">Redo</button>
             <input type="file" id="image-upload" accept="image/*" hidden>
             <button class="btn" id="upload-btn">Upload Image</button>
+            <input type="file" id="gif-upload" accept="image/gif" hidden>
+            <button class="btn" id="gif-btn">Upload GIF</button>
         </div>
-        <div class="grid" id="matrix"></div>
+        <canvas id="matrix"></canvas>
+        <div id="latency"></div>
         <div id="debug"></div>
         <div id="mode-warning" style="color: red; display: none;">Switch to Static Mode to draw!</div>
     </div>
@@ -268,54 +277,68 @@ const char MATRIX_UI_HTML[] = R"=====(
             selectedMode = "static",
             animateInterval = null;
         
+        // Matrix geometry, replaced by GET /geometry once it answers.
+        let rows = 8, cols = 8;
+        // rgb per cell, row-major, as sent and received by /frame.
+        let fb = new Uint8ClampedArray(rows * cols * 3);
+        let dirty = true;
+
+        function setCell(index, c) {
+            fb[index * 3] = c.r;
+            fb[index * 3 + 1] = c.g;
+            fb[index * 3 + 2] = c.b;
+            dirty = true;
+        }
+
+        function cellIs(index, c) {
+            return fb[index * 3] === c.r && fb[index * 3 + 1] === c.g && fb[index * 3 + 2] === c.b;
+        }
+
         // Function to update the grid preview based on selected mode.
         function updatePreview(mode) {
             if (animateInterval !== null) {
                 clearInterval(animateInterval);
                 animateInterval = null;
             }
-            const cells = document.querySelectorAll('.pixel');
-            
+            const count = rows * cols;
+
             if (mode === "rainbow") {
                 let rainbowAngle = 0;
                 animateInterval = setInterval(() => {
-                    cells.forEach((cell, index) => {
-                        let hue = (rainbowAngle + index * (360 / 64)) % 360;
-                        const rgb = hsvToRgb(hue, 1, 1);
-                        cell.style.backgroundColor = `rgb(${rgb.r}, ${rgb.g}, ${rgb.b})`;
-                    });
+                    for (let index = 0; index < count; index++) {
+                        let hue = (rainbowAngle + index * (360 / count)) % 360;
+                        setCell(index, hsvToRgb(hue, 1, 1));
+                    }
                     rainbowAngle = (rainbowAngle + 5) % 360;
                 }, 100);
             } else if (mode === "checkerboard") {
-                cells.forEach((cell, index) => {
-                    let row = Math.floor(index / 8), col = index % 8;
-                    if ((row + col) % 2 === 0) {
-                        cell.style.backgroundColor = `rgb(${currentColor.r}, ${currentColor.g}, ${currentColor.b})`;
-                    } else {
-                        cell.style.backgroundColor = `rgb(${secondaryColor.r}, ${secondaryColor.g}, ${secondaryColor.b})`;
-                    }
-                });
+                for (let index = 0; index < count; index++) {
+                    let row = Math.floor(index / cols), col = index % cols;
+                    setCell(index, (row + col) % 2 === 0 ? currentColor : secondaryColor);
+                }
             } else if (mode === "gradient") {
                 let gradientOffset = 0;
                 animateInterval = setInterval(() => {
-                    cells.forEach((cell, index) => {
-                        let col = index % 8;
-                        let effectiveCol = (col + gradientOffset) % 8;
-                        let factor = effectiveCol / 7;
-                        let r = Math.round(currentColor.r * (1 - factor) + secondaryColor.r * factor);
-                        let g = Math.round(currentColor.g * (1 - factor) + secondaryColor.g * factor);
-                        let b = Math.round(currentColor.b * (1 - factor) + secondaryColor.b * factor);
-                        cell.style.backgroundColor = `rgb(${r}, ${g}, ${b})`;
-                    });
-                    gradientOffset = (gradientOffset + 1) % 8;
+                    for (let index = 0; index < count; index++) {
+                        let col = index % cols;
+                        let effectiveCol = (col + gradientOffset) % cols;
+                        let factor = effectiveCol / (cols - 1);
+                        setCell(index, {
+                            r: Math.round(currentColor.r * (1 - factor) + secondaryColor.r * factor),
+                            g: Math.round(currentColor.g * (1 - factor) + secondaryColor.g * factor),
+                            b: Math.round(currentColor.b * (1 - factor) + secondaryColor.b * factor)
+                        });
+                    }
+                    gradientOffset = (gradientOffset + 1) % cols;
                 }, 200);
             } else if (mode === "random") {
-                cells.forEach(cell => {
-                    let r = Math.floor(Math.random() * 256),
-                        g = Math.floor(Math.random() * 256),
-                        b = Math.floor(Math.random() * 256);
-                    cell.style.backgroundColor = `rgb(${r}, ${g}, ${b})`;
-                });
+                for (let index = 0; index < count; index++) {
+                    setCell(index, {
+                        r: Math.floor(Math.random() * 256),
+                        g: Math.floor(Math.random() * 256),
+                        b: Math.floor(Math.random() * 256)
+                    });
+                }
             }
         }
         
@@ -335,6 +358,24 @@ const char MATRIX_UI_HTML[] = R"=====(
             }, 200);
             brightnessValue.textContent = `${Math.round((e.target.value / 255) * 100)}%`;
         });
+
+        // EFFECT SPEED / SCALE DEBOUNCE
+        let paramsTimeout;
+        ['effect-speed', 'effect-scale'].forEach(id => {
+            document.getElementById(id).addEventListener('input', () => {
+                clearTimeout(paramsTimeout);
+                paramsTimeout = setTimeout(() => {
+                    fetch('/params', {
+                        method: 'POST',
+                        headers: {'Content-Type': 'application/json'},
+                        body: JSON.stringify({
+                            speed: parseInt(document.getElementById('effect-speed').value),
+                            scale: parseInt(document.getElementById('effect-scale').value)
+                        })
+                    }).catch(err => console.error('Params error:', err));
+                }, 200);
+            });
+        });
         
         // Event: Primary color picker update.
         const colorInput = document.getElementById('color-picker');
@@ -390,105 +431,251 @@ const char MATRIX_UI_HTML[] = R"=====(
             });
         });
         
-        // Build 8x8 grid for pixels.
-        const matrix = document.getElementById('matrix');
-        let lastColor = null;
+        // Matrix canvas. The framebuffer goes into a one-pixel-per-cell
+        // bitmap that is scaled up in one drawImage, then the gaps between
+        // cells are drawn over it; repaints only happen on animation frames
+        // after something changed.
+        const matrix = document.getElementById('matrix'),
+              matrixCtx = matrix.getContext('2d'),
+              cellBitmap = document.createElement('canvas');
+        let cellImage = null;
+
+        function resizeMatrix(newRows, newCols) {
+            rows = newRows;
+            cols = newCols;
+            fb = new Uint8ClampedArray(rows * cols * 3);
+            cellBitmap.width = cols;
+            cellBitmap.height = rows;
+            cellImage = cellBitmap.getContext('2d').createImageData(cols, rows);
+            sizeCanvas();
+            updatePreview(selectedMode);
+        }
 
-        function updatePixelUI(pixelElement, r, g, b) {
-            pixelElement.style.backgroundColor = `rgb(${r},${g},${b})`;
+        // Backing store at device resolution, so cell edges stay sharp.
+        function sizeCanvas() {
+            const width = (matrix.clientWidth || 300) * (window.devicePixelRatio || 1);
+            matrix.width = Math.round(width);
+            matrix.height = Math.round(width * rows / cols);
+            dirty = true;
         }
 
-        for (let i = 0; i < 64; i++) {
-            const pixel = document.createElement('div');
-            pixel.className = 'pixel';
-            pixel.dataset.index = i;
-            pixel.id = `pixel-${Math.floor(i/8)}-${i%8}`;
-            matrix.appendChild(pixel);
+        function paintMatrix() {
+            const px = cellImage.data;
+            for (let i = 0, j = 0; i < fb.length; i += 3, j += 4) {
+                px[j] = fb[i];
+                px[j + 1] = fb[i + 1];
+                px[j + 2] = fb[i + 2];
+                px[j + 3] = 255;
+            }
+            cellBitmap.getContext('2d').putImageData(cellImage, 0, 0);
+            matrixCtx.imageSmoothingEnabled = false;
+            matrixCtx.drawImage(cellBitmap, 0, 0, matrix.width, matrix.height);
+
+            const cellW = matrix.width / cols, cellH = matrix.height / rows;
+            matrixCtx.fillStyle = '#121212';
+            const gap = Math.max(1, Math.round(Math.min(cellW, cellH) * 0.1));
+            for (let col = 1; col < cols; col++) {
+                matrixCtx.fillRect(Math.round(col * cellW - gap / 2), 0, gap, matrix.height);
+            }
+            for (let row = 1; row < rows; row++) {
+                matrixCtx.fillRect(0, Math.round(row * cellH - gap / 2), matrix.width, gap);
+            }
         }
-        
-        updatePreview(selectedMode);
-        
+
+        function frameLoop() {
+            if (dirty) {
+                dirty = false;
+                paintMatrix();
+            }
+            // Everything drawn since the last request goes out in the next
+            // one, once the previous one is answered.
+            sendPendingUpdates();
+            requestAnimationFrame(frameLoop);
+        }
+
+        resizeMatrix(rows, cols);
+        requestAnimationFrame(frameLoop);
+        window.addEventListener('resize', sizeCanvas);
+
+        fetch('/geometry')
+            .then(r => r.json())
+            .then(geometry => {
+                if (geometry.rows > 0 && geometry.cols > 0 &&
+                    (geometry.rows !== rows || geometry.cols !== cols)) {
+                    resizeMatrix(geometry.rows, geometry.cols);
+                }
+                syncFrame();
+            })
+            .catch(err => console.error('Geometry error:', err));
+
         // Pointer event handlers with drag support.
         let isDrawing = false;
-        let lastPixelIndex = null;
+        let lastCell = null;
         let currentAction = null;
 
+        function cellAt(e) {
+            const rect = matrix.getBoundingClientRect();
+            const col = Math.floor((e.clientX - rect.left) / rect.width * cols),
+                  row = Math.floor((e.clientY - rect.top) / rect.height * rows);
+            if (row < 0 || row >= rows || col < 0 || col >= cols) return null;
+            return { row, col };
+        }
+
+        // Every cell on the line between two cells (Bresenham), so a fast
+        // stroke leaves no gaps between the sampled pointer positions.
+        function strokeTo(cell) {
+            if (!lastCell) {
+                processPixel(cell.row * cols + cell.col, currentAction);
+                lastCell = cell;
+                return;
+            }
+            let row = lastCell.row, col = lastCell.col;
+            const dRow = Math.abs(cell.row - row), dCol = Math.abs(cell.col - col),
+                  stepRow = row < cell.row ? 1 : -1, stepCol = col < cell.col ? 1 : -1;
+            let err = dCol - dRow;
+            while (row !== cell.row || col !== cell.col) {
+                const e2 = 2 * err;
+                if (e2 > -dRow) { err -= dRow; col += stepCol; }
+                if (e2 < dCol) { err += dCol; row += stepRow; }
+                processPixel(row * cols + col, currentAction);
+            }
+            lastCell = cell;
+        }
+
         matrix.addEventListener('pointerdown', e => {
             if(selectedMode !== "static") {
                 modeSelect.value = "static";
                 modeSelect.dispatchEvent(new Event('change'));
             }
-            const pixel = e.target.closest('.pixel');
-            if (!pixel) return;
-            
+            const cell = cellAt(e);
+            if (!cell) return;
+
+            matrix.setPointerCapture(e.pointerId);
             isDrawing = true;
-            currentAction = (pixel.style.backgroundColor === 'rgb(0, 0, 0)') ? 'paint' : 'erase';
-            processPixel(pixel, currentAction);
+            lastCell = null;
+            currentAction = cellIs(cell.row * cols + cell.col, {r:0,g:0,b:0}) ? 'paint' : 'erase';
+            strokeTo(cell);
         });
 
         matrix.addEventListener('pointermove', e => {
             if (!isDrawing) return;
             e.preventDefault();
-            const pixel = document.elementFromPoint(e.clientX, e.clientY);
-            if (pixel && pixel.classList.contains('pixel')) {
-                const index = pixel.dataset.index;
-                if (index !== lastPixelIndex) {
-                    processPixel(pixel, currentAction);
-                    lastPixelIndex = index;
-                }
-            }
+            // Browsers deliver one pointermove per frame; the positions in
+            // between are in the coalesced list.
+            const events = e.getCoalescedEvents ? e.getCoalescedEvents() : [];
+            (events.length ? events : [e]).forEach(ev => {
+                const cell = cellAt(ev);
+                if (cell) strokeTo(cell);
+            });
         });
 
-        matrix.addEventListener('pointerup', () => {
+        function endStroke() {
             isDrawing = false;
-            lastPixelIndex = null;
+            lastCell = null;
             sendPendingUpdates();
-        });
-
-        // Batch pixel updates.
-        let pendingUpdates = [];
-        let sendTimeout = null;
+        }
+        matrix.addEventListener('pointerup', endStroke);
+        matrix.addEventListener('pointercancel', endStroke);
+
+        // Batch pixel updates: the latest colour per cell, sent one request
+        // at a time and no more often than PIXEL_SEND_MS, which keeps well
+        // under the panel's per-client rate (30 requests a second).
+        const PIXEL_SEND_MS = 50;
+        let pendingUpdates = new Map();
+        let pendingSince = 0;
+        let pixelRequest = null;
+        let nextSendAt = 0;
+        // Sent part of a stroke that is still going; the request that ends
+        // it makes the whole stroke one undo step.
+        let strokeOpen = false;
+
+        function hasPendingUpdates() {
+            return pendingUpdates.size > 0 || (strokeOpen && !isDrawing);
+        }
 
-        function processPixel(pixel, action) {
+        function processPixel(index, action) {
             if (selectedMode !== "static") return;
             const newColor = action === 'paint' ? currentColor : {r:0,g:0,b:0};
-            const currentColorStr = `rgb(${newColor.r},${newColor.g},${newColor.b})`;
-            if (pixel.style.backgroundColor === currentColorStr) return;
-            pixel.style.backgroundColor = currentColorStr;
-            
-            const index = parseInt(pixel.dataset.index);
-            pendingUpdates.push({
-                row: Math.floor(index / 8),
-                col: index % 8,
+            if (cellIs(index, newColor)) return;
+            setCell(index, newColor);
+
+            if (pendingUpdates.size === 0) pendingSince = performance.now();
+            pendingUpdates.set(index, {
+                row: Math.floor(index / cols),
+                col: index % cols,
                 r: newColor.r,
                 g: newColor.g,
                 b: newColor.b
             });
-            
-            if(pendingUpdates.length >= 3) sendPendingUpdates();
         }
 
         function sendPendingUpdates() {
-            if (pendingUpdates.length === 0) return;
-            const updates = [...pendingUpdates];
-            pendingUpdates = [];
-            fetch('/pixel', {
+            const now = performance.now();
+            if (pixelRequest || now < nextSendAt || !hasPendingUpdates()) return;
+            const sent = pendingUpdates, sentSince = pendingSince, wasOpen = strokeOpen;
+            const updates = [...sent.values()];
+            const batchMs = updates.length ? now - sentSince : 0;
+            const body = {updates};
+            if (isDrawing) body.stroke = true;
+            strokeOpen = isDrawing;
+            pendingUpdates = new Map();
+            nextSendAt = now + PIXEL_SEND_MS;
+            let failed = false;
+            pixelRequest = fetch('/pixel', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/json'},
-                body: JSON.stringify({updates})
+                body: JSON.stringify(body)
+            }).then(res => {
+                if (res.status !== 429) {
+                    return res.json().then(reply => showLatency(batchMs, reply));
+                }
+                // Refused before anything was drawn: put the batch back
+                // under whatever was drawn since and retry when told to.
+                sent.forEach((update, index) => {
+                    if (!pendingUpdates.has(index)) pendingUpdates.set(index, update);
+                });
+                pendingSince = sentSince;
+                strokeOpen = wasOpen;
+                const retryS = parseInt(res.headers.get('Retry-After'), 10) || 1;
+                nextSendAt = performance.now() + retryS * 1000;
             }).catch(err => {
                 console.error('Batch update failed:', err);
-                updates.forEach(update => {
-                    const pixel = document.getElementById(`pixel-${update.row}-${update.col}`);
-                    if (pixel) pixel.style.backgroundColor = lastColor;
-                });
+                failed = true;
+            }).then(() => {
+                pixelRequest = null;
+                if (failed) syncFrame();
             });
         }
-        
+
+        // Resolves once everything drawn so far has been sent.
+        function whenUpdatesSent() {
+            return new Promise(resolve => {
+                (function poll() {
+                    sendPendingUpdates();
+                    if (!pixelRequest && !hasPendingUpdates()) resolve();
+                    else setTimeout(poll, PIXEL_SEND_MS);
+                })();
+            });
+        }
+
+        // How long the oldest stroke waited here for its batch, and the
+        // panel's input-to-LED time for the newest request it has finished.
+        function showLatency(batchMs, reply) {
+            const l = reply.latency;
+            if (!l) return;
+            const ms = us => (us / 1000).toFixed(1);
+            document.getElementById('latency').textContent =
+                `UI batch ${batchMs.toFixed(1)} ms, panel ${ms(l.total_us)} ms ` +
+                `(p50 ${ms(l.p50_us)}, p99 ${ms(l.p99_us)})`;
+        }
+
+        function fillMatrix(c) {
+            for (let index = 0; index < rows * cols; index++) setCell(index, c);
+        }
+
         // Bulk operations.
         document.getElementById('clear').addEventListener('click', () => {
-            const pixels = document.querySelectorAll('.pixel');
-            pixels.forEach(p => p.style.backgroundColor = '#000');
+            fillMatrix({r:0,g:0,b:0});
             fetch('/pixel', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/json'},
@@ -502,8 +689,7 @@ const char MATRIX_UI_HTML[] = R"=====(
         });
 
         document.getElementById('fill').addEventListener('click', () => {
-            const pixels = document.querySelectorAll('.pixel');
-            pixels.forEach(p => p.style.backgroundColor = `rgb(${currentColor.r}, ${currentColor.g}, ${currentColor.b})`);
+            fillMatrix(currentColor);
             fetch('/pixel', {
                 method: 'POST',
                 headers: {'Content-Type': 'application/json'},
@@ -516,6 +702,16 @@ const char MATRIX_UI_HTML[] = R"=====(
             }).catch(err => console.error('Fill failed:', err));
         });
         
+        // Undo / redo on the panel, then show the result.
+        ['undo', 'redo'].forEach(id => {
+            document.getElementById(id).addEventListener('click', () => {
+                whenUpdatesSent()
+                    .then(() => fetch('/' + id, { method: 'POST' }))
+                    .then(() => syncFrame())
+                    .catch(err => console.error(id + ' failed:', err));
+            });
+        });
+
         // Image upload & downscale using Canvas.
         document.getElementById('upload-btn').addEventListener('click', () => {
             document.getElementById('image-upload').click();
@@ -529,30 +725,52 @@ const char MATRIX_UI_HTML[] = R"=====(
                 const img = new Image();
                 img.onload = function() {
                     const canvas = document.createElement('canvas');
-                    canvas.width = 8;
-                    canvas.height = 8;
+                    canvas.width = cols;
+                    canvas.height = rows;
                     const ctx = canvas.getContext('2d');
-                    ctx.drawImage(img, 0, 0, 8, 8);
-                    const imageData = ctx.getImageData(0, 0, 8, 8).data;
-                    const pixels = document.querySelectorAll('.pixel');
-                    for (let i = 0; i < 64; i++) {
+                    ctx.drawImage(img, 0, 0, cols, rows);
+                    const imageData = ctx.getImageData(0, 0, cols, rows).data;
+                    // One binary frame upload: format byte 0 (rgb), then
+                    // every pixel row-major.
+                    const body = new Uint8Array(1 + rows * cols * 3);
+                    for (let i = 0; i < rows * cols; i++) {
                         const idx = i * 4;
-                        const r = imageData[idx],
-                              g = imageData[idx + 1],
-                              b = imageData[idx + 2];
-                        pixels[i].style.backgroundColor = `rgb(${r}, ${g}, ${b})`;
-                        logApiCall('/pixel', {
-                            row: Math.floor(i / 8),
-                            col: i % 8,
-                            r, g, b
-                        });
+                        const c = { r: imageData[idx], g: imageData[idx + 1], b: imageData[idx + 2] };
+                        setCell(i, c);
+                        body.set([c.r, c.g, c.b], 1 + i * 3);
                     }
+                    fetch('/frame', { method: 'POST', body })
+                        .catch(err => console.error('Upload failed:', err));
                 };
                 img.src = event.target.result;
             };
             reader.readAsDataURL(file);
         });
 
+        // Animated GIF upload: the file goes to the panel as-is, which
+        // stores it and plays it in gif mode.
+        document.getElementById('gif-btn').addEventListener('click', () => {
+            document.getElementById('gif-upload').click();
+        });
+
+        document.getElementById('gif-upload').addEventListener('change', function(e) {
+            const file = e.target.files[0];
+            if (!file) return;
+            document.getElementById('debug').innerHTML = 'Uploading GIF...';
+            fetch('/gif', { method: 'POST', body: file })
+                .then(resp => resp.ok ? resp.json() : resp.text().then(text => { throw new Error(text); }))
+                .then(info => {
+                    modeSelect.value = selectedMode = 'gif';
+                    updateSecondaryColorControls('gif');
+                    updatePreview('gif');
+                    document.getElementById('debug').innerHTML = `Playing GIF: ${info.width}x${info.height}, ${info.bytes} bytes`;
+                })
+                .catch(err => {
+                    document.getElementById('debug').innerHTML = `GIF upload failed: ${err.message}`;
+                });
+            e.target.value = '';
+        });
+
         // Secondary color API update.
         document.getElementById('secondary-color-picker').addEventListener('input', function(e) {
             secondaryColor = hexToRgb(e.target.value);
@@ -567,18 +785,21 @@ const char MATRIX_UI_HTML[] = R"=====(
             .catch(err => console.error('Error updating secondary color:', err));
         });
 
-        // Real-time pixel sync.
-        setInterval(() => {
-            fetch('/pixels')
-                .then(r => r.json())
-                .then(pixels => {
-                    pixels.forEach(pixel => {
-                        const cell = document.getElementById(`pixel-${pixel.row}-${pixel.col}`);
-                        if(cell)
-                            cell.style.backgroundColor = `rgb(${pixel.r},${pixel.g},${pixel.b})`;
-                    });
-                });
-        }, 1000);
+        // Real-time pixel sync: the drawing as raw rgb from GET /frame,
+        // skipped while a stroke is still on its way to the panel.
+        function syncFrame() {
+            if (selectedMode !== "static" || isDrawing || pixelRequest || pendingUpdates.size) return;
+            fetch('/frame')
+                .then(r => r.arrayBuffer())
+                .then(buf => {
+                    const data = new Uint8Array(buf);
+                    if (isDrawing || data[0] !== 0 || data.length !== 1 + fb.length) return;
+                    fb.set(data.subarray(1));
+                    dirty = true;
+                })
+                .catch(err => console.error('Sync error:', err));
+        }
+        setInterval(syncFrame, 1000);
 
         // Mode warning visibility.
         function showModeWarning() {
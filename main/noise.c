@@ -0,0 +1,134 @@
+#include <math.h>
+#include <string.h>
+#include "noise.h"
+
+static uint32_t prng_state = 0x9e3779b9;
+static int8_t sin_table[256];
+static uint8_t fade_table[256];
+static pixel_color_t fire_palette[256];
+
+// Heat per cell, with two extra rows under the panel that act as the fuel.
+static uint8_t heat[MATRIX_ROWS + 2][MATRIX_COLS];
+
+void noise_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        sin_table[i] = (int8_t)lroundf(127.0f * sinf(i * 2.0f * (float)M_PI / 256.0f));
+        // Smoothstep, so value noise has no visible lattice creases.
+        fade_table[i] = (uint8_t)((i * i * (3 * 256 - 2 * i)) >> 16);
+        // Black through red, orange and yellow to white.
+        int h = i * 3;
+        fire_palette[i].r = h > 255 ? 255 : h;
+        fire_palette[i].g = h > 510 ? 255 : h > 255 ? h - 255 : 0;
+        fire_palette[i].b = h > 510 ? h - 510 : 0;
+    }
+    memset(heat, 0, sizeof(heat));
+}
+
+void prng_seed(uint32_t seed)
+{
+    prng_state = seed ? seed : 0x9e3779b9;
+}
+
+uint32_t prng_next(void)
+{
+    uint32_t x = prng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    prng_state = x;
+    return x;
+}
+
+int8_t sin8(uint8_t angle)
+{
+    return sin_table[angle];
+}
+
+static inline uint8_t lattice(uint32_t x, uint32_t y, uint32_t z)
+{
+    uint32_t h = x * 374761393u + y * 668265263u + z * 2246822519u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (uint8_t)(h >> 24);
+}
+
+static inline int lerp8(int a, int b, uint8_t t)
+{
+    return a + (((b - a) * t) >> 8);
+}
+
+uint8_t noise3(uint32_t x, uint32_t y, uint32_t z)
+{
+    uint32_t xi = x >> 8, yi = y >> 8, zi = z >> 8;
+    uint8_t fx = fade_table[x & 0xff], fy = fade_table[y & 0xff], fz = fade_table[z & 0xff];
+
+    int x00 = lerp8(lattice(xi, yi, zi), lattice(xi + 1, yi, zi), fx);
+    int x10 = lerp8(lattice(xi, yi + 1, zi), lattice(xi + 1, yi + 1, zi), fx);
+    int x01 = lerp8(lattice(xi, yi, zi + 1), lattice(xi + 1, yi, zi + 1), fx);
+    int x11 = lerp8(lattice(xi, yi + 1, zi + 1), lattice(xi + 1, yi + 1, zi + 1), fx);
+    return lerp8(lerp8(x00, x10, fy), lerp8(x01, x11, fy), fz);
+}
+
+// Four interfering sine fields: two linear, one diagonal and one radial
+// from a centre that drifts around the panel.
+void plasma_render(uint32_t phase, uint8_t scale, const pixel_color_t *pal, pixel_color_t *frame)
+{
+    int step = scale / 4 + 1;  // sine table units per pixel
+    uint8_t p1 = phase >> 4, p2 = phase >> 5, p3 = phase >> 6;
+    int cx = (MATRIX_COLS / 2) * step + (sin8(p3) * MATRIX_COLS * step >> 9);
+    int cy = (MATRIX_ROWS / 2) * step + (sin8(p2 + 64) * MATRIX_ROWS * step >> 9);
+
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        int v = row * step;
+        int row_term = sin8(v + p2);
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            int u = col * step;
+            int du = u - cx, dv = v - cy;
+            int sum = sin8(u + p1) + row_term + sin8((u + v) / 2 - p3) +
+                      sin8(((du * du + dv * dv) >> 6) - p1);
+            frame[row * MATRIX_COLS + col] = pal[(uint8_t)(((sum + 512) >> 2) + p3)];
+        }
+    }
+}
+
+// Two octaves of value noise drifting through time.
+void flow_render(uint32_t phase, uint8_t scale, const pixel_color_t *pal, pixel_color_t *frame)
+{
+    uint32_t step = scale + 1;  // 8.8 lattice units per pixel
+    uint32_t z = phase / 4;
+    uint8_t hue = phase >> 7;
+
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            uint32_t x = col * step, y = row * step + phase / 8;
+            int n = noise3(x, y, z) * 2 + noise3(x * 2 + 0x8000, y * 2, z * 2);
+            frame[row * MATRIX_COLS + col] = pal[(uint8_t)(n / 3 + hue)];
+        }
+    }
+}
+
+void fire_render(uint8_t scale, pixel_color_t *frame)
+{
+    // Bigger scale, taller flames: less cooling per step, and less per row
+    // on taller panels.
+    int cooling = (48 * 64 / (scale + 1)) * 8 / MATRIX_ROWS + 1;
+
+    for (int col = 0; col < MATRIX_COLS; col++) {
+        uint32_t r = prng_next();
+        heat[MATRIX_ROWS][col] = 160 + (r & 0x5f);
+        heat[MATRIX_ROWS + 1][col] = 160 + ((r >> 8) & 0x5f);
+    }
+    // Each cell takes the average of the three below it and the one two
+    // below, minus a little random cooling. Rows are updated top down, so
+    // every read sees the previous step's values.
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            int left = col > 0 ? col - 1 : MATRIX_COLS - 1;
+            int right = col < MATRIX_COLS - 1 ? col + 1 : 0;
+            int sum = heat[row + 1][left] + heat[row + 1][col] + heat[row + 1][right] + heat[row + 2][col];
+            int h = sum / 4 - (int)(prng_next() % cooling);
+            heat[row][col] = h > 0 ? h : 0;
+            frame[row * MATRIX_COLS + col] = fire_palette[heat[row][col]];
+        }
+    }
+}
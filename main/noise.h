@@ -0,0 +1,32 @@
+#ifndef NOISE_H
+#define NOISE_H
+
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Integer-only generators for the procedural modes: a xorshift PRNG, an
+// 8-bit sine table, 3D value noise and a fire simulation. Nothing here
+// touches floating point after noise_init().
+
+void noise_init(void);
+
+// xorshift32. Seeded from esp_random() on the device; any non-zero seed.
+void prng_seed(uint32_t seed);
+uint32_t prng_next(void);
+
+// sin of angle/256 turns, scaled to -127..127.
+int8_t sin8(uint8_t angle);
+
+// Smoothly interpolated lattice noise, 0..255. Coordinates are 8.8 fixed
+// point, so one lattice cell is 256 units.
+uint8_t noise3(uint32_t x, uint32_t y, uint32_t z);
+
+// Mode renderers. phase is the effect's running time in ms (already
+// scaled by its speed), scale its spatial zoom with 64 as the default;
+// colours come from a 256-entry palette.
+void plasma_render(uint32_t phase, uint8_t scale, const pixel_color_t *pal, pixel_color_t *frame);
+void flow_render(uint32_t phase, uint8_t scale, const pixel_color_t *pal, pixel_color_t *frame);
+// One step of the fire simulation; scale sets the flame height.
+void fire_render(uint8_t scale, pixel_color_t *frame);
+
+#endif // NOISE_H
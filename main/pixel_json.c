@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <string.h>
+#include "matrix_state.h"
+#include "draw.h"
+#include "pixel_json.h"
+
+int pixel_json_apply(const cJSON *root)
+{
+    // Check for fill parameter first
+    cJSON *fill = cJSON_GetObjectItem(root, "fill");
+    if (fill && cJSON_IsString(fill) && strcmp(fill->valuestring, "yes") == 0) {
+        cJSON *r = cJSON_GetObjectItem(root, "r");
+        cJSON *g = cJSON_GetObjectItem(root, "g");
+        cJSON *b = cJSON_GetObjectItem(root, "b");
+        
+        if (r && g && b) {
+            draw_canvas_t canvas;
+            draw_canvas_framebuffer(&canvas);
+            draw_fill_rect(&canvas, 0, 0, canvas.width, canvas.height,
+                (pixel_color_t){r->valueint, g->valueint, b->valueint});
+        }
+        return 0;
+    }
+
+    cJSON *updates = cJSON_GetObjectItem(root, "updates");
+    if (!updates) {
+        return -1;
+    }
+    
+    cJSON *update = NULL;
+    cJSON_ArrayForEach(update, updates) {
+        cJSON *row = cJSON_GetObjectItem(update, "row");
+        cJSON *col = cJSON_GetObjectItem(update, "col");
+        cJSON *r = cJSON_GetObjectItem(update, "r");
+        cJSON *g = cJSON_GetObjectItem(update, "g");
+        cJSON *b = cJSON_GetObjectItem(update, "b");
+        if (!row || !col || !r || !g || !b ||
+            row->valueint < 0 || row->valueint >= MATRIX_ROWS ||
+            col->valueint < 0 || col->valueint >= MATRIX_COLS) {
+            continue;
+        }
+        framebuffer[row->valueint][col->valueint] = (pixel_color_t){r->valueint, g->valueint, b->valueint};
+    }
+    return 0;
+}
+
+// Longest entry: ,{"row":R,"col":C,"r":255,"g":255,"b":255} with R and C
+// the widest row and column numbers, 40 characters besides them.
+#define DIGITS(n) ((n) < 10 ? 1 : (n) < 100 ? 2 : (n) < 1000 ? 3 : (n) < 10000 ? 4 : (n) < 100000 ? 5 : 10)
+#define ENTRY_MAX (40 + DIGITS(MATRIX_ROWS - 1) + DIGITS(MATRIX_COLS - 1))
+
+// Printed straight into one buffer rather than built as a cJSON tree: the
+// tree would be six nodes and five key copies per pixel, far more than a
+// request's JSON arena holds. The output is what cJSON_PrintUnformatted()
+// gives for that tree.
+char *pixel_json_serialize(void)
+{
+    const size_t size = 2 + (size_t)RGB_COUNT * ENTRY_MAX + 1;
+    char *json_str = cJSON_malloc(size);
+    if (!json_str) return NULL;
+
+    char *p = json_str, *end = json_str + size - 2;   // room for "]\0"
+    *p++ = '[';
+    for(int row=0; row<MATRIX_ROWS; row++) {
+        for(int col=0; col<MATRIX_COLS; col++) {
+            pixel_color_t color = framebuffer_pixel(row, col);
+            int n = snprintf(p, end - p, "%s{\"row\":%d,\"col\":%d,\"r\":%d,\"g\":%d,\"b\":%d}",
+                             row || col ? "," : "", row, col, color.r, color.g, color.b);
+            if (n < 0 || n >= end - p) {
+                cJSON_free(json_str);
+                return NULL;
+            }
+            p += n;
+        }
+    }
+    *p++ = ']';
+    *p = '\0';
+    return json_str;
+}
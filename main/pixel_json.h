@@ -0,0 +1,18 @@
+#ifndef PIXEL_JSON_H
+#define PIXEL_JSON_H
+
+#include "cJSON.h"
+
+// JSON side of /pixel and /pixels, kept free of HTTP so the benchmarks can
+// drive it directly.
+
+// Applies a /pixel body: either {"fill": "yes", "r", "g", "b"} or
+// {"updates": [{"row", "col", "r", "g", "b"}, ...]}. Returns 0 on success,
+// -1 if neither form is present.
+int pixel_json_apply(const cJSON *root);
+
+// Serialises the framebuffer as the /pixels array, or returns NULL if it
+// cannot be allocated. Caller frees with cJSON_free().
+char *pixel_json_serialize(void);
+
+#endif // PIXEL_JSON_H
@@ -0,0 +1,61 @@
+#include <cstring>
+#include "pixel_pipeline.hpp"
+
+namespace pp = pixel_pipeline;
+
+namespace {
+
+#if LED_WIRE_FORMAT == LED_WIRE_GRB
+using PanelFormat = pp::Grb;
+#elif LED_WIRE_FORMAT == LED_WIRE_RGBW
+using PanelFormat = pp::Rgbw;
+#else
+using PanelFormat = pp::Rgb;
+#endif
+
+using PanelLayout = pp::Layout<MATRIX_COLS, MATRIX_ROWS, MATRIX_SERPENTINE != 0>;
+constexpr bool kGamma = LED_GAMMA != 0;
+
+static_assert(PanelLayout::count == RGB_COUNT, "layout does not cover the matrix");
+static_assert(PanelFormat::bytes == LED_WIRE_BYTES, "LED_WIRE_BYTES does not match the format");
+
+// Brightness table for the uncalibrated path, rebuilt when brightness changes.
+uint8_t scale_lut[256];
+int scale_lut_brightness = -1;
+
+void build_scale_lut(uint8_t brightness)
+{
+    for (int v = 0; v < 256; v++) {
+        int x = kGamma ? pp::gamma22[v] : v;
+        scale_lut[v] = static_cast<uint8_t>((x * brightness) / 255);
+    }
+    scale_lut_brightness = brightness;
+}
+
+} // namespace
+
+extern "C" void pixel_pipeline_run(const pixel_color_t *frame, calibration_t *cal, uint8_t brightness,
+                                   pixel_color_t *sent, uint8_t *wire)
+{
+    switch (cal->format) {
+        case CALIB_GAIN:
+            calibration_prepare(cal, brightness);
+            pp::run<PanelFormat, PanelLayout>(frame, sent, wire, pp::Gain<kGamma>{cal->fused});
+            break;
+        case CALIB_MATRIX:
+            calibration_prepare(cal, brightness);
+            pp::run<PanelFormat, PanelLayout>(frame, sent, wire, pp::Matrix<kGamma>{cal->fused});
+            break;
+        default:
+            if (scale_lut_brightness != brightness) build_scale_lut(brightness);
+            pp::run<PanelFormat, PanelLayout>(frame, sent, wire, pp::Scale{scale_lut});
+            break;
+    }
+}
+
+// Lives here rather than in matrix_state.c so the table is built by the
+// compiler along with the gamma curve.
+extern "C" void palette_fill_hue_wheel(pixel_color_t *pal)
+{
+    std::memcpy(pal, pp::hue_wheel.data(), sizeof(pp::hue_wheel));
+}
@@ -0,0 +1,43 @@
+#ifndef PIXEL_PIPELINE_H
+#define PIXEL_PIPELINE_H
+
+#include <stdint.h>
+#include "matrix_state.h"
+#include "calibration.h"
+
+// Byte order on the wire, chosen at build time. This panel takes rgb.
+#define LED_WIRE_RGB  0
+#define LED_WIRE_GRB  1
+#define LED_WIRE_RGBW 2
+#ifndef LED_WIRE_FORMAT
+#define LED_WIRE_FORMAT LED_WIRE_RGB
+#endif
+
+// 1 applies a gamma 2.2 curve before brightness.
+#ifndef LED_GAMMA
+#define LED_GAMMA 0
+#endif
+
+#if LED_WIRE_FORMAT == LED_WIRE_RGBW
+#define LED_WIRE_BYTES 4
+#else
+#define LED_WIRE_BYTES 3
+#endif
+#define PIXEL_PIPELINE_BYTES (RGB_COUNT * LED_WIRE_BYTES)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Turns a composed frame into the bytes for the strip: gamma, brightness
+// and calibration, then byte order and wiring. wire is in
+// strip order, PIXEL_PIPELINE_BYTES long; sent receives the final colour
+// of each pixel in matrix order, for the flight recorder.
+void pixel_pipeline_run(const pixel_color_t *frame, calibration_t *cal, uint8_t brightness,
+                        pixel_color_t *sent, uint8_t *wire);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PIXEL_PIPELINE_H
@@ -0,0 +1,181 @@
+#ifndef PIXEL_PIPELINE_HPP
+#define PIXEL_PIPELINE_HPP
+
+// Output stage building blocks. A pipeline is a wire format, a layout and
+// a colour stage; run<>() instantiates one per combination, with the
+// geometry and tables fixed at compile time so the compiler can unroll
+// the loops and fold the stages into them.
+
+#include <array>
+#include <cstdint>
+extern "C" {
+#include "pixel_pipeline.h"
+}
+
+namespace pixel_pipeline {
+
+// Tables
+
+// x^(1/5) by Newton's method; std::pow is not constexpr.
+constexpr double root5(double x)
+{
+    if (x <= 0) return 0;
+    double y = 1;
+    for (int i = 0; i < 64; i++) {
+        y -= (y * y * y * y * y - x) / (5 * y * y * y * y);
+    }
+    return y;
+}
+
+constexpr std::array<uint8_t, 256> make_gamma22()
+{
+    std::array<uint8_t, 256> t{};
+    for (int i = 0; i < 256; i++) {
+        double x = i / 255.0;
+        t[i] = static_cast<uint8_t>(x * x * root5(x) * 255 + 0.5);
+    }
+    return t;
+}
+
+inline constexpr std::array<uint8_t, 256> gamma22 = make_gamma22();
+
+// The rainbow palette: hsv2rgb() at full saturation and value for
+// PALETTE_SIZE hues, in the same float arithmetic so it matches exactly.
+constexpr std::array<pixel_color_t, PALETTE_SIZE> make_hue_wheel()
+{
+    std::array<pixel_color_t, PALETTE_SIZE> t{};
+    for (int i = 0; i < PALETTE_SIZE; i++) {
+        float h = i * (360.0f / PALETTE_SIZE);
+        float sector = h / 60.0f;
+        float mod2 = sector - 2.0f * static_cast<int>(sector / 2.0f);
+        float d = mod2 - 1;
+        float x = 1 - (d < 0 ? -d : d);
+        uint8_t c8 = 255, x8 = static_cast<uint8_t>(x * 255);
+        if (h < 60) t[i] = {c8, x8, 0};
+        else if (h < 120) t[i] = {x8, c8, 0};
+        else if (h < 180) t[i] = {0, c8, x8};
+        else if (h < 240) t[i] = {0, x8, c8};
+        else if (h < 300) t[i] = {x8, 0, c8};
+        else t[i] = {c8, 0, x8};
+    }
+    return t;
+}
+
+inline constexpr std::array<pixel_color_t, PALETTE_SIZE> hue_wheel = make_hue_wheel();
+
+// Wire formats
+
+struct Rgb {
+    static constexpr int bytes = 3;
+    static void put(uint8_t *p, uint8_t r, uint8_t g, uint8_t b) { p[0] = r; p[1] = g; p[2] = b; }
+};
+
+struct Grb {
+    static constexpr int bytes = 3;
+    static void put(uint8_t *p, uint8_t r, uint8_t g, uint8_t b) { p[0] = g; p[1] = r; p[2] = b; }
+};
+
+// The common part of the three channels goes to the white LED.
+struct Rgbw {
+    static constexpr int bytes = 4;
+    static void put(uint8_t *p, uint8_t r, uint8_t g, uint8_t b)
+    {
+        uint8_t w = r < g ? (r < b ? r : b) : (g < b ? g : b);
+        p[0] = r - w; p[1] = g - w; p[2] = b - w; p[3] = w;
+    }
+};
+
+// Geometry: where matrix pixel i (row-major) sits on the strip.
+
+template <int Cols, int Rows, bool Serpentine>
+struct Layout {
+    static constexpr int count = Cols * Rows;
+
+    static constexpr std::array<uint16_t, count> make_map()
+    {
+        std::array<uint16_t, count> map{};
+        for (int row = 0; row < Rows; row++) {
+            for (int col = 0; col < Cols; col++) {
+                int strip_col = (Serpentine && (row & 1)) ? Cols - 1 - col : col;
+                map[row * Cols + col] = static_cast<uint16_t>(row * Cols + strip_col);
+            }
+        }
+        return map;
+    }
+
+    static constexpr std::array<uint16_t, count> map = make_map();
+
+    static constexpr int index(int i) { return Serpentine ? map[i] : i; }
+};
+
+// Colour stages: the final rgb for pixel i.
+
+// Brightness, and gamma if enabled, through one 256-entry table.
+struct Scale {
+    const uint8_t *lut;
+
+    void operator()(int, const pixel_color_t &in, uint8_t &r, uint8_t &g, uint8_t &b) const
+    {
+        r = lut[in.r]; g = lut[in.g]; b = lut[in.b];
+    }
+};
+
+// Per-LED channel gains with brightness folded in (calibration_t::fused).
+template <bool Gamma>
+struct Gain {
+    const int32_t (*k)[9];
+
+    static uint8_t in(uint8_t v) { return Gamma ? gamma22[v] : v; }
+
+    void operator()(int i, const pixel_color_t &px, uint8_t &r, uint8_t &g, uint8_t &b) const
+    {
+        r = static_cast<uint8_t>((in(px.r) * k[i][0]) >> 16);
+        g = static_cast<uint8_t>((in(px.g) * k[i][1]) >> 16);
+        b = static_cast<uint8_t>((in(px.b) * k[i][2]) >> 16);
+    }
+};
+
+// Per-LED 3x3 colour matrix with brightness folded in.
+template <bool Gamma>
+struct Matrix {
+    const int32_t (*k)[9];
+
+    static int32_t in(uint8_t v) { return Gamma ? gamma22[v] : v; }
+
+    static uint8_t clamp(int32_t v)
+    {
+        if (v <= 0) return 0;
+        v >>= 16;
+        return v > 255 ? 255 : static_cast<uint8_t>(v);
+    }
+
+    void operator()(int i, const pixel_color_t &px, uint8_t &r, uint8_t &g, uint8_t &b) const
+    {
+        const int32_t *m = k[i];
+        int32_t pr = in(px.r), pg = in(px.g), pb = in(px.b);
+        r = clamp(m[0] * pr + m[1] * pg + m[2] * pb);
+        g = clamp(m[3] * pr + m[4] * pg + m[5] * pb);
+        b = clamp(m[6] * pr + m[7] * pg + m[8] * pb);
+    }
+};
+
+// Two passes: the colour stage into sent, then sent into wire in strip
+// order. Writing both a byte at a time from one loop came out slower on
+// the host than the plain C gain path, which writes no wire bytes at all;
+// split, with the buffers known not to overlap, each loop stays simple
+// and the second is a straight copy for Rgb without serpentine wiring.
+template <class Format, class Geometry, class Stage>
+inline void run(const pixel_color_t *__restrict frame, pixel_color_t *__restrict sent,
+                uint8_t *__restrict wire, const Stage &stage)
+{
+    for (int i = 0; i < Geometry::count; i++) {
+        stage(i, frame[i], sent[i].r, sent[i].g, sent[i].b);
+    }
+    for (int i = 0; i < Geometry::count; i++) {
+        Format::put(wire + Geometry::index(i) * Format::bytes, sent[i].r, sent[i].g, sent[i].b);
+    }
+}
+
+} // namespace pixel_pipeline
+
+#endif // PIXEL_PIPELINE_HPP
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "led_control.h"
+#include "playlist.h"
+
+static const char *TAG = "matrix32_playlist";
+
+#define PLAYLIST_NVS_NAMESPACE "matrix32"
+#define PLAYLIST_FADE_FRAME_MS 20
+
+// Shared between the web server, the switch timer and the render task.
+static portMUX_TYPE playlist_lock = portMUX_INITIALIZER_UNLOCKED;
+static playlist_entry_t entries[PLAYLIST_MAX_ENTRIES];
+static uint8_t entry_count = 0;
+static uint8_t current_index = 0;
+static bool running = false;
+static uint32_t generation = 0;
+static uint32_t frames_version = 0;     // bumped when a slot is rewritten
+static int64_t started_us = 0;
+static int64_t next_switch_us = 0;
+static esp_timer_handle_t switch_timer = NULL;
+
+// Render task only. Frames for the current entry live in one half of
+// entry_frames while the next entry's frames are staged in the other, so a
+// switch is a buffer flip rather than a flash read.
+static pixel_color_t entry_frames[2][PLAYLIST_CLIP_MAX][RGB_COUNT];
+static int active_buf = 0;
+static int staged_index = -1;
+static int shown_index = -1;
+static uint32_t seen_generation = 0;
+static uint32_t seen_frames_version = 0;
+static pixel_color_t last_frame[RGB_COUNT];
+static pixel_color_t fade_from[RGB_COUNT];
+static bool fading = false;
+static int64_t fade_start_us = 0;
+static uint16_t fade_ms = 0;
+
+// Smoothstep easing, 8-bit in and out, computed once at init.
+static uint8_t fade_curve[256];
+
+static void switch_timer_cb(void *arg)
+{
+    portENTER_CRITICAL(&playlist_lock);
+    if (!running || entry_count == 0) {
+        portEXIT_CRITICAL(&playlist_lock);
+        return;
+    }
+    current_index = (current_index + 1) % entry_count;
+    // Schedule from the planned switch time, not from now, so timer
+    // latency never accumulates into drift.
+    started_us = next_switch_us;
+    next_switch_us = started_us + (int64_t)entries[current_index].duration_ms * 1000;
+    int64_t wait_us = next_switch_us - esp_timer_get_time();
+    portEXIT_CRITICAL(&playlist_lock);
+
+    esp_timer_start_once(switch_timer, wait_us > 0 ? wait_us : 1);
+    led_request_frame();
+}
+
+static void frame_key(int slot, char *key, size_t len)
+{
+    snprintf(key, len, "frame%02d", slot);
+}
+
+esp_err_t playlist_save_frame(int slot, const pixel_color_t *frame)
+{
+    if (slot < 0 || slot >= PLAYLIST_MAX_SLOTS) return ESP_ERR_INVALID_ARG;
+
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(PLAYLIST_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    char key[16];
+    frame_key(slot, key, sizeof(key));
+    err = nvs_set_blob(nvs, key, frame, RGB_COUNT * sizeof(pixel_color_t));
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+
+    // The render task reloads its staged copy in case it used this slot.
+    portENTER_CRITICAL(&playlist_lock);
+    frames_version++;
+    portEXIT_CRITICAL(&playlist_lock);
+    return err;
+}
+
+static void load_entry_frames(const playlist_entry_t *entry, pixel_color_t (*frames)[RGB_COUNT])
+{
+    int count = 0;
+    if (entry->type == PLAYLIST_ENTRY_FRAME) count = 1;
+    if (entry->type == PLAYLIST_ENTRY_CLIP) count = entry->count;
+    if (count == 0) return;
+
+    nvs_handle_t nvs;
+    bool opened = nvs_open(PLAYLIST_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK;
+    for (int i = 0; i < count; i++) {
+        char key[16];
+        size_t len = RGB_COUNT * sizeof(pixel_color_t);
+        frame_key(entry->slot + i, key, sizeof(key));
+        if (!opened || nvs_get_blob(nvs, key, frames[i], &len) != ESP_OK) {
+            memset(frames[i], 0, sizeof(frames[i]));
+        }
+    }
+    if (opened) nvs_close(nvs);
+}
+
+static esp_err_t persist(void)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(PLAYLIST_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+    err = nvs_set_blob(nvs, "playlist", entries, entry_count * sizeof(playlist_entry_t));
+    if (err == ESP_OK) err = nvs_set_u8(nvs, "pl_running", running);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    nvs_close(nvs);
+    return err;
+}
+
+static void start_locked(void)
+{
+    current_index = 0;
+    running = entry_count > 0;
+    generation++;
+    started_us = esp_timer_get_time();
+    next_switch_us = started_us + (int64_t)entries[0].duration_ms * 1000;
+}
+
+static bool entry_valid(const playlist_entry_t *e)
+{
+    if (e->duration_ms == 0) return false;
+    switch (e->type) {
+        case PLAYLIST_ENTRY_MODE:
+            return e->mode < MODE_COUNT;
+        case PLAYLIST_ENTRY_FRAME:
+            return e->slot < PLAYLIST_MAX_SLOTS;
+        case PLAYLIST_ENTRY_CLIP:
+            return e->count > 0 && e->count <= PLAYLIST_CLIP_MAX && e->fps > 0 &&
+                   e->slot + e->count <= PLAYLIST_MAX_SLOTS;
+    }
+    return false;
+}
+
+esp_err_t playlist_set(const playlist_entry_t *new_entries, int count)
+{
+    if (count <= 0 || count > PLAYLIST_MAX_ENTRIES) return ESP_ERR_INVALID_ARG;
+    for (int i = 0; i < count; i++) {
+        if (!entry_valid(&new_entries[i])) return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_timer_stop(switch_timer);
+    portENTER_CRITICAL(&playlist_lock);
+    memcpy(entries, new_entries, count * sizeof(playlist_entry_t));
+    entry_count = count;
+    start_locked();
+    int64_t wait_us = next_switch_us - esp_timer_get_time();
+    portEXIT_CRITICAL(&playlist_lock);
+
+    esp_timer_start_once(switch_timer, wait_us > 0 ? wait_us : 1);
+    led_request_frame();
+    ESP_LOGI(TAG, "Playlist started with %d entries", count);
+    return persist();
+}
+
+void playlist_stop(void)
+{
+    esp_timer_stop(switch_timer);
+    portENTER_CRITICAL(&playlist_lock);
+    running = false;
+    generation++;
+    portEXIT_CRITICAL(&playlist_lock);
+    persist();
+    update_display();
+}
+
+bool playlist_is_running(void)
+{
+    return running;
+}
+
+void playlist_get_status(playlist_status_t *status)
+{
+    portENTER_CRITICAL(&playlist_lock);
+    status->running = running;
+    status->index = current_index;
+    status->count = entry_count;
+    status->started_us = started_us;
+    status->next_switch_us = next_switch_us;
+    portEXIT_CRITICAL(&playlist_lock);
+}
+
+int playlist_get_entries(playlist_entry_t *out)
+{
+    portENTER_CRITICAL(&playlist_lock);
+    int count = entry_count;
+    memcpy(out, entries, count * sizeof(playlist_entry_t));
+    portEXIT_CRITICAL(&playlist_lock);
+    return count;
+}
+
+esp_err_t playlist_init(void)
+{
+    for (int i = 0; i < 256; i++) {
+        fade_curve[i] = (uint8_t)((i * i * (3 * 255 - 2 * i)) / (255 * 255));
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = switch_timer_cb,
+        .name = "playlist"
+    };
+    esp_err_t err = esp_timer_create(&timer_args, &switch_timer);
+    if (err != ESP_OK) return err;
+
+    nvs_handle_t nvs;
+    if (nvs_open(PLAYLIST_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return ESP_OK;  // nothing stored yet
+    }
+    size_t len = sizeof(entries);
+    uint8_t was_running = 0;
+    if (nvs_get_blob(nvs, "playlist", entries, &len) == ESP_OK &&
+        len % sizeof(playlist_entry_t) == 0) {
+        entry_count = len / sizeof(playlist_entry_t);
+    }
+    nvs_get_u8(nvs, "pl_running", &was_running);
+    nvs_close(nvs);
+
+    // Written by an older build, or corrupt: start without a playlist.
+    for (int i = 0; i < entry_count; i++) {
+        if (!entry_valid(&entries[i])) {
+            ESP_LOGW(TAG, "Stored playlist entry %d is invalid, discarding playlist", i);
+            entry_count = 0;
+            break;
+        }
+    }
+
+    if (was_running && entry_count > 0) {
+        ESP_LOGI(TAG, "Resuming stored playlist (%d entries)", entry_count);
+        portENTER_CRITICAL(&playlist_lock);
+        start_locked();
+        portEXIT_CRITICAL(&playlist_lock);
+        esp_timer_start_once(switch_timer, (uint64_t)entries[0].duration_ms * 1000);
+    }
+    return ESP_OK;
+}
+
+bool playlist_render(pixel_color_t *frame, int *delay_ms)
+{
+    portENTER_CRITICAL(&playlist_lock);
+    if (!running) {
+        portEXIT_CRITICAL(&playlist_lock);
+        return false;
+    }
+    uint32_t gen = generation;
+    uint32_t frames = frames_version;
+    int index = current_index;
+    int next_index = (current_index + 1) % entry_count;
+    playlist_entry_t entry = entries[index];
+    playlist_entry_t next_entry = entries[next_index];
+    int64_t entry_start_us = started_us;
+    portEXIT_CRITICAL(&playlist_lock);
+
+    int64_t now = esp_timer_get_time();
+    if (gen != seen_generation) {
+        seen_generation = gen;
+        shown_index = -1;
+        staged_index = -1;
+    }
+    if (frames != seen_frames_version) {
+        seen_frames_version = frames;
+        staged_index = -1;
+    }
+
+    bool switched = index != shown_index;
+    if (switched) {
+        if (staged_index == index) {
+            active_buf ^= 1;
+        } else {
+            load_entry_frames(&entry, entry_frames[active_buf]);
+        }
+        staged_index = -1;
+        shown_index = index;
+
+        fading = entry.transition == PLAYLIST_TRANSITION_FADE && entry.fade_ms > 0;
+        fade_start_us = entry_start_us;
+        fade_ms = entry.fade_ms;
+        memcpy(fade_from, last_frame, sizeof(fade_from));
+    }
+
+    int delay;
+    switch (entry.type) {
+        case PLAYLIST_ENTRY_MODE:
+            delay = led_render_mode(entry.mode, frame);
+            break;
+        case PLAYLIST_ENTRY_CLIP: {
+            int n = (int)(((now - entry_start_us) * entry.fps / 1000000) % entry.count);
+            memcpy(frame, entry_frames[active_buf][n], sizeof(last_frame));
+            delay = 1000 / entry.fps;
+            break;
+        }
+        default:
+            memcpy(frame, entry_frames[active_buf][0], sizeof(last_frame));
+            delay = 1000;
+            break;
+    }
+
+    if (fading) {
+        int64_t elapsed_ms = (now - fade_start_us) / 1000;
+        if (elapsed_ms >= fade_ms) {
+            fading = false;
+        } else {
+            int alpha = fade_curve[(elapsed_ms * 255) / fade_ms];
+            for (int i = 0; i < RGB_COUNT; i++) {
+                frame[i].r = fade_from[i].r + (((frame[i].r - fade_from[i].r) * alpha) >> 8);
+                frame[i].g = fade_from[i].g + (((frame[i].g - fade_from[i].g) * alpha) >> 8);
+                frame[i].b = fade_from[i].b + (((frame[i].b - fade_from[i].b) * alpha) >> 8);
+            }
+            if (delay > PLAYLIST_FADE_FRAME_MS) delay = PLAYLIST_FADE_FRAME_MS;
+        }
+    }
+    memcpy(last_frame, frame, sizeof(last_frame));
+
+    // Stage the next entry's stored frames one frame after a switch, well
+    // ahead of the next one, so a switch itself never waits on flash.
+    if (!switched && staged_index < 0 && next_index != index) {
+        load_entry_frames(&next_entry, entry_frames[active_buf ^ 1]);
+        staged_index = next_index;
+    }
+
+    *delay_ms = delay;
+    return true;
+}
@@ -0,0 +1,58 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "matrix_state.h"
+
+#define PLAYLIST_MAX_ENTRIES 16
+#define PLAYLIST_MAX_SLOTS   16   // stored frames, NVS keys "frame00".."frame15"
+#define PLAYLIST_CLIP_MAX    8    // frames per clip entry
+
+typedef enum {
+    PLAYLIST_ENTRY_MODE = 0,   // a built-in display mode
+    PLAYLIST_ENTRY_FRAME,      // one stored frame
+    PLAYLIST_ENTRY_CLIP        // consecutive stored frames at a fixed rate
+} playlist_entry_type_t;
+
+typedef enum {
+    PLAYLIST_TRANSITION_CUT = 0,
+    PLAYLIST_TRANSITION_FADE
+} playlist_transition_t;
+
+typedef struct {
+    uint8_t type;           // playlist_entry_type_t
+    uint8_t mode;           // display_mode_t for PLAYLIST_ENTRY_MODE
+    uint8_t slot;           // first frame slot for FRAME/CLIP
+    uint8_t count;          // CLIP frame count
+    uint8_t fps;            // CLIP playback rate
+    uint8_t transition;     // playlist_transition_t into this entry
+    uint16_t fade_ms;
+    uint32_t duration_ms;
+} playlist_entry_t;
+
+typedef struct {
+    bool running;
+    uint8_t index;
+    uint8_t count;
+    int64_t started_us;     // esp_timer time the current entry started
+    int64_t next_switch_us; // esp_timer time of the next switch
+} playlist_status_t;
+
+esp_err_t playlist_init(void);
+esp_err_t playlist_set(const playlist_entry_t *entries, int count);
+void playlist_stop(void);
+bool playlist_is_running(void);
+void playlist_get_status(playlist_status_t *status);
+int playlist_get_entries(playlist_entry_t *entries);
+
+// Stores a frame in slot 0..PLAYLIST_MAX_SLOTS-1; ESP_ERR_INVALID_ARG
+// for any other slot.
+esp_err_t playlist_save_frame(int slot, const pixel_color_t *frame);
+
+// Called by the render task each frame. Returns false when no playlist is
+// running; otherwise fills frame and the time until the next frame is due.
+bool playlist_render(pixel_color_t *frame, int *delay_ms);
+
+#endif // PLAYLIST_H
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_freertos_hooks.h"
+#include "esp_log.h"
+#include "profiler.h"
+
+static const char *TAG = "matrix32_profiler";
+
+static volatile bool active = false;
+
+// Written only by the owning core's tick interrupt while active, read only
+// once sampling has stopped.
+static uint32_t samples[portNUM_PROCESSORS][PROFILER_MAX_SAMPLES];
+static volatile uint32_t sample_count[portNUM_PROCESSORS];
+static volatile uint32_t sample_dropped[portNUM_PROCESSORS];
+
+// Render task only.
+static profiler_effect_t effects[MODE_COUNT];
+
+// Runs inside the tick interrupt. Interrupt entry stores the interrupted
+// task's stack pointer in its TCB (the first word, pxTopOfStack), which
+// then points at the saved exception frame: exit, pc, ps, a0...
+static void IRAM_ATTR sample_tick(void)
+{
+    if (!active) return;
+    int core = xPortGetCoreID();
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    if (!task) return;
+    const uint32_t *frame = *(uint32_t *const *)task;
+    uint32_t n = sample_count[core];
+    if (n >= PROFILER_MAX_SAMPLES) {
+        sample_dropped[core]++;
+        return;
+    }
+    samples[core][n] = frame[1];
+    sample_count[core] = n + 1;
+}
+
+void profiler_init(void)
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        if (esp_register_freertos_tick_hook_for_cpu(sample_tick, core) != ESP_OK) {
+            ESP_LOGW(TAG, "No tick hook slot on core %d", core);
+        }
+    }
+}
+
+void profiler_start(void)
+{
+    active = false;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        sample_count[core] = 0;
+        sample_dropped[core] = 0;
+    }
+    memset(effects, 0, sizeof(effects));
+    active = true;
+}
+
+void profiler_stop(void)
+{
+    active = false;
+}
+
+bool profiler_running(void)
+{
+    return active;
+}
+
+void profiler_effect_time(display_mode_t mode, uint32_t us)
+{
+    if (!active || mode >= MODE_COUNT) return;
+    profiler_effect_t *e = &effects[mode];
+    e->frames++;
+    e->total_us += us;
+    if (us > e->max_us) e->max_us = us;
+}
+
+void profiler_get_effects(profiler_effect_t out[MODE_COUNT])
+{
+    memcpy(out, effects, sizeof(effects));
+}
+
+static int compare_pc(const void *a, const void *b)
+{
+    const profiler_pc_t *x = a, *y = b;
+    if (x->core != y->core) return x->core - y->core;
+    return x->pc < y->pc ? -1 : x->pc > y->pc;
+}
+
+static int compare_count(const void *a, const void *b)
+{
+    return ((const profiler_pc_t *)b)->count - ((const profiler_pc_t *)a)->count;
+}
+
+int profiler_samples(profiler_pc_t *out, int max, uint32_t *total, uint32_t *dropped)
+{
+    uint32_t n = 0;
+    *dropped = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        n += sample_count[core];
+        *dropped += sample_dropped[core];
+    }
+    *total = n + *dropped;
+    if (n == 0) return 0;
+
+    profiler_pc_t *all = malloc(n * sizeof(profiler_pc_t));
+    if (!all) return 0;
+    uint32_t k = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        for (uint32_t i = 0; i < sample_count[core]; i++) {
+            all[k++] = (profiler_pc_t){ .pc = samples[core][i], .count = 1, .core = core };
+        }
+    }
+
+    // Collapse repeats of the same address, then rank by how often each
+    // address was seen.
+    qsort(all, n, sizeof(profiler_pc_t), compare_pc);
+    uint32_t distinct = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        if (distinct > 0 && all[distinct - 1].pc == all[i].pc && all[distinct - 1].core == all[i].core) {
+            all[distinct - 1].count++;
+        } else {
+            all[distinct++] = all[i];
+        }
+    }
+    qsort(all, distinct, sizeof(profiler_pc_t), compare_count);
+
+    int written = distinct < (uint32_t)max ? (int)distinct : max;
+    memcpy(out, all, written * sizeof(profiler_pc_t));
+    free(all);
+    return written;
+}
@@ -0,0 +1,42 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix_state.h"
+
+// Sampling profiler behind GET /profile. While a window is open, the tick
+// interrupt on each core records the interrupted program counter, and the
+// render task reports how long each effect took. tools/profile.py turns
+// the sampled addresses into function names.
+
+#define PROFILER_MAX_SAMPLES 1024   // per core, 10 s at the 100 Hz tick
+
+typedef struct {
+    uint32_t pc;
+    uint16_t count;
+    uint8_t core;
+} profiler_pc_t;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t total_us;
+    uint32_t max_us;
+} profiler_effect_t;
+
+void profiler_init(void);
+void profiler_start(void);
+void profiler_stop(void);
+bool profiler_running(void);
+
+// Render task: one effects_render() call for mode took us microseconds.
+void profiler_effect_time(display_mode_t mode, uint32_t us);
+
+// After profiler_stop(): distinct sampled addresses, most frequent first.
+// Returns how many were written; *total and *dropped count all samples
+// and those that did not fit.
+int profiler_samples(profiler_pc_t *out, int max, uint32_t *total, uint32_t *dropped);
+
+void profiler_get_effects(profiler_effect_t effects[MODE_COUNT]);
+
+#endif // PROFILER_H
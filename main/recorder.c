@@ -0,0 +1,144 @@
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+#include "recorder.h"
+
+#define RECORD_HEADER_SIZE 9
+#define FILE_HEADER_SIZE   12
+#define FRAME_BYTES        (RGB_COUNT * 3)
+// Worst case for the encoder below: one extra token per 128 literal bytes,
+// plus one at each end.
+#define MAX_PAYLOAD        (FRAME_BYTES + FRAME_BYTES / 128 + 2)
+
+// Guarded by ring_mutex. The render task only ever tries to take it.
+static SemaphoreHandle_t ring_mutex = NULL;
+static uint8_t ring[RECORDER_BUFFER_SIZE];
+static size_t ring_tail = 0;      // oldest record
+static size_t ring_used = 0;
+static uint32_t record_count = 0;
+
+// Render task only.
+static uint8_t last_recorded[FRAME_BYTES];
+static uint32_t since_key = RECORDER_KEY_INTERVAL;
+static uint8_t scratch[RECORD_HEADER_SIZE + MAX_PAYLOAD];
+
+esp_err_t recorder_init(void)
+{
+    ring_mutex = xSemaphoreCreateMutex();
+    return ring_mutex ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+// XOR-delta plus run-length encoding. Literal runs absorb single unchanged
+// bytes, which is cheaper than breaking the run for them.
+static size_t encode_delta(const uint8_t *cur, const uint8_t *prev, size_t n, uint8_t *out)
+{
+    size_t i = 0, o = 0;
+    while (i < n) {
+        size_t run = 0;
+        while (i + run < n && run < 128 && cur[i + run] == prev[i + run]) run++;
+        if (run) {
+            out[o++] = 0x80 | (run - 1);
+            i += run;
+            continue;
+        }
+        size_t start = i;
+        uint8_t *token = &out[o++];
+        while (i < n && i - start < 128 &&
+               !(cur[i] == prev[i] && (i + 1 >= n || cur[i + 1] == prev[i + 1]))) {
+            out[o++] = cur[i] ^ prev[i];
+            i++;
+        }
+        *token = i - start - 1;
+    }
+    return o;
+}
+
+static void ring_read(size_t pos, uint8_t *dst, size_t len)
+{
+    size_t first = RECORDER_BUFFER_SIZE - pos;
+    if (first > len) first = len;
+    memcpy(dst, ring + pos, first);
+    memcpy(dst + first, ring, len - first);
+}
+
+static void ring_append(const uint8_t *src, size_t len)
+{
+    size_t head = (ring_tail + ring_used) % RECORDER_BUFFER_SIZE;
+    size_t first = RECORDER_BUFFER_SIZE - head;
+    if (first > len) first = len;
+    memcpy(ring + head, src, first);
+    memcpy(ring, src + first, len - first);
+    ring_used += len;
+}
+
+static void ring_evict_oldest(void)
+{
+    uint8_t header[RECORD_HEADER_SIZE];
+    ring_read(ring_tail, header, sizeof(header));
+    size_t len = RECORD_HEADER_SIZE + (header[7] | (header[8] << 8));
+    ring_tail = (ring_tail + len) % RECORDER_BUFFER_SIZE;
+    ring_used -= len;
+    record_count--;
+}
+
+void recorder_record(const pixel_color_t *frame, uint8_t mode, recorder_source_t source)
+{
+    static const uint8_t black[FRAME_BYTES];
+    if (!ring_mutex) return;
+
+    bool key = since_key >= RECORDER_KEY_INTERVAL;
+    const uint8_t *cur = (const uint8_t *)frame;
+    size_t len = encode_delta(cur, key ? black : last_recorded, FRAME_BYTES,
+                              scratch + RECORD_HEADER_SIZE);
+    uint32_t time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    scratch[0] = key ? 1 : 0;
+    scratch[1] = mode;
+    scratch[2] = source;
+    scratch[3] = time_ms;
+    scratch[4] = time_ms >> 8;
+    scratch[5] = time_ms >> 16;
+    scratch[6] = time_ms >> 24;
+    scratch[7] = len;
+    scratch[8] = len >> 8;
+    len += RECORD_HEADER_SIZE;
+
+    if (xSemaphoreTake(ring_mutex, 0) != pdTRUE) return;
+    while (RECORDER_BUFFER_SIZE - ring_used < len) {
+        ring_evict_oldest();
+    }
+    ring_append(scratch, len);
+    record_count++;
+    xSemaphoreGive(ring_mutex);
+
+    memcpy(last_recorded, cur, FRAME_BYTES);
+    since_key = key ? 1 : since_key + 1;
+}
+
+esp_err_t recorder_export(uint8_t **out, size_t *out_len)
+{
+    uint8_t *buf = malloc(FILE_HEADER_SIZE + RECORDER_BUFFER_SIZE);
+    if (!buf) return ESP_ERR_NO_MEM;
+
+    xSemaphoreTake(ring_mutex, portMAX_DELAY);
+    size_t used = ring_used;
+    uint32_t count = record_count;
+    ring_read(ring_tail, buf + FILE_HEADER_SIZE, used);
+    xSemaphoreGive(ring_mutex);
+
+    memcpy(buf, "M32R", 4);
+    buf[4] = 1;
+    buf[5] = MATRIX_COLS;
+    buf[6] = MATRIX_ROWS;
+    buf[7] = 0;
+    buf[8] = count;
+    buf[9] = count >> 8;
+    buf[10] = count >> 16;
+    buf[11] = count >> 24;
+
+    *out = buf;
+    *out_len = FILE_HEADER_SIZE + used;
+    return ESP_OK;
+}
@@ -0,0 +1,42 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "matrix_state.h"
+
+// Flight recorder: the last few seconds of frames exactly as they were sent
+// to the strip (after brightness), for diagnosing what a panel really showed.
+//
+// Each frame is XORed against the previously recorded one and the result
+// run-length encoded, so unchanged pixels cost almost nothing. Every
+// RECORDER_KEY_INTERVAL frames a keyframe is stored against black instead,
+// giving a decoder a starting point once older frames have been evicted.
+#define RECORDER_BUFFER_SIZE  (16 * 1024)
+#define RECORDER_KEY_INTERVAL 32
+
+#define RECORDER_MODE_NONE 0xff   // frame did not come from a display mode
+
+typedef enum {
+    RECORDER_SOURCE_HTTP = 0,   // static content set over the web API
+    RECORDER_SOURCE_EFFECT,     // a display mode's renderer
+    RECORDER_SOURCE_PLAYLIST,
+    RECORDER_SOURCE_NETWORK     // frames streamed to the panel
+} recorder_source_t;
+
+esp_err_t recorder_init(void);
+
+// Render task only. Never blocks: if an export is copying the buffer the
+// frame is skipped, and the next one is encoded against the last one kept.
+void recorder_record(const pixel_color_t *frame, uint8_t mode, recorder_source_t source);
+
+// Copies the recording into a new heap buffer, oldest frame first. Caller
+// frees. Layout, all little endian:
+//   "M32R", version (1), width, height, flags (0), record count (u32)
+//   per record: flags (bit 0 = keyframe), mode, source, time ms (u32),
+//               payload length (u16), payload
+// Payload tokens: 0x80|n = n+1 unchanged bytes, n = n+1 XOR bytes follow.
+esp_err_t recorder_export(uint8_t **out, size_t *out_len);
+
+#endif // RECORDER_H
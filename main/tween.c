@@ -0,0 +1,127 @@
+#include <string.h>
+#include "tween.h"
+
+// 256 steps plus an end point, so lookups can interpolate to the next entry.
+#define EASE_STEPS 256
+
+typedef struct {
+    void *target;           // NULL when the slot is free
+    uint8_t type;           // tween_type_t
+    uint8_t easing;
+    int32_t from;
+    int32_t to;
+    uint32_t start_ms;
+    uint32_t duration_ms;
+} tween_t;
+
+static uint16_t ease_tables[EASE_COUNT][EASE_STEPS + 1];
+static tween_t tweens[TWEEN_MAX];
+
+static const char *const easing_names[EASE_COUNT] = {
+    [EASE_LINEAR] = "linear",
+    [EASE_IN] = "in",
+    [EASE_OUT] = "out",
+    [EASE_IN_OUT] = "in_out",
+};
+
+void tween_init(void)
+{
+    for (int i = 0; i <= EASE_STEPS; i++) {
+        float x = (float)i / EASE_STEPS;
+        float y[EASE_COUNT] = {
+            [EASE_LINEAR] = x,
+            [EASE_IN] = x * x,
+            [EASE_OUT] = x * (2 - x),
+            [EASE_IN_OUT] = x * x * (3 - 2 * x),
+        };
+        for (int e = 0; e < EASE_COUNT; e++) {
+            ease_tables[e][i] = (uint16_t)(y[e] * TWEEN_ONE + 0.5f);
+        }
+    }
+    memset(tweens, 0, sizeof(tweens));
+}
+
+uint32_t tween_ease(easing_t easing, uint32_t elapsed_ms, uint32_t duration_ms)
+{
+    if (elapsed_ms >= duration_ms) return TWEEN_ONE;
+    if (easing >= EASE_COUNT) easing = EASE_LINEAR;
+    // Progress as 8.8 fixed point over the table.
+    uint32_t pos = (uint32_t)(((uint64_t)elapsed_ms * EASE_STEPS * 256) / duration_ms);
+    const uint16_t *table = ease_tables[easing];
+    int32_t a = table[pos >> 8], b = table[(pos >> 8) + 1];
+    return a + (((b - a) * (int32_t)(pos & 0xff)) >> 8);
+}
+
+static int32_t read_value(void *target, uint8_t type)
+{
+    return type == TWEEN_U8 ? *(uint8_t *)target : *(int32_t *)target;
+}
+
+static void write_value(void *target, uint8_t type, int32_t value)
+{
+    if (type == TWEEN_U8) {
+        *(uint8_t *)target = value < 0 ? 0 : value > 255 ? 255 : value;
+    } else {
+        *(int32_t *)target = value;
+    }
+}
+
+static tween_t *find(void *target)
+{
+    for (int i = 0; i < TWEEN_MAX; i++) {
+        if (tweens[i].target == target) return &tweens[i];
+    }
+    return NULL;
+}
+
+bool tween_start(void *target, tween_type_t type, int32_t to, uint32_t duration_ms,
+                 easing_t easing, uint32_t now_ms)
+{
+    tween_t *t = find(target);
+    if (!t) t = find(NULL);
+    if (!t || duration_ms == 0) {
+        if (t) t->target = NULL;
+        write_value(target, type, to);
+        return t != NULL;
+    }
+    t->type = type;
+    t->easing = easing < EASE_COUNT ? easing : EASE_LINEAR;
+    t->from = read_value(target, type);
+    t->to = to;
+    t->start_ms = now_ms;
+    t->duration_ms = duration_ms;
+    t->target = target;
+    return true;
+}
+
+void tween_cancel(void *target)
+{
+    tween_t *t = find(target);
+    if (t) t->target = NULL;
+}
+
+bool tween_tick(uint32_t now_ms)
+{
+    bool wrote = false;
+    for (int i = 0; i < TWEEN_MAX; i++) {
+        tween_t *t = &tweens[i];
+        if (!t->target) continue;
+        uint32_t elapsed = now_ms - t->start_ms;
+        uint32_t k = tween_ease(t->easing, elapsed, t->duration_ms);
+        int32_t value = t->from + (int32_t)(((int64_t)(t->to - t->from) * k) / TWEEN_ONE);
+        write_value(t->target, t->type, value);
+        wrote = true;
+        if (elapsed >= t->duration_ms) {
+            t->target = NULL;
+        }
+    }
+    return wrote;
+}
+
+int easing_from_name(const char *name)
+{
+    for (int i = 0; i < EASE_COUNT; i++) {
+        if (strcmp(name, easing_names[i]) == 0) return i;
+    }
+    return -1;
+}
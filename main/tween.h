@@ -0,0 +1,47 @@
+#ifndef TWEEN_H
+#define TWEEN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Tweens animate a numeric variable toward a target over a duration. They
+// hold no tasks or timers: the render task calls tween_tick() once per frame
+// with its own clock and every active tween writes its variable in place.
+#define TWEEN_MAX 16
+
+typedef enum {
+    EASE_LINEAR = 0,
+    EASE_IN,        // quadratic
+    EASE_OUT,
+    EASE_IN_OUT,    // cubic smoothstep
+    EASE_COUNT
+} easing_t;
+
+typedef enum {
+    TWEEN_U8 = 0,
+    TWEEN_I32
+} tween_type_t;
+
+void tween_init(void);
+
+// Starts animating *target from its current value to `to`. A tween already
+// running on the same variable is replaced, so retargeting mid-flight (e.g.
+// a slider drag) continues smoothly from wherever the value is. A zero
+// duration sets the value immediately. Returns false if all slots are busy,
+// in which case the value is set immediately too.
+bool tween_start(void *target, tween_type_t type, int32_t to, uint32_t duration_ms,
+                 easing_t easing, uint32_t now_ms);
+
+void tween_cancel(void *target);
+
+// Advances every tween to now_ms. Returns true if any variable was written,
+// including by tweens that finished on this tick.
+bool tween_tick(uint32_t now_ms);
+
+// Eased progress for elapsed/duration, 0..TWEEN_ONE.
+#define TWEEN_ONE 65535
+uint32_t tween_ease(easing_t easing, uint32_t elapsed_ms, uint32_t duration_ms);
+
+int easing_from_name(const char *name);
+
+#endif // TWEEN_H
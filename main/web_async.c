@@ -0,0 +1,127 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "web_async.h"
+#include "json_arena.h"
+
+static const char *TAG = "matrix32_async";
+
+// Either a detached request and its handler, or work and its argument.
+typedef struct {
+    httpd_req_t *req;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void (*work)(void *arg);
+    void *arg;
+} web_async_job_t;
+
+static QueueHandle_t job_queue = NULL;
+static TaskHandle_t workers[WEB_ASYNC_WORKERS];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static web_async_stats_t stats;
+
+static void worker_task(void *param)
+{
+    web_async_job_t job;
+    while (1) {
+        if (xQueueReceive(job_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.busy++;
+        portEXIT_CRITICAL(&stats_lock);
+
+        json_arena_begin();
+        if (job.req) {
+            job.handler(job.req);
+        } else {
+            job.work(job.arg);
+        }
+        json_arena_end();
+        if (job.req) httpd_req_async_handler_complete(job.req);
+
+        portENTER_CRITICAL(&stats_lock);
+        stats.busy--;
+        stats.completed++;
+        portEXIT_CRITICAL(&stats_lock);
+    }
+}
+
+esp_err_t web_async_init(void)
+{
+    job_queue = xQueueCreate(WEB_ASYNC_QUEUE_LEN, sizeof(web_async_job_t));
+    if (!job_queue) return ESP_ERR_NO_MEM;
+
+    for (int i = 0; i < WEB_ASYNC_WORKERS; i++) {
+        if (xTaskCreate(worker_task, "http_worker", WEB_ASYNC_STACK_SIZE, NULL, 5, &workers[i]) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to start worker %d", i);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    return ESP_OK;
+}
+
+bool web_async_on_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < WEB_ASYNC_WORKERS; i++) {
+        if (workers[i] == self) return true;
+    }
+    return false;
+}
+
+static void note_rejected(void)
+{
+    portENTER_CRITICAL(&stats_lock);
+    stats.rejected++;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+static void note_queued(void)
+{
+    uint32_t depth = uxQueueMessagesWaiting(job_queue);
+    portENTER_CRITICAL(&stats_lock);
+    if (depth > stats.max_queued) stats.max_queued = depth;
+    portEXIT_CRITICAL(&stats_lock);
+}
+
+esp_err_t web_async_submit(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req))
+{
+    // Refuse up front rather than detach a request nobody can pick up.
+    if (uxQueueSpacesAvailable(job_queue) == 0) {
+        note_rejected();
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_send(req, "{\"status\":\"busy\"}", -1);
+        return ESP_OK;
+    }
+
+    web_async_job_t job = { .handler = handler };
+    esp_err_t err = httpd_req_async_handler_begin(req, &job.req);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return err;
+    }
+    // Only the httpd task submits, so the space checked above is still free.
+    xQueueSend(job_queue, &job, 0);
+    note_queued();
+    return ESP_OK;
+}
+
+esp_err_t web_async_run(void (*work)(void *arg), void *arg)
+{
+    web_async_job_t job = { .work = work, .arg = arg };
+    if (xQueueSend(job_queue, &job, 0) != pdTRUE) {
+        note_rejected();
+        return ESP_ERR_NO_MEM;
+    }
+    note_queued();
+    return ESP_OK;
+}
+
+void web_async_get_stats(web_async_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+    out->queued = job_queue ? uxQueueMessagesWaiting(job_queue) : 0;
+}
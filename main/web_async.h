@@ -0,0 +1,38 @@
+#ifndef WEB_ASYNC_H
+#define WEB_ASYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+// Slow requests (NVS writes, benchmarks) are handed from the httpd task to
+// a small worker pool so they never hold up other clients.
+#define WEB_ASYNC_WORKERS    2
+#define WEB_ASYNC_QUEUE_LEN  6
+#define WEB_ASYNC_STACK_SIZE 6144
+
+typedef struct {
+    uint32_t queued;        // waiting for a worker right now
+    uint32_t max_queued;    // high-water mark of the above
+    uint32_t busy;          // workers currently running a handler
+    uint32_t completed;
+    uint32_t rejected;      // refused with 503 because the queue was full
+} web_async_stats_t;
+
+esp_err_t web_async_init(void);
+
+// True when called from one of the worker tasks.
+bool web_async_on_worker(void);
+
+// Detaches req from the httpd task and queues handler to run on a worker.
+// Sends 503 itself if the queue is full.
+esp_err_t web_async_submit(httpd_req_t *req, esp_err_t (*handler)(httpd_req_t *req));
+
+// Queues work(arg) to run on a worker, for jobs with no request to detach
+// (WebSocket frames). Returns ESP_ERR_NO_MEM if the queue is full; the
+// caller still owns arg then.
+esp_err_t web_async_run(void (*work)(void *arg), void *arg);
+
+void web_async_get_stats(web_async_stats_t *stats);
+
+#endif // WEB_ASYNC_H
@@ -0,0 +1,86 @@
+#include <string.h>
+#include "lwip/sockets.h"
+#include "esp_timer.h"
+#include "web_clients.h"
+
+#define TOKEN_ONE 1000
+
+static web_client_t clients[WEB_CLIENT_MAX];
+static int client_count = 0;
+
+static bool peer_address(httpd_req_t *req, uint8_t addr[16])
+{
+    struct sockaddr_storage peer;
+    socklen_t len = sizeof(peer);
+    if (getpeername(httpd_req_to_sockfd(req), (struct sockaddr *)&peer, &len) != 0) {
+        return false;
+    }
+    memset(addr, 0, 16);
+    if (peer.ss_family == AF_INET6) {
+        memcpy(addr, &((struct sockaddr_in6 *)&peer)->sin6_addr, 16);
+    } else {
+        addr[10] = addr[11] = 0xff;
+        memcpy(addr + 12, &((struct sockaddr_in *)&peer)->sin_addr, 4);
+    }
+    return true;
+}
+
+static void format_name(const uint8_t addr[16], char *name, size_t len)
+{
+    static const uint8_t v4_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (memcmp(addr, v4_prefix, sizeof(v4_prefix)) == 0) {
+        inet_ntop(AF_INET, addr + 12, name, len);
+    } else {
+        inet_ntop(AF_INET6, addr, name, len);
+    }
+}
+
+// Finds the client for addr, replacing the longest idle one when the table
+// is full. A new client starts with a full bucket.
+static web_client_t *lookup(const uint8_t addr[16], int64_t now)
+{
+    web_client_t *idlest = &clients[0];
+    for (int i = 0; i < client_count; i++) {
+        if (memcmp(clients[i].addr, addr, 16) == 0) return &clients[i];
+        if (clients[i].last_seen_us < idlest->last_seen_us) idlest = &clients[i];
+    }
+    web_client_t *c = client_count < WEB_CLIENT_MAX ? &clients[client_count++] : idlest;
+    memset(c, 0, sizeof(*c));
+    memcpy(c->addr, addr, 16);
+    format_name(addr, c->name, sizeof(c->name));
+    c->first_seen_us = now;
+    c->last_seen_us = now;
+    c->tokens = WEB_CLIENT_BURST * TOKEN_ONE;
+    return c;
+}
+
+bool web_client_admit(httpd_req_t *req)
+{
+    uint8_t addr[16];
+    if (!peer_address(req, addr)) return true;
+
+    int64_t now = esp_timer_get_time();
+    web_client_t *c = lookup(addr, now);
+
+    int64_t refill = (now - c->last_seen_us) * WEB_CLIENT_RATE / 1000;
+    int64_t tokens = c->tokens + refill;
+    if (tokens > WEB_CLIENT_BURST * TOKEN_ONE) tokens = WEB_CLIENT_BURST * TOKEN_ONE;
+    c->last_seen_us = now;
+
+    if (tokens < TOKEN_ONE) {
+        c->tokens = tokens;
+        c->limited++;
+        return false;
+    }
+    c->tokens = tokens - TOKEN_ONE;
+    c->requests++;
+    c->bytes_in += req->content_len;
+    return true;
+}
+
+int web_client_list(web_client_t *out, int max)
+{
+    int n = client_count < max ? client_count : max;
+    memcpy(out, clients, n * sizeof(web_client_t));
+    return n;
+}
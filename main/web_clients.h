@@ -0,0 +1,31 @@
+#ifndef WEB_CLIENTS_H
+#define WEB_CLIENTS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "esp_http_server.h"
+
+// Per-client accounting and token-bucket rate limiting, keyed by peer
+// address. Only touched from the httpd task, so it needs no locking.
+#define WEB_CLIENT_MAX    8
+#define WEB_CLIENT_RATE   30   // sustained requests per second
+#define WEB_CLIENT_BURST  60   // requests allowed back to back
+
+typedef struct {
+    uint8_t addr[16];       // IPv6, or IPv4-mapped
+    char name[40];
+    uint32_t requests;
+    uint32_t limited;       // requests refused with 429
+    uint64_t bytes_in;
+    int64_t first_seen_us;
+    int64_t last_seen_us;
+    int32_t tokens;         // in thousandths of a request
+} web_client_t;
+
+// Accounts for req and returns false if its client is over its rate.
+bool web_client_admit(httpd_req_t *req);
+
+// Copies out the clients seen so far; returns how many.
+int web_client_list(web_client_t *out, int max);
+
+#endif // WEB_CLIENTS_H
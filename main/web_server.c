@@ -1,16 +1,97 @@
 #include <string.h>
+#include <stdlib.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
 #include "cJSON.h"
 #include "matrix_ui.h"
 #include "matrix_state.h"
 #include "led_control.h"
+#include "draw.h"
+#include "playlist.h"
+#include "pixel_json.h"
+#include "bench.h"
+#include "web_async.h"
+#include "web_clients.h"
+#include "recorder.h"
+#include "compositor.h"
+#include "ws2812.h"
+#include "profiler.h"
+#include "frame_cache.h"
+#include "json_arena.h"
+#include "gif.h"
+#include "latency.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "web_server.h"
 
 static const char *TAG = "matrix32_web";
 static httpd_handle_t server = NULL;
 
+typedef struct {
+    esp_err_t (*handler)(httpd_req_t *req);
+    bool slow;              // runs on the async worker pool
+    bool websocket;         // frames are rate limited by the handler
+} web_route_t;
+
+static web_route_t routes[WEB_MAX_ROUTES];
+static int route_count = 0;
+
+// Reads the whole request body into a heap buffer. Caller frees.
+static uint8_t *recv_body(httpd_req_t *req, size_t max_len, size_t *out_len)
+{
+    if (req->content_len == 0 || req->content_len > max_len) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad body length");
+        return NULL;
+    }
+    uint8_t *body = malloc(req->content_len);
+    if (!body) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return NULL;
+    }
+    size_t received = 0;
+    while (received < req->content_len) {
+        int ret = httpd_req_recv(req, (char *)body + received, req->content_len - received);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret <= 0) {
+            free(body);
+            return NULL;
+        }
+        received += ret;
+    }
+    *out_len = received;
+    return body;
+}
+
+// Replies {"status":"ok",<fields>"trace":id,"latency":{...}} where latency
+// describes the newest request to reach the LEDs (traces finish a frame or
+// two after their reply) and the end-to-end percentiles so far.
+static esp_err_t send_traced_ok(httpd_req_t *req, const latency_trace_t *trace, const char *fields)
+{
+    latency_trace_t last;
+    latency_summary_t total;
+    char latency[112] = "null";
+    if (latency_get_recent(&last, 1) == 1) {
+        latency_get_summary(LATENCY_TOTAL, &total);
+        snprintf(latency, sizeof(latency),
+                 "{\"trace\":%lu,\"total_us\":%lu,\"p50_us\":%lu,\"p99_us\":%lu}",
+                 (unsigned long)last.id,
+                 (unsigned long)(last.end_us[LATENCY_TRANSMIT] - last.start_us),
+                 (unsigned long)total.p50_us, (unsigned long)total.p99_us);
+    }
+    char resp[192];
+    snprintf(resp, sizeof(resp), "{\"status\":\"ok\",%s\"trace\":%lu,\"latency\":%s}",
+             fields, (unsigned long)trace->id, latency);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
 esp_err_t pixel_handler(httpd_req_t *req) {
-    ESP_LOGI(TAG, "Pixel handler triggered");
+    ESP_LOGD(TAG, "Pixel handler triggered");
     
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
     httpd_resp_set_hdr(req, "Access-Control-Allow-Methods", "POST, GET, OPTIONS");
@@ -20,73 +101,406 @@ esp_err_t pixel_handler(httpd_req_t *req) {
         return ESP_OK;
     }
     
-    char content[256];
-    size_t recv_size = (req->content_len < sizeof(content)) ? req->content_len : sizeof(content);
-    
-    int ret = httpd_req_recv(req, content, recv_size);
-    if (ret <= 0) { return ESP_FAIL; }
+    latency_trace_t trace;
+    latency_begin(&trace);
+
+    size_t len;
+    char *content = (char *)recv_body(req, PIXEL_MAX_BODY, &len);
+    if (!content) return ESP_FAIL;
+    latency_stamp(&trace, LATENCY_RECV);
     
-    cJSON *root = cJSON_Parse(content);
+    cJSON *root = cJSON_ParseWithLength(content, len);
     if (!root) {
-        ESP_LOGE(TAG, "Failed to parse JSON: %s", content);
+        ESP_LOGE(TAG, "Failed to parse JSON: %.*s", (int)len, content);
+        free(content);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
         return ESP_FAIL;
     }
+    free(content);
+    latency_stamp(&trace, LATENCY_PARSE);
     
-    // Check for fill parameter first
-    cJSON *fill = cJSON_GetObjectItem(root, "fill");
-    if (fill && cJSON_IsString(fill) && strcmp(fill->valuestring, "yes") == 0) {
-        // Get the RGB values
-        cJSON *r = cJSON_GetObjectItem(root, "r");
-        cJSON *g = cJSON_GetObjectItem(root, "g");
-        cJSON *b = cJSON_GetObjectItem(root, "b");
-        
-        if (r && g && b) {
-            // Fill all pixels with the same color
-            for (int row = 0; row < MATRIX_ROWS; row++) {
-                for (int col = 0; col < MATRIX_COLS; col++) {
-                    framebuffer[row][col] = (pixel_color_t){
-                        r->valueint,
-                        g->valueint,
-                        b->valueint
-                    };
-                }
-            }
-            ESP_LOGI(TAG, "Filled all pixels with RGB(%d,%d,%d)", 
-                    r->valueint, g->valueint, b->valueint);
-        }
+    framebuffer_to_rgb();
+
+    if (pixel_json_apply(root) != 0) {
+        ESP_LOGE(TAG, "No 'updates' key in JSON");
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing updates");
+        return ESP_FAIL;
+    }
+    
+    // "stroke": true means more of the same stroke follows, and the undo
+    // step is made by the request that ends it.
+    bool stroke_open = cJSON_IsTrue(cJSON_GetObjectItem(root, "stroke"));
+    cJSON_Delete(root);
+    ESP_LOGD(TAG, "Calling update_display");
+    if (stroke_open) {
+        led_update_drawing(&trace);
     } else {
-        // Handle normal pixel updates array
-        cJSON *updates = cJSON_GetObjectItem(root, "updates");
-        if (!updates) {
-            ESP_LOGE(TAG, "No 'updates' key in JSON");
-            cJSON_Delete(root);
-            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing updates");
+        led_commit_drawing(&trace);
+    }
+    
+    return send_traced_ok(req, &trace, "");
+}
+
+// Copies a query string parameter into value; false if it is missing.
+static bool query_str(httpd_req_t *req, const char *key, char *value, size_t len)
+{
+    char query[64];
+    return httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+           httpd_query_key_value(query, key, value, len) == ESP_OK;
+}
+
+// Returns the integer value of a query string parameter, or -1.
+static int query_int(httpd_req_t *req, const char *key)
+{
+    char value[16];
+    return query_str(req, key, value, sizeof(value)) ? atoi(value) : -1;
+}
+
+// Binary drawing commands, see draw.h for the wire format. They go to the
+// framebuffer (the drawing layer) unless ?layer=overlay0|overlay1 is given.
+esp_err_t draw_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    int layer = LAYER_DRAWING;
+    char name[16];
+    if (query_str(req, "layer", name, sizeof(name))) {
+        layer = layer_from_name(name);
+        if (layer < LAYER_DRAWING) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown layer");
             return ESP_FAIL;
         }
-        
-        cJSON *update = NULL;
-        cJSON_ArrayForEach(update, updates) {
-            uint8_t row = cJSON_GetObjectItem(update, "row")->valueint;
-            uint8_t col = cJSON_GetObjectItem(update, "col")->valueint;
-            uint8_t r = cJSON_GetObjectItem(update, "r")->valueint;
-            uint8_t g = cJSON_GetObjectItem(update, "g")->valueint;
-            uint8_t b = cJSON_GetObjectItem(update, "b")->valueint;
-            
-            framebuffer[row][col] = (pixel_color_t){r, g, b};
-            ESP_LOGI(TAG, "Updating pixel (%d,%d) to RGB(%d,%d,%d)", row, col, r, g, b);
+    }
+
+    latency_trace_t trace;
+    latency_begin(&trace);
+
+    size_t len;
+    uint8_t *body = recv_body(req, DRAW_MAX_BODY, &len);
+    if (!body) return ESP_FAIL;
+    latency_stamp(&trace, LATENCY_RECV);
+
+    draw_canvas_t canvas;
+    if (layer == LAYER_DRAWING) {
+        framebuffer_to_rgb();
+        draw_canvas_framebuffer(&canvas);
+    } else {
+        canvas.pixels = compositor_layer(layer);
+        canvas.width = MATRIX_COLS;
+        canvas.height = MATRIX_ROWS;
+    }
+    // Commands are decoded and drawn in one pass, all of it counted as parse.
+    int count = draw_exec(&canvas, body, len);
+    free(body);
+    latency_stamp(&trace, LATENCY_PARSE);
+
+    if (count == -1) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Malformed draw commands");
+        return ESP_FAIL;
+    }
+    // A failed flood fill leaves what was drawn before it, so that is
+    // committed and shown either way.
+    if (layer == LAYER_DRAWING) {
+        led_commit_drawing(&trace);
+    } else {
+        latency_stamp(&trace, LATENCY_APPLY);
+        latency_submit(&trace);
+        compositor_mark_dirty(layer);
+        led_request_frame();
+    }
+    if (count < 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory for flood fill");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Executed %d draw commands on %s", count, layer_name(layer));
+
+    char fields[32];
+    snprintf(fields, sizeof(fields), "\"commands\":%d,", count);
+    return send_traced_ok(req, &trace, fields);
+}
+
+// Stores an uploaded frame in a playlist slot instead of showing it.
+static esp_err_t save_frame_slot(httpd_req_t *req, int slot, const uint8_t *body, size_t len)
+{
+    pixel_color_t frame[RGB_COUNT];
+    if (body[0] == FB_FORMAT_INDEXED && len == 1 + RGB_COUNT) {
+        for (int i = 0; i < RGB_COUNT; i++) {
+            frame[i] = palette[body[1 + i]];
         }
+    } else if (body[0] == FB_FORMAT_RGB && len == 1 + RGB_COUNT * 3) {
+        memcpy(frame, body + 1, sizeof(frame));
+    } else {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad frame format or size");
+        return ESP_FAIL;
     }
-    
-    cJSON_Delete(root);
-    ESP_LOGI(TAG, "Calling update_display");
+    if (playlist_save_frame(slot, frame) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Could not store frame slot");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+    return ESP_OK;
+}
+
+// Whole-frame upload: one format byte followed by either rgb triplets or
+// palette indices for every pixel, row-major. With ?slot=N the frame is
+// stored for playlists rather than displayed.
+esp_err_t frame_handler(httpd_req_t *req)
+{
+    // Storing a slot means an NVS write; keep that off the httpd task.
+    int slot = query_int(req, "slot");
+    if (slot >= 0 && !web_async_on_worker()) {
+        return web_async_submit(req, frame_handler);
+    }
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    latency_trace_t trace;
+    latency_begin(&trace);
+
+    size_t len;
+    uint8_t *body = recv_body(req, 1 + RGB_COUNT * 3, &len);
+    if (!body) return ESP_FAIL;
+    latency_stamp(&trace, LATENCY_RECV);
+
+    if (slot >= 0) {
+        esp_err_t ret = save_frame_slot(req, slot, body, len);
+        free(body);
+        return ret;
+    }
+
+    const uint8_t *data = body + 1;
+    if (body[0] == FB_FORMAT_INDEXED && len == 1 + RGB_COUNT) {
+        memcpy(index_framebuffer, data, RGB_COUNT);
+        framebuffer_format = FB_FORMAT_INDEXED;
+    } else if (body[0] == FB_FORMAT_RGB && len == 1 + RGB_COUNT * 3) {
+        memcpy(framebuffer, data, RGB_COUNT * 3);
+        framebuffer_format = FB_FORMAT_RGB;
+    } else {
+        free(body);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad frame format or size");
+        return ESP_FAIL;
+    }
+    free(body);
+    led_commit_drawing(&trace);
+
+    return send_traced_ok(req, &trace, "");
+}
+
+// Palette upload: first index, then rgb triplets for consecutive entries.
+esp_err_t palette_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, 1 + PALETTE_SIZE * 3, &len);
+    if (!body) return ESP_FAIL;
+
+    size_t count = (len - 1) / 3;
+    if ((len - 1) % 3 != 0 || body[0] + count > PALETTE_SIZE) {
+        free(body);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad palette range");
+        return ESP_FAIL;
+    }
+    memcpy(&palette[body[0]], body + 1, count * 3);
+    free(body);
     update_display();
-    
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+    return ESP_OK;
+}
+
+// Compiles a per-pixel effect expression and switches to it.
+// Body: {"expr": "hsv(t*0.1 + x/8, 1, 1)"}
+esp_err_t effect_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, EXPR_SRC_MAX + 64, &len);
+    if (!body) return ESP_FAIL;
+
+    cJSON *root = cJSON_ParseWithLength((const char *)body, len);
+    free(body);
+    cJSON *expr = root ? cJSON_GetObjectItem(root, "expr") : NULL;
+    if (!cJSON_IsString(expr)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing expr");
+        return ESP_FAIL;
+    }
+
+    expr_program_t prog;
+    char err[64];
+    if (expr_compile(expr->valuestring, &prog, err, sizeof(err)) != 0) {
+        ESP_LOGW(TAG, "Expression rejected: %s", err);
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, err);
+        return ESP_FAIL;
+    }
+    cJSON_Delete(root);
+
+    ESP_ERROR_CHECK(led_set_expression(&prog));
+    led_set_mode(MODE_EXPR, LED_DEFAULT_MODE_TRANSITION_MS, EASE_IN_OUT);
+
+    char resp[64];
+    snprintf(resp, sizeof(resp), "{\"status\":\"ok\",\"insns\":%d}", prog.len);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+// Reads a number in 0..max, checked before it is narrowed into an entry.
+static bool json_uint(const cJSON *item, double max, uint32_t *out)
+{
+    if (!cJSON_IsNumber(item) || item->valuedouble < 0 || item->valuedouble > max) return false;
+    *out = (uint32_t)item->valuedouble;
+    return true;
+}
+
+static bool parse_playlist_entry(const cJSON *item, playlist_entry_t *entry)
+{
+    const cJSON *type = cJSON_GetObjectItem(item, "type");
+    const cJSON *duration = cJSON_GetObjectItem(item, "duration");
+    const cJSON *transition = cJSON_GetObjectItem(item, "transition");
+    const cJSON *fade = cJSON_GetObjectItem(item, "fade");
+    uint32_t value;
+    if (!cJSON_IsString(type)) return false;
+
+    memset(entry, 0, sizeof(*entry));
+    if (!json_uint(duration, UINT32_MAX, &entry->duration_ms)) return false;
+    if (cJSON_IsString(transition) && strcmp(transition->valuestring, "fade") == 0) {
+        entry->transition = PLAYLIST_TRANSITION_FADE;
+        entry->fade_ms = 500;
+        if (fade) {
+            if (!json_uint(fade, UINT16_MAX, &value)) return false;
+            entry->fade_ms = value;
+        }
+    }
+
+    if (strcmp(type->valuestring, "mode") == 0) {
+        const cJSON *mode = cJSON_GetObjectItem(item, "mode");
+        int m = cJSON_IsString(mode) ? mode_from_name(mode->valuestring) : -1;
+        if (m < 0) return false;
+        entry->type = PLAYLIST_ENTRY_MODE;
+        entry->mode = m;
+    } else if (strcmp(type->valuestring, "frame") == 0 || strcmp(type->valuestring, "clip") == 0) {
+        if (!json_uint(cJSON_GetObjectItem(item, "slot"), PLAYLIST_MAX_SLOTS - 1, &value)) return false;
+        entry->slot = value;
+        if (type->valuestring[0] == 'c') {
+            entry->type = PLAYLIST_ENTRY_CLIP;
+            if (!json_uint(cJSON_GetObjectItem(item, "count"), PLAYLIST_CLIP_MAX, &value)) return false;
+            entry->count = value;
+            if (!json_uint(cJSON_GetObjectItem(item, "fps"), UINT8_MAX, &value)) return false;
+            entry->fps = value;
+        } else {
+            entry->type = PLAYLIST_ENTRY_FRAME;
+        }
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Body: {"entries": [{"type": "mode", "mode": "rainbow", "duration": 10000,
+//         "transition": "fade", "fade": 500}, ...]} or {"stop": true}
+esp_err_t set_playlist_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, 2048, &len);
+    if (!body) return ESP_FAIL;
+    cJSON *root = cJSON_ParseWithLength((const char *)body, len);
+    free(body);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "stop"))) {
+        cJSON_Delete(root);
+        playlist_stop();
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+        return ESP_OK;
+    }
+
+    playlist_entry_t entries[PLAYLIST_MAX_ENTRIES];
+    int count = 0;
+    bool valid = true;
+    cJSON *item = NULL;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(root, "entries")) {
+        if (count >= PLAYLIST_MAX_ENTRIES || !parse_playlist_entry(item, &entries[count])) {
+            valid = false;
+            break;
+        }
+        count++;
+    }
+    cJSON_Delete(root);
+
+    if (!valid || playlist_set(entries, count) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid playlist");
+        return ESP_FAIL;
+    }
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
     return ESP_OK;
 }
 
+esp_err_t get_playlist_handler(httpd_req_t *req)
+{
+    playlist_status_t status;
+    playlist_get_status(&status);
+    int64_t now = esp_timer_get_time();
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "running", status.running);
+    cJSON_AddNumberToObject(root, "count", status.count);
+    if (status.running) {
+        cJSON_AddNumberToObject(root, "index", status.index);
+        cJSON_AddNumberToObject(root, "next_index", (status.index + 1) % status.count);
+        cJSON_AddNumberToObject(root, "position_ms", (double)((now - status.started_us) / 1000));
+        cJSON_AddNumberToObject(root, "next_switch_in_ms", (double)((status.next_switch_us - now) / 1000));
+        cJSON_AddNumberToObject(root, "next_switch_uptime_ms", (double)(status.next_switch_us / 1000));
+    }
+
+    const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
+
+    cJSON_Delete(root);
+    cJSON_free((void*)json_str);
+    return ESP_OK;
+}
+
+// Optional "transition" (ms) and "easing" ("linear", "in", "out", "in_out")
+// fields accepted by the brightness, colour and mode endpoints.
+static void parse_transition(const cJSON *root, uint32_t default_ms, uint32_t *ms, easing_t *easing)
+{
+    const cJSON *transition = cJSON_GetObjectItem(root, "transition");
+    const cJSON *ease = cJSON_GetObjectItem(root, "easing");
+    *ms = cJSON_IsNumber(transition) && transition->valueint >= 0 ? (uint32_t)transition->valueint : default_ms;
+    int e = cJSON_IsString(ease) ? easing_from_name(ease->valuestring) : -1;
+    *easing = e >= 0 ? e : EASE_IN_OUT;
+}
+
+// Tweens all three channels of a colour towards the r/g/b in root.
+static void tween_color(const cJSON *root, pixel_color_t *color)
+{
+    cJSON *r_item = cJSON_GetObjectItem(root, "r");
+    cJSON *g_item = cJSON_GetObjectItem(root, "g");
+    cJSON *b_item = cJSON_GetObjectItem(root, "b");
+    if (r_item && g_item && b_item) {
+        uint32_t ms;
+        easing_t easing;
+        parse_transition(root, LED_DEFAULT_TRANSITION_MS, &ms, &easing);
+        led_tween(&color->r, TWEEN_U8, r_item->valueint, ms, easing);
+        led_tween(&color->g, TWEEN_U8, g_item->valueint, ms, easing);
+        led_tween(&color->b, TWEEN_U8, b_item->valueint, ms, easing);
+    }
+}
+
 esp_err_t set_brightness_handler(httpd_req_t *req)
 {
     char buf[100];
@@ -99,8 +513,10 @@ esp_err_t set_brightness_handler(httpd_req_t *req)
     if (root) {
         cJSON *brightness = cJSON_GetObjectItem(root, "brightness");
         if (brightness) {
-            current_brightness = (brightness->valueint * 63) / 100;
-            update_display();
+            uint32_t ms;
+            easing_t easing;
+            parse_transition(root, LED_DEFAULT_TRANSITION_MS, &ms, &easing);
+            led_tween(&current_brightness, TWEEN_U8, (brightness->valueint * 63) / 100, ms, easing);
         }
         cJSON_Delete(root);
     }
@@ -110,6 +526,226 @@ esp_err_t set_brightness_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// Speed and scale of the procedural modes, 0-255 with 64 as normal:
+// {"speed": 64, "scale": 64}. Both ease to their new value.
+esp_err_t set_params_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, 256, &len);
+    if (!body) return ESP_FAIL;
+    cJSON *root = cJSON_ParseWithLength((const char *)body, len);
+    free(body);
+    if (!root) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+
+    uint32_t ms;
+    easing_t easing;
+    parse_transition(root, LED_DEFAULT_TRANSITION_MS, &ms, &easing);
+    cJSON *speed = cJSON_GetObjectItem(root, "speed");
+    cJSON *scale = cJSON_GetObjectItem(root, "scale");
+    if (cJSON_IsNumber(speed)) led_tween(&effect_speed, TWEEN_U8, speed->valueint, ms, easing);
+    if (cJSON_IsNumber(scale)) led_tween(&effect_scale, TWEEN_U8, scale->valueint, ms, easing);
+    cJSON_Delete(root);
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+    return ESP_OK;
+}
+
+// Per-LED colour calibration, binary; see calibration.h for the format.
+// Applied from the next frame and kept in NVS.
+esp_err_t calibration_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, CALIB_MAX_BODY, &len);
+    if (!body) return ESP_FAIL;
+    calibration_t *cal = malloc(sizeof(calibration_t));
+    if (!cal) {
+        free(body);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    if (calibration_parse(body, len, cal) != 0) {
+        free(cal);
+        free(body);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad calibration format or size");
+        return ESP_FAIL;
+    }
+    // Stored first, so a table that fails to save never goes live.
+    esp_err_t err = calibration_save(body, len);
+    if (err == ESP_OK) {
+        led_set_calibration(cal);
+    }
+    free(cal);
+    free(body);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to store calibration");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+    return ESP_OK;
+}
+
+// Parses and applies a batch body, leaving the JSON reply in resp.
+// Returns false if the batch was rejected.
+static bool run_batch(const char *json, size_t len, char *resp, size_t resp_len)
+{
+    cJSON *root = cJSON_ParseWithLength(json, len);
+    if (!root) {
+        snprintf(resp, resp_len, "{\"status\":\"error\",\"error\":\"Invalid JSON\"}");
+        return false;
+    }
+    batch_t *batch = malloc(sizeof(batch_t));
+    char error[48];
+    int ret = batch ? batch_parse(root, batch, error, sizeof(error)) : -1;
+    cJSON_Delete(root);
+    if (ret != 0) {
+        snprintf(resp, resp_len, "{\"status\":\"error\",\"error\":\"%s\"}", batch ? error : "Out of memory");
+        free(batch);
+        return false;
+    }
+
+    uint32_t version;
+    esp_err_t err = led_apply_batch(batch, &version);
+    free(batch);
+    if (err != ESP_OK) {
+        snprintf(resp, resp_len, "{\"status\":\"error\",\"error\":\"Display busy\"}");
+        return false;
+    }
+    snprintf(resp, resp_len, "{\"status\":\"ok\",\"version\":%lu}", (unsigned long)version);
+    return true;
+}
+
+// Several settings in one request, applied together; see batch.h.
+esp_err_t batch_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, BATCH_MAX_BODY, &len);
+    if (!body) return ESP_FAIL;
+    char resp[96];
+    bool ok = run_batch((const char *)body, len, resp, sizeof(resp));
+    free(body);
+
+    if (!ok) httpd_resp_set_status(req, HTTPD_400);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+// Reads a frame's payload into a scratch buffer and drops it, so that the
+// next frame header is read from the right place.
+static esp_err_t ws_discard(httpd_req_t *req, httpd_ws_frame_t *frame)
+{
+    uint8_t chunk[128];
+    size_t left = frame->len;
+    while (left > 0) {
+        frame->payload = chunk;
+        frame->len = left < sizeof(chunk) ? left : sizeof(chunk);
+        esp_err_t err = httpd_ws_recv_frame(req, frame, frame->len);
+        if (err != ESP_OK) return err;
+        left -= frame->len;
+    }
+    return ESP_OK;
+}
+
+// A batch frame received on the httpd task, waiting for a worker to apply
+// it and send the reply to its socket.
+typedef struct {
+    httpd_handle_t hd;
+    int fd;
+    size_t len;
+    char body[];
+} ws_batch_t;
+
+// Frames go to the workers in arrival order through this queue; a worker
+// takes the oldest under ws_batch_mutex, so two workers never reorder one
+// client's changes. It holds one entry per queued or running job at most.
+static QueueHandle_t ws_batches = NULL;
+static SemaphoreHandle_t ws_batch_mutex = NULL;
+
+static void ws_send_text(httpd_handle_t hd, int fd, const char *text)
+{
+    httpd_ws_frame_t reply = {
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)text,
+        .len = strlen(text)
+    };
+    httpd_ws_send_frame_async(hd, fd, &reply);
+}
+
+static void ws_batch_work(void *arg)
+{
+    (void)arg;
+    ws_batch_t *msg;
+    char resp[96];
+    xSemaphoreTake(ws_batch_mutex, portMAX_DELAY);
+    xQueueReceive(ws_batches, &msg, portMAX_DELAY);
+    run_batch(msg->body, msg->len, resp, sizeof(resp));
+    ws_send_text(msg->hd, msg->fd, resp);
+    xSemaphoreGive(ws_batch_mutex);
+    free(msg);
+}
+
+// WebSocket at /ws: every text message is a /batch body and is answered
+// with the same reply, without a new connection per change. Messages count
+// against the sender's rate limit like requests; over it they are dropped
+// and answered with {"status":"rate limited"}. Applying a batch can wait on
+// the render task, so that and the reply happen on the async workers; a
+// frame that finds their queue full is answered with {"status":"busy"}.
+esp_err_t ws_handler(httpd_req_t *req)
+{
+    if (req->method == HTTP_GET) {
+        return ESP_OK;  // handshake
+    }
+    httpd_ws_frame_t frame = { .type = HTTPD_WS_TYPE_TEXT };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) return err;
+    if (frame.type != HTTPD_WS_TYPE_TEXT) return ws_discard(req, &frame);
+
+    const char *resp;
+    if (!web_client_admit(req)) {
+        resp = "{\"status\":\"rate limited\"}";
+    } else if (frame.len == 0 || frame.len > BATCH_MAX_BODY) {
+        resp = "{\"status\":\"error\",\"error\":\"Bad body length\"}";
+    } else {
+        ws_batch_t *msg = malloc(sizeof(ws_batch_t) + frame.len);
+        if (!msg) return ESP_ERR_NO_MEM;
+        frame.payload = (uint8_t *)msg->body;
+        err = httpd_ws_recv_frame(req, &frame, frame.len);
+        if (err != ESP_OK) {
+            free(msg);
+            return err;
+        }
+        msg->hd = req->handle;
+        msg->fd = httpd_req_to_sockfd(req);
+        msg->len = frame.len;
+        if (web_async_run(ws_batch_work, NULL) != ESP_OK) {
+            free(msg);
+            ws_send_text(req->handle, httpd_req_to_sockfd(req), "{\"status\":\"busy\"}");
+            return ESP_OK;
+        }
+        // Only the httpd task adds, and never more than there are jobs.
+        xQueueSend(ws_batches, &msg, 0);
+        return ESP_OK;
+    }
+    err = ws_discard(req, &frame);
+    if (err != ESP_OK) return err;
+    ws_send_text(req->handle, httpd_req_to_sockfd(req), resp);
+    return ESP_OK;
+}
+#endif
+
 esp_err_t set_mode_handler(httpd_req_t *req)
 {
     char buf[100];
@@ -121,17 +757,12 @@ esp_err_t set_mode_handler(httpd_req_t *req)
     if (root) {
         cJSON *modeItem = cJSON_GetObjectItem(root, "mode");
         if (modeItem && cJSON_IsString(modeItem)) {
-            const char *mode_str = modeItem->valuestring;
-            if (strcmp(mode_str, "static") == 0) {
-                current_mode = MODE_STATIC;
-            } else if (strcmp(mode_str, "rainbow") == 0) {
-                current_mode = MODE_RAINBOW;
-            } else if (strcmp(mode_str, "checkerboard") == 0) {
-                current_mode = MODE_CHECKERBOARD;
-            } else if (strcmp(mode_str, "gradient") == 0) {
-                current_mode = MODE_GRADIENT;
-            } else if (strcmp(mode_str, "random") == 0) {
-                current_mode = MODE_RANDOM;
+            int mode = mode_from_name(modeItem->valuestring);
+            if (mode >= 0) {
+                uint32_t ms;
+                easing_t easing;
+                parse_transition(root, LED_DEFAULT_MODE_TRANSITION_MS, &ms, &easing);
+                led_set_mode(mode, ms, easing);
             }
         }
         cJSON_Delete(root);
@@ -150,14 +781,7 @@ esp_err_t set_secondary_color_handler(httpd_req_t *req)
     buf[ret] = '\0';
     cJSON *root = cJSON_Parse(buf);
     if (root) {
-        cJSON *r_item = cJSON_GetObjectItem(root, "r");
-        cJSON *g_item = cJSON_GetObjectItem(root, "g");
-        cJSON *b_item = cJSON_GetObjectItem(root, "b");
-        if (r_item && g_item && b_item) {
-            secondary_color.r = r_item->valueint;
-            secondary_color.g = g_item->valueint;
-            secondary_color.b = b_item->valueint;
-        }
+        tween_color(root, &secondary_color);
         cJSON_Delete(root);
     }
     
@@ -175,14 +799,7 @@ esp_err_t set_primary_color_handler(httpd_req_t *req)
     buf[ret] = '\0';
     cJSON *root = cJSON_Parse(buf);
     if (root) {
-        cJSON *r_item = cJSON_GetObjectItem(root, "r");
-        cJSON *g_item = cJSON_GetObjectItem(root, "g");
-        cJSON *b_item = cJSON_GetObjectItem(root, "b");
-        if (r_item && g_item && b_item) {
-            current_color.r = r_item->valueint;
-            current_color.g = g_item->valueint;
-            current_color.b = b_item->valueint;
-        }
+        tween_color(root, &current_color);
         cJSON_Delete(root);
     }
     
@@ -193,26 +810,591 @@ esp_err_t set_primary_color_handler(httpd_req_t *req)
 
 esp_err_t get_pixels_handler(httpd_req_t *req)
 {
-    cJSON *root = cJSON_CreateArray();
+    char *json_str = pixel_json_serialize();
+    if (!json_str) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
     
-    for(int row=0; row<MATRIX_ROWS; row++) {
-        for(int col=0; col<MATRIX_COLS; col++) {
-            cJSON *pixel = cJSON_CreateObject();
-            cJSON_AddNumberToObject(pixel, "row", row);
-            cJSON_AddNumberToObject(pixel, "col", col);
-            cJSON_AddNumberToObject(pixel, "r", framebuffer[row][col].r);
-            cJSON_AddNumberToObject(pixel, "g", framebuffer[row][col].g);
-            cJSON_AddNumberToObject(pixel, "b", framebuffer[row][col].b);
-            cJSON_AddItemToArray(root, pixel);
+    cJSON_free(json_str);
+    return ESP_OK;
+}
+
+// The drawing as one binary frame, in the POST /frame rgb format: a format
+// byte (0) then rgb for every pixel, row-major. Indexed drawings are sent
+// expanded through the palette.
+esp_err_t get_frame_handler(httpd_req_t *req)
+{
+    uint8_t *body = malloc(1 + RGB_COUNT * 3);
+    if (!body) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    body[0] = FB_FORMAT_RGB;
+    uint8_t *p = body + 1;
+    for (int row = 0; row < MATRIX_ROWS; row++) {
+        for (int col = 0; col < MATRIX_COLS; col++) {
+            pixel_color_t c = framebuffer_pixel(row, col);
+            *p++ = c.r;
+            *p++ = c.g;
+            *p++ = c.b;
         }
     }
-    
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_send(req, (const char *)body, 1 + RGB_COUNT * 3);
+    free(body);
+    return ESP_OK;
+}
+
+static esp_err_t send_journal_step(httpd_req_t *req, int pixels)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    journal_stats_t journal;
+    led_journal_stats(&journal);
+    if (pixels < 0) {
+        httpd_resp_set_status(req, "409 Conflict");
+    }
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"status\":\"%s\",\"pixels\":%d,\"undo\":%lu,\"redo\":%lu}",
+             pixels < 0 ? "empty" : "ok", pixels < 0 ? 0 : pixels,
+             (unsigned long)journal.undo_steps, (unsigned long)journal.redo_steps);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+// Steps the drawing back or forward by one change (a /pixel request, a
+// stroke, a /draw or /frame upload, a batch). 409 when there is no step.
+esp_err_t undo_handler(httpd_req_t *req)
+{
+    return send_journal_step(req, led_undo());
+}
+
+esp_err_t redo_handler(httpd_req_t *req)
+{
+    return send_journal_step(req, led_redo());
+}
+
+// Receives exactly len bytes, waiting out socket timeouts.
+static bool recv_exact(httpd_req_t *req, uint8_t *dst, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        int ret = httpd_req_recv(req, (char *)dst + got, len - got);
+        if (ret == HTTPD_SOCK_ERR_TIMEOUT) continue;
+        if (ret <= 0) return false;
+        got += ret;
+    }
+    return true;
+}
+
+// An animated GIF, the file itself as the body. It is written to flash a
+// chunk at a time as it arrives and played from there in MODE_GIF, which
+// this switches to; frames are decoded as they are shown, so the file can
+// be as large as the partition.
+esp_err_t gif_upload_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    size_t len = req->content_len;
+    if (len == 0 || len > gif_store_capacity()) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Bad body length");
+        return ESP_FAIL;
+    }
+    uint8_t *chunk = malloc(GIF_UPLOAD_CHUNK);
+    if (!chunk) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    uint16_t width = 0, height = 0;
+    esp_err_t err = ESP_OK;
+    for (size_t received = 0; received < len && err == ESP_OK; ) {
+        size_t n = len - received < GIF_UPLOAD_CHUNK ? len - received : GIF_UPLOAD_CHUNK;
+        if (!recv_exact(req, chunk, n)) {
+            free(chunk);
+            return ESP_FAIL;
+        }
+        if (received == 0) {
+            int probe = gif_probe(chunk, n, &width, &height);
+            if (probe < 0) {
+                free(chunk);
+                httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                    probe == GIF_ERR_TOO_LARGE ? "GIF too large" : "Not a GIF");
+                return ESP_FAIL;
+            }
+            // Erasing the header first means the player, which lets go of
+            // the old file at its next frame, cannot open it again.
+            err = gif_store_begin(len);
+            led_reload_gif();
+        }
+        if (err == ESP_OK) err = gif_store_write(received, chunk, n);
+        received += n;
+    }
+    free(chunk);
+    if (err == ESP_OK) err = gif_store_finish(len);
+    led_reload_gif();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "GIF store failed: %s", esp_err_to_name(err));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to store GIF");
+        return ESP_FAIL;
+    }
+    led_set_mode(MODE_GIF, LED_DEFAULT_MODE_TRANSITION_MS, EASE_IN_OUT);
+
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"status\":\"ok\",\"width\":%u,\"height\":%u,\"bytes\":%u}",
+             width, height, (unsigned)len);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+// The stored GIF and how far its playback has got.
+esp_err_t gif_info_handler(httpd_req_t *req)
+{
+    gif_info_t info;
+    gif_get_info(&info);
+    char resp[192];
+    snprintf(resp, sizeof(resp),
+             "{\"loaded\":%s,\"width\":%u,\"height\":%u,\"bytes\":%lu,\"capacity\":%u,"
+             "\"frame\":%lu,\"loop_frames\":%lu,\"loops\":%lu}",
+             info.open ? "true" : "false", info.width, info.height, (unsigned long)info.size,
+             (unsigned)gif_store_capacity(), (unsigned long)info.frame,
+             (unsigned long)info.loop_frames, (unsigned long)info.loops);
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+static void add_latency_summary(cJSON *item, int series)
+{
+    latency_summary_t sum;
+    latency_get_summary(series, &sum);
+    cJSON_AddNumberToObject(item, "count", sum.count);
+    cJSON_AddNumberToObject(item, "mean_us", sum.mean_us);
+    cJSON_AddNumberToObject(item, "p50_us", sum.p50_us);
+    cJSON_AddNumberToObject(item, "p99_us", sum.p99_us);
+    cJSON_AddNumberToObject(item, "max_us", sum.max_us);
+}
+
+// Input-to-photon latency of drawing requests, per stage and end to end,
+// with the end-to-end histogram and the last few traces. ?reset=1 clears
+// the figures after reporting them.
+esp_err_t latency_handler(httpd_req_t *req)
+{
+    latency_counts_t counts;
+    latency_get_counts(&counts);
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "completed", counts.completed);
+    cJSON_AddNumberToObject(root, "dropped", counts.dropped);
+    cJSON_AddNumberToObject(root, "open", counts.open);
+
+    cJSON *stages = cJSON_AddArrayToObject(root, "stages");
+    for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", latency_stage_name(s));
+        add_latency_summary(item, s);
+        cJSON_AddItemToArray(stages, item);
+    }
+
+    cJSON *total = cJSON_AddObjectToObject(root, "total");
+    add_latency_summary(total, LATENCY_TOTAL);
+    static uint32_t hist[LATENCY_BUCKETS];
+    latency_get_histogram(hist);
+    cJSON *buckets = cJSON_AddArrayToObject(total, "histogram");
+    for (int b = 0; b < LATENCY_BUCKETS; b++) {
+        if (hist[b] == 0) continue;
+        // [upper limit in us, count]; the last bucket has no upper limit.
+        cJSON *bucket = cJSON_CreateArray();
+        cJSON_AddItemToArray(bucket, b < LATENCY_BUCKETS - 1
+                             ? cJSON_CreateNumber(latency_bucket_limit_us(b)) : cJSON_CreateNull());
+        cJSON_AddItemToArray(bucket, cJSON_CreateNumber(hist[b]));
+        cJSON_AddItemToArray(buckets, bucket);
+    }
+
+    static latency_trace_t traces[LATENCY_RECENT];
+    int n = latency_get_recent(traces, LATENCY_RECENT);
+    cJSON *recent = cJSON_AddArrayToObject(root, "recent");
+    for (int i = 0; i < n; i++) {
+        const latency_trace_t *t = &traces[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "id", t->id);
+        cJSON_AddNumberToObject(item, "total_us", (double)(t->end_us[LATENCY_TRANSMIT] - t->start_us));
+        cJSON *spans = cJSON_AddArrayToObject(item, "stages_us");
+        int64_t from = t->start_us;
+        for (int s = 0; s < LATENCY_STAGE_COUNT; s++) {
+            cJSON_AddItemToArray(spans, cJSON_CreateNumber((double)(t->end_us[s] - from)));
+            from = t->end_us[s];
+        }
+        cJSON_AddItemToArray(recent, item);
+    }
+
+    if (query_int(req, "reset") == 1) latency_reset();
+
     const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
     httpd_resp_set_type(req, "application/json");
     httpd_resp_send(req, json_str, strlen(json_str));
-    
+
     cJSON_Delete(root);
-    free((void*)json_str);
+    cJSON_free((void*)json_str);
+    return ESP_OK;
+}
+
+// Matrix size for clients that draw it, e.g. {"rows":8,"cols":8,...}.
+esp_err_t geometry_handler(httpd_req_t *req)
+{
+    char resp[96];
+    snprintf(resp, sizeof(resp), "{\"rows\":%d,\"cols\":%d,\"serpentine\":%s,\"pixels\":%d}",
+             MATRIX_ROWS, MATRIX_COLS, MATRIX_SERPENTINE ? "true" : "false", RGB_COUNT);
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, resp, -1);
+    return ESP_OK;
+}
+
+static void bench_report(const char *name, uint32_t per_iter, uint32_t iters, void *ctx)
+{
+    cJSON *result = cJSON_CreateObject();
+    cJSON_AddStringToObject(result, "name", name);
+    cJSON_AddNumberToObject(result, "per_iter", per_iter);
+    cJSON_AddNumberToObject(result, "iters", iters);
+    cJSON_AddItemToArray((cJSON *)ctx, result);
+}
+
+// Runs the microbenchmark suite; takes a few seconds and briefly borrows
+// the framebuffer, so it is meant for bench/bench.py rather than the UI.
+esp_err_t bench_handler(httpd_req_t *req)
+{
+    ESP_LOGI(TAG, "Running benchmarks");
+    cJSON *root = cJSON_CreateObject();
+    char size[16];
+    snprintf(size, sizeof(size), "%dx%d", MATRIX_COLS, MATRIX_ROWS);
+    cJSON_AddStringToObject(root, "unit", bench_unit());
+    cJSON_AddStringToObject(root, "size", size);
+    cJSON_AddNumberToObject(root, "cpu_mhz", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    cJSON *results = cJSON_AddArrayToObject(root, "results");
+    bench_run(bench_report, results);
+
+    const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
+
+    cJSON_Delete(root);
+    cJSON_free((void*)json_str);
+    return ESP_OK;
+}
+
+#define PROFILE_DEFAULT_MS 1000
+#define PROFILE_MIN_MS     100
+#define PROFILE_MAX_MS     10000
+#define PROFILE_TOP_PCS    256
+
+static const TaskStatus_t *find_task(const TaskStatus_t *tasks, int count, TaskHandle_t handle)
+{
+    for (int i = 0; i < count; i++) {
+        if (tasks[i].xHandle == handle) return &tasks[i];
+    }
+    return NULL;
+}
+
+// Run time a task used during the window, in run-time counter units (us).
+static uint32_t task_delta(const TaskStatus_t *before, int before_count, const TaskStatus_t *task)
+{
+    const TaskStatus_t *prev = find_task(before, before_count, task->xHandle);
+    return (uint32_t)task->ulRunTimeCounter - (prev ? (uint32_t)prev->ulRunTimeCounter : 0);
+}
+
+// CPU profile over a window, GET /profile?ms=2000: share of CPU per task,
+// idle time per core, render time per effect and the most sampled code
+// addresses (tools/profile.py names them). Blocks for the window, so it
+// runs on an async worker.
+esp_err_t profile_handler(httpd_req_t *req)
+{
+    int window_ms = query_int(req, "ms");
+    if (window_ms <= 0) window_ms = PROFILE_DEFAULT_MS;
+    if (window_ms < PROFILE_MIN_MS) window_ms = PROFILE_MIN_MS;
+    if (window_ms > PROFILE_MAX_MS) window_ms = PROFILE_MAX_MS;
+
+    UBaseType_t cap = uxTaskGetNumberOfTasks() + 4;
+    TaskStatus_t *before = malloc(cap * sizeof(TaskStatus_t));
+    TaskStatus_t *after = malloc(cap * sizeof(TaskStatus_t));
+    profiler_pc_t *pcs = malloc(PROFILE_TOP_PCS * sizeof(profiler_pc_t));
+    if (!before || !after || !pcs) {
+        free(before);
+        free(after);
+        free(pcs);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    uint32_t total_before, total_after;
+    int before_count = uxTaskGetSystemState(before, cap, &total_before);
+    profiler_start();
+    vTaskDelay(pdMS_TO_TICKS(window_ms));
+    profiler_stop();
+    int after_count = uxTaskGetSystemState(after, cap, &total_after);
+    double elapsed = total_after - total_before;
+    if (elapsed <= 0) elapsed = 1;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "window_ms", window_ms);
+    cJSON_AddNumberToObject(root, "cpu_mhz", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+    cJSON_AddNumberToObject(root, "cores", portNUM_PROCESSORS);
+
+    // Percentages of all cores together, so they add up to 100.
+    cJSON *tasks = cJSON_AddArrayToObject(root, "tasks");
+    for (int i = 0; i < after_count; i++) {
+        uint32_t used = task_delta(before, before_count, &after[i]);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", after[i].pcTaskName);
+        cJSON_AddNumberToObject(item, "cpu_percent", used * 100.0 / (elapsed * portNUM_PROCESSORS));
+        cJSON_AddNumberToObject(item, "priority", after[i].uxCurrentPriority);
+        cJSON_AddNumberToObject(item, "stack_free", after[i].usStackHighWaterMark);
+        cJSON_AddItemToArray(tasks, item);
+    }
+
+    cJSON *idle = cJSON_AddArrayToObject(root, "idle_percent");
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        const TaskStatus_t *task = find_task(after, after_count, xTaskGetIdleTaskHandleForCore(core));
+        uint32_t used = task ? task_delta(before, before_count, task) : 0;
+        cJSON_AddItemToArray(idle, cJSON_CreateNumber(used * 100.0 / elapsed));
+    }
+
+    // Render time per effect, as a share of one core.
+    profiler_effect_t effects[MODE_COUNT];
+    profiler_get_effects(effects);
+    cJSON *list = cJSON_AddArrayToObject(root, "effects");
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        const profiler_effect_t *e = &effects[mode];
+        if (e->frames == 0) continue;
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "mode", mode_name(mode));
+        cJSON_AddNumberToObject(item, "frames", e->frames);
+        cJSON_AddNumberToObject(item, "avg_us", e->total_us / e->frames);
+        cJSON_AddNumberToObject(item, "max_us", e->max_us);
+        cJSON_AddNumberToObject(item, "cpu_percent", e->total_us / (window_ms * 10.0));
+        cJSON_AddItemToArray(list, item);
+    }
+
+    uint32_t total, dropped;
+    int count = profiler_samples(pcs, PROFILE_TOP_PCS, &total, &dropped);
+    cJSON *sampled = cJSON_AddObjectToObject(root, "samples");
+    cJSON_AddNumberToObject(sampled, "total", total);
+    cJSON_AddNumberToObject(sampled, "dropped", dropped);
+    cJSON *top = cJSON_AddArrayToObject(sampled, "pcs");
+    for (int i = 0; i < count; i++) {
+        char pc[12];
+        snprintf(pc, sizeof(pc), "0x%08lx", (unsigned long)pcs[i].pc);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "pc", pc);
+        cJSON_AddNumberToObject(item, "core", pcs[i].core);
+        cJSON_AddNumberToObject(item, "count", pcs[i].count);
+        cJSON_AddItemToArray(top, item);
+    }
+    free(before);
+    free(after);
+    free(pcs);
+
+    const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
+
+    cJSON_Delete(root);
+    cJSON_free((void*)json_str);
+    return ESP_OK;
+}
+
+// Layer settings: {"layer": "overlay0", "opacity": 0-255,
+// "blend": "normal|add|multiply|screen", "visible": true, "clear": true}
+esp_err_t set_layer_handler(httpd_req_t *req)
+{
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+    size_t len;
+    uint8_t *body = recv_body(req, 256, &len);
+    if (!body) return ESP_FAIL;
+    cJSON *root = cJSON_ParseWithLength((const char *)body, len);
+    free(body);
+
+    cJSON *name = root ? cJSON_GetObjectItem(root, "layer") : NULL;
+    int layer = cJSON_IsString(name) ? layer_from_name(name->valuestring) : -1;
+    if (layer < 0) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown layer");
+        return ESP_FAIL;
+    }
+
+    layer_config_t config;
+    compositor_get_config(layer, &config);
+    cJSON *opacity = cJSON_GetObjectItem(root, "opacity");
+    cJSON *blend = cJSON_GetObjectItem(root, "blend");
+    cJSON *visible = cJSON_GetObjectItem(root, "visible");
+    if (cJSON_IsNumber(opacity)) {
+        config.opacity = opacity->valueint < 0 ? 0 : opacity->valueint > 255 ? 255 : opacity->valueint;
+    }
+    if (cJSON_IsString(blend)) {
+        int mode = blend_from_name(blend->valuestring);
+        if (mode < 0) {
+            cJSON_Delete(root);
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown blend mode");
+            return ESP_FAIL;
+        }
+        config.blend = mode;
+    }
+    if (cJSON_IsBool(visible)) {
+        config.visible = cJSON_IsTrue(visible);
+    }
+    // The effect and drawing layers are refilled by the render task.
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "clear")) && layer >= LAYER_OVERLAY0) {
+        compositor_clear(layer);
+    }
+    cJSON_Delete(root);
+
+    compositor_set_config(layer, &config);
+    led_request_frame();
+
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, "{\"status\":\"ok\"}", -1);
+    return ESP_OK;
+}
+
+esp_err_t get_layers_handler(httpd_req_t *req)
+{
+    cJSON *root = cJSON_CreateArray();
+    for (int i = 0; i < LAYER_COUNT; i++) {
+        layer_config_t config;
+        compositor_get_config(i, &config);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "layer", layer_name(i));
+        cJSON_AddNumberToObject(item, "opacity", config.opacity);
+        cJSON_AddStringToObject(item, "blend", blend_name(config.blend));
+        cJSON_AddBoolToObject(item, "visible", config.visible);
+        cJSON_AddItemToArray(root, item);
+    }
+
+    const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
+
+    cJSON_Delete(root);
+    cJSON_free((void*)json_str);
+    return ESP_OK;
+}
+
+// Flight recorder dump, see recorder.h for the format and
+// tools/recording.py to turn it into a GIF or raw frames.
+esp_err_t recording_handler(httpd_req_t *req)
+{
+    uint8_t *data;
+    size_t len;
+    if (recorder_export(&data, &len) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"matrix32.rec\"");
+    httpd_resp_send(req, (const char *)data, len);
+    free(data);
+    return ESP_OK;
+}
+
+// Async worker queue and per-client request counters.
+esp_err_t stats_handler(httpd_req_t *req)
+{
+    web_async_stats_t async;
+    web_async_get_stats(&async);
+    web_client_t clients[WEB_CLIENT_MAX];
+    int count = web_client_list(clients, WEB_CLIENT_MAX);
+    int64_t now = esp_timer_get_time();
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON *queue = cJSON_AddObjectToObject(root, "async");
+    cJSON_AddNumberToObject(queue, "workers", WEB_ASYNC_WORKERS);
+    cJSON_AddNumberToObject(queue, "busy", async.busy);
+    cJSON_AddNumberToObject(queue, "queued", async.queued);
+    cJSON_AddNumberToObject(queue, "max_queued", async.max_queued);
+    cJSON_AddNumberToObject(queue, "completed", async.completed);
+    cJSON_AddNumberToObject(queue, "rejected", async.rejected);
+
+    ws2812_stats_t output;
+    ws2812_get_stats(&output);
+    cJSON *strip = cJSON_AddObjectToObject(root, "output");
+    cJSON_AddNumberToObject(strip, "frames", output.frames);
+    cJSON_AddNumberToObject(strip, "encode_us", output.last_encode_us);
+    cJSON_AddNumberToObject(strip, "encode_avg_us", output.avg_encode_us);
+    cJSON_AddNumberToObject(strip, "encode_max_us", output.max_encode_us);
+    cJSON_AddNumberToObject(strip, "transmit_us", output.last_transmit_us);
+
+    // Fragmentation: how much of the free heap is not in its largest block.
+    size_t heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t heap_largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    cJSON *heap = cJSON_AddObjectToObject(root, "heap");
+    cJSON_AddNumberToObject(heap, "free", heap_free);
+    cJSON_AddNumberToObject(heap, "min_free", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    cJSON_AddNumberToObject(heap, "largest_free_block", heap_largest);
+    cJSON_AddNumberToObject(heap, "fragmentation", heap_free ? 100.0 - heap_largest * 100.0 / heap_free : 0);
+
+    json_arena_stats_t arena;
+    json_arena_get_stats(&arena);
+    cJSON *json = cJSON_AddObjectToObject(root, "json_arena");
+    cJSON_AddNumberToObject(json, "size", arena.arena_size);
+    cJSON_AddNumberToObject(json, "count", arena.arena_count);
+    cJSON_AddNumberToObject(json, "in_use", arena.in_use);
+    cJSON_AddNumberToObject(json, "requests", arena.requests);
+    cJSON_AddNumberToObject(json, "unserved", arena.unserved);
+    cJSON_AddNumberToObject(json, "high_water", arena.high_water);
+    cJSON_AddNumberToObject(json, "overflow", arena.overflow);
+
+    journal_stats_t journal;
+    led_journal_stats(&journal);
+    cJSON *history = cJSON_AddObjectToObject(root, "journal");
+    cJSON_AddNumberToObject(history, "undo_steps", journal.undo_steps);
+    cJSON_AddNumberToObject(history, "redo_steps", journal.redo_steps);
+    cJSON_AddNumberToObject(history, "bytes_used", journal.bytes_used);
+    cJSON_AddNumberToObject(history, "buffer_size", journal.buffer_size);
+    cJSON_AddNumberToObject(history, "dropped", journal.dropped);
+
+    frame_cache_stats_t fc;
+    frame_cache_get_stats(&fc);
+    uint32_t lookups = fc.hits + fc.misses + fc.overflow;
+    cJSON *cache = cJSON_AddObjectToObject(root, "frame_cache");
+    cJSON_AddNumberToObject(cache, "budget_bytes", fc.budget_bytes);
+    cJSON_AddNumberToObject(cache, "frame_bytes", fc.frame_bytes);
+    cJSON_AddNumberToObject(cache, "slots", fc.slots);
+    cJSON_AddNumberToObject(cache, "used", fc.used);
+    cJSON_AddNumberToObject(cache, "hits", fc.hits);
+    cJSON_AddNumberToObject(cache, "misses", fc.misses);
+    cJSON_AddNumberToObject(cache, "overflow", fc.overflow);
+    cJSON_AddNumberToObject(cache, "uncacheable", fc.uncacheable);
+    cJSON_AddNumberToObject(cache, "evictions", fc.evictions);
+    cJSON_AddNumberToObject(cache, "hit_rate", lookups ? (double)fc.hits / lookups : 0);
+
+    cJSON *list = cJSON_AddArrayToObject(root, "clients");
+    for (int i = 0; i < count; i++) {
+        const web_client_t *c = &clients[i];
+        double seconds = (now - c->first_seen_us) / 1e6;
+        if (seconds < 1) seconds = 1;
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "addr", c->name);
+        cJSON_AddNumberToObject(item, "requests", c->requests);
+        cJSON_AddNumberToObject(item, "limited", c->limited);
+        cJSON_AddNumberToObject(item, "bytes_in", (double)c->bytes_in);
+        cJSON_AddNumberToObject(item, "req_per_s", c->requests / seconds);
+        cJSON_AddNumberToObject(item, "bytes_per_s", c->bytes_in / seconds);
+        cJSON_AddNumberToObject(item, "idle_ms", (double)((now - c->last_seen_us) / 1000));
+        cJSON_AddItemToArray(list, item);
+    }
+
+    const char *json_str = cJSON_PrintUnformatted(root);
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json_str, strlen(json_str));
+
+    cJSON_Delete(root);
+    cJSON_free((void*)json_str);
     return ESP_OK;
 }
 
@@ -223,9 +1405,77 @@ esp_err_t root_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// Every request enters here on the httpd task: its client is accounted
+// and rate limited, then the handler runs inline or, for slow routes, on
+// the async worker pool.
+static esp_err_t route_dispatch(httpd_req_t *req)
+{
+    const web_route_t *route = req->user_ctx;
+    // A 429 response would corrupt a WebSocket stream, so only handshakes
+    // are limited here.
+    bool ws_frame = route->websocket && req->method != HTTP_GET;
+    if (!ws_frame && !web_client_admit(req)) {
+        httpd_resp_set_status(req, "429 Too Many Requests");
+        httpd_resp_set_hdr(req, "Retry-After", "1");
+        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_send(req, "{\"status\":\"rate limited\"}", -1);
+        return ESP_OK;
+    }
+    if (route->slow) {
+        return web_async_submit(req, route->handler);
+    }
+    json_arena_begin();
+    esp_err_t ret = route->handler(req);
+    json_arena_end();
+    return ret;
+}
+
+static void register_route(httpd_uri_t *uri, bool slow)
+{
+    if (route_count >= WEB_MAX_ROUTES) {
+        ESP_LOGE(TAG, "Too many routes, %s not registered", uri->uri);
+        return;
+    }
+    web_route_t *route = &routes[route_count++];
+    route->handler = uri->handler;
+    route->slow = slow;
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    route->websocket = uri->is_websocket;
+#endif
+    uri->handler = route_dispatch;
+    uri->user_ctx = route;
+    httpd_register_uri_handler(server, uri);
+}
+
 httpd_handle_t start_webserver(void)
 {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
+    config.max_uri_handlers = WEB_MAX_ROUTES;
+    // Drop the least recently used connection instead of refusing new ones,
+    // and notice phones that left the AP without closing their sockets.
+    config.lru_purge_enable = true;
+    config.keep_alive_enable = true;
+    config.keep_alive_idle = 5;
+    config.keep_alive_interval = 2;
+    config.keep_alive_count = 3;
+    // A stalled client must not hold the httpd task for long.
+    config.recv_wait_timeout = 3;
+    config.send_wait_timeout = 3;
+
+    json_arena_init();
+    if (web_async_init() != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start async workers");
+        return NULL;
+    }
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    ws_batches = xQueueCreate(WEB_ASYNC_QUEUE_LEN + WEB_ASYNC_WORKERS, sizeof(ws_batch_t *));
+    ws_batch_mutex = xSemaphoreCreateMutex();
+    if (!ws_batches || !ws_batch_mutex) {
+        ESP_LOGE(TAG, "Failed to create WebSocket batch queue");
+        return NULL;
+    }
+#endif
     
     httpd_uri_t root = {
         .uri       = "/",
@@ -275,14 +1525,180 @@ httpd_handle_t start_webserver(void)
         .handler = get_pixels_handler
     };
 
+    httpd_uri_t draw_uri = {
+        .uri = "/draw",
+        .method = HTTP_POST,
+        .handler = draw_handler
+    };
+
+    httpd_uri_t frame_uri = {
+        .uri = "/frame",
+        .method = HTTP_POST,
+        .handler = frame_handler
+    };
+
+    httpd_uri_t palette_uri = {
+        .uri = "/palette",
+        .method = HTTP_POST,
+        .handler = palette_handler
+    };
+
+    httpd_uri_t effect_uri = {
+        .uri = "/effect",
+        .method = HTTP_POST,
+        .handler = effect_handler
+    };
+
+    httpd_uri_t playlist_post_uri = {
+        .uri = "/playlist",
+        .method = HTTP_POST,
+        .handler = set_playlist_handler
+    };
+
+    httpd_uri_t playlist_get_uri = {
+        .uri = "/playlist",
+        .method = HTTP_GET,
+        .handler = get_playlist_handler
+    };
+
+    httpd_uri_t bench_uri = {
+        .uri = "/bench",
+        .method = HTTP_GET,
+        .handler = bench_handler
+    };
+
+    httpd_uri_t layer_post_uri = {
+        .uri = "/layer",
+        .method = HTTP_POST,
+        .handler = set_layer_handler
+    };
+
+    httpd_uri_t layer_get_uri = {
+        .uri = "/layer",
+        .method = HTTP_GET,
+        .handler = get_layers_handler
+    };
+
+    httpd_uri_t params_uri = {
+        .uri = "/params",
+        .method = HTTP_POST,
+        .handler = set_params_handler
+    };
+
+    httpd_uri_t calibration_uri = {
+        .uri = "/calibration",
+        .method = HTTP_POST,
+        .handler = calibration_handler
+    };
+
+    httpd_uri_t batch_uri = {
+        .uri = "/batch",
+        .method = HTTP_POST,
+        .handler = batch_handler
+    };
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+    httpd_uri_t ws_uri = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true
+    };
+#endif
+
+    httpd_uri_t get_frame_uri = {
+        .uri = "/frame",
+        .method = HTTP_GET,
+        .handler = get_frame_handler
+    };
+
+    httpd_uri_t geometry_uri = {
+        .uri = "/geometry",
+        .method = HTTP_GET,
+        .handler = geometry_handler
+    };
+
+    httpd_uri_t undo_uri = {
+        .uri = "/undo",
+        .method = HTTP_POST,
+        .handler = undo_handler
+    };
+
+    httpd_uri_t redo_uri = {
+        .uri = "/redo",
+        .method = HTTP_POST,
+        .handler = redo_handler
+    };
+
+    httpd_uri_t gif_post_uri = {
+        .uri = "/gif",
+        .method = HTTP_POST,
+        .handler = gif_upload_handler
+    };
+
+    httpd_uri_t gif_get_uri = {
+        .uri = "/gif",
+        .method = HTTP_GET,
+        .handler = gif_info_handler
+    };
+
+    httpd_uri_t latency_uri = {
+        .uri = "/latency",
+        .method = HTTP_GET,
+        .handler = latency_handler
+    };
+
+    httpd_uri_t profile_uri = {
+        .uri = "/profile",
+        .method = HTTP_GET,
+        .handler = profile_handler
+    };
+
+    httpd_uri_t recording_uri = {
+        .uri = "/recording",
+        .method = HTTP_GET,
+        .handler = recording_handler
+    };
+
+    httpd_uri_t stats_uri = {
+        .uri = "/stats",
+        .method = HTTP_GET,
+        .handler = stats_handler
+    };
+
     if (httpd_start(&server, &config) == ESP_OK) {
-        httpd_register_uri_handler(server, &root);
-        httpd_register_uri_handler(server, &pixel);
-        httpd_register_uri_handler(server, &brightness);
-        httpd_register_uri_handler(server, &mode);
-        httpd_register_uri_handler(server, &secondary_color_uri);
-        httpd_register_uri_handler(server, &primary_color_uri);
-        httpd_register_uri_handler(server, &pixels_get_uri);
+        register_route(&root, false);
+        register_route(&pixel, false);
+        register_route(&brightness, false);
+        register_route(&mode, false);
+        register_route(&secondary_color_uri, false);
+        register_route(&primary_color_uri, false);
+        register_route(&pixels_get_uri, false);
+        register_route(&draw_uri, false);
+        register_route(&frame_uri, false);
+        register_route(&palette_uri, false);
+        register_route(&effect_uri, false);
+        register_route(&playlist_post_uri, true);
+        register_route(&playlist_get_uri, false);
+        register_route(&bench_uri, true);
+        register_route(&stats_uri, false);
+        register_route(&recording_uri, true);
+        register_route(&layer_post_uri, false);
+        register_route(&layer_get_uri, false);
+        register_route(&params_uri, false);
+        register_route(&calibration_uri, true);
+        register_route(&batch_uri, true);
+        register_route(&profile_uri, true);
+        register_route(&get_frame_uri, false);
+        register_route(&geometry_uri, false);
+        register_route(&undo_uri, false);
+        register_route(&redo_uri, false);
+        register_route(&gif_post_uri, true);
+        register_route(&gif_get_uri, false);
+        register_route(&latency_uri, false);
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+        register_route(&ws_uri, false);
+#endif
         return server;
     }
     return NULL;
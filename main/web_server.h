@@ -3,12 +3,40 @@
 
 #include "esp_http_server.h"
 
+#define DRAW_MAX_BODY 4096
+#define PIXEL_MAX_BODY 4096
+#define WEB_MAX_ROUTES 32
+#define GIF_UPLOAD_CHUNK 1024
+
 httpd_handle_t start_webserver(void);
 esp_err_t pixel_handler(httpd_req_t *req);
 esp_err_t set_brightness_handler(httpd_req_t *req);
 esp_err_t set_mode_handler(httpd_req_t *req);
 esp_err_t set_secondary_color_handler(httpd_req_t *req);
 esp_err_t get_pixels_handler(httpd_req_t *req);
+esp_err_t draw_handler(httpd_req_t *req);
+esp_err_t frame_handler(httpd_req_t *req);
+esp_err_t palette_handler(httpd_req_t *req);
+esp_err_t effect_handler(httpd_req_t *req);
+esp_err_t set_playlist_handler(httpd_req_t *req);
+esp_err_t get_playlist_handler(httpd_req_t *req);
+esp_err_t bench_handler(httpd_req_t *req);
+esp_err_t stats_handler(httpd_req_t *req);
+esp_err_t recording_handler(httpd_req_t *req);
+esp_err_t set_layer_handler(httpd_req_t *req);
+esp_err_t get_layers_handler(httpd_req_t *req);
+esp_err_t set_params_handler(httpd_req_t *req);
+esp_err_t calibration_handler(httpd_req_t *req);
+esp_err_t batch_handler(httpd_req_t *req);
+esp_err_t ws_handler(httpd_req_t *req);
+esp_err_t profile_handler(httpd_req_t *req);
+esp_err_t get_frame_handler(httpd_req_t *req);
+esp_err_t geometry_handler(httpd_req_t *req);
+esp_err_t undo_handler(httpd_req_t *req);
+esp_err_t redo_handler(httpd_req_t *req);
+esp_err_t gif_upload_handler(httpd_req_t *req);
+esp_err_t gif_info_handler(httpd_req_t *req);
+esp_err_t latency_handler(httpd_req_t *req);
 esp_err_t root_handler(httpd_req_t *req);
 
 #endif // WEB_SERVER_H 
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "freertos/FreeRTOS.h"
+#include "driver/rmt_tx.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "soc/soc_caps.h"
+#include "ws2812.h"
+
+static const char *TAG = "matrix32_ws2812";
+
+#define WS2812_RESOLUTION_HZ (10 * 1000 * 1000)   // 0.1 us ticks
+#define WS2812_T0H_TICKS     3                    // 0.3 us
+#define WS2812_T0L_TICKS     9                    // 0.9 us
+#define WS2812_T1H_TICKS     9
+#define WS2812_T1L_TICKS     3
+#define WS2812_RESET_TICKS   500                  // 50 us low
+
+// The bytes encoder turns wire bytes into bit symbols as the RMT memory
+// drains, then the copy encoder appends the reset (latch) pulse.
+typedef struct {
+    rmt_encoder_t base;             // first, so the driver's pointer is ours
+    rmt_encoder_t *bytes;
+    rmt_encoder_t *copy;
+    int state;                      // 0 = data, 1 = reset pulse
+    rmt_symbol_word_t reset_code;
+    uint32_t encode_cycles;         // spent in encode() for this frame
+} ws2812_encoder_t;
+
+static rmt_channel_handle_t channel = NULL;
+static ws2812_encoder_t encoder;
+static volatile bool in_flight = false;
+static int64_t send_start_us;
+
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static ws2812_stats_t stats;
+
+static size_t IRAM_ATTR ws2812_encode(rmt_encoder_t *base, rmt_channel_handle_t chan,
+                                      const void *data, size_t size, rmt_encode_state_t *ret_state)
+{
+    ws2812_encoder_t *enc = (ws2812_encoder_t *)base;
+    uint32_t start = esp_cpu_get_cycle_count();
+    rmt_encode_state_t session = RMT_ENCODING_RESET;
+    int state = RMT_ENCODING_RESET;
+    size_t written = 0;
+
+    if (enc->state == 0) {
+        written += enc->bytes->encode(enc->bytes, chan, data, size, &session);
+        if (session & RMT_ENCODING_COMPLETE) {
+            enc->state = 1;
+        }
+        if (session & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+            goto out;
+        }
+    }
+    if (enc->state == 1) {
+        written += enc->copy->encode(enc->copy, chan, &enc->reset_code, sizeof(enc->reset_code), &session);
+        if (session & RMT_ENCODING_COMPLETE) {
+            enc->state = RMT_ENCODING_RESET;
+            state |= RMT_ENCODING_COMPLETE;
+        }
+        if (session & RMT_ENCODING_MEM_FULL) {
+            state |= RMT_ENCODING_MEM_FULL;
+        }
+    }
+out:
+    enc->encode_cycles += esp_cpu_get_cycle_count() - start;
+    *ret_state = (rmt_encode_state_t)state;
+    return written;
+}
+
+static esp_err_t ws2812_reset(rmt_encoder_t *base)
+{
+    ws2812_encoder_t *enc = (ws2812_encoder_t *)base;
+    rmt_encoder_reset(enc->bytes);
+    rmt_encoder_reset(enc->copy);
+    enc->state = RMT_ENCODING_RESET;
+    return ESP_OK;
+}
+
+static esp_err_t ws2812_del(rmt_encoder_t *base)
+{
+    ws2812_encoder_t *enc = (ws2812_encoder_t *)base;
+    rmt_del_encoder(enc->bytes);
+    rmt_del_encoder(enc->copy);
+    return ESP_OK;
+}
+
+static bool IRAM_ATTR on_done(rmt_channel_handle_t chan, const rmt_tx_done_event_data_t *event, void *arg)
+{
+    uint32_t encode_us = encoder.encode_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&stats_lock);
+    stats.frames++;
+    stats.last_encode_us = encode_us;
+    if (encode_us > stats.max_encode_us) stats.max_encode_us = encode_us;
+    stats.avg_encode_us = stats.avg_encode_us - (stats.avg_encode_us >> 4) + (encode_us >> 4);
+    stats.last_transmit_us = (uint32_t)(now - send_start_us);
+    stats.last_done_us = now;
+    portEXIT_CRITICAL_ISR(&stats_lock);
+    in_flight = false;
+    return false;
+}
+
+esp_err_t ws2812_init(int gpio)
+{
+    rmt_tx_channel_config_t chan_config = {
+        .gpio_num = gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = WS2812_RESOLUTION_HZ,
+        // Two blocks: each refill interrupt then covers a whole block.
+        .mem_block_symbols = 2 * SOC_RMT_MEM_WORDS_PER_CHANNEL,
+        .trans_queue_depth = 2,
+    };
+    esp_err_t err = rmt_new_tx_channel(&chan_config, &channel);
+    if (err != ESP_OK) return err;
+
+    rmt_bytes_encoder_config_t bytes_config = {
+        .bit0 = { .level0 = 1, .duration0 = WS2812_T0H_TICKS, .level1 = 0, .duration1 = WS2812_T0L_TICKS },
+        .bit1 = { .level0 = 1, .duration0 = WS2812_T1H_TICKS, .level1 = 0, .duration1 = WS2812_T1L_TICKS },
+        .flags.msb_first = 1
+    };
+    err = rmt_new_bytes_encoder(&bytes_config, &encoder.bytes);
+    if (err != ESP_OK) goto fail;
+    rmt_copy_encoder_config_t copy_config = {};
+    err = rmt_new_copy_encoder(&copy_config, &encoder.copy);
+    if (err != ESP_OK) goto fail;
+
+    encoder.base.encode = ws2812_encode;
+    encoder.base.reset = ws2812_reset;
+    encoder.base.del = ws2812_del;
+    encoder.reset_code = (rmt_symbol_word_t){
+        .level0 = 0, .duration0 = WS2812_RESET_TICKS / 2,
+        .level1 = 0, .duration1 = WS2812_RESET_TICKS / 2,
+    };
+
+    rmt_tx_event_callbacks_t callbacks = { .on_trans_done = on_done };
+    err = rmt_tx_register_event_callbacks(channel, &callbacks, NULL);
+    if (err == ESP_OK) err = rmt_enable(channel);
+    if (err != ESP_OK) goto fail;
+    ESP_LOGI(TAG, "WS2812 output on GPIO %d", gpio);
+    return ESP_OK;
+
+fail:
+    if (encoder.copy) rmt_del_encoder(encoder.copy);
+    if (encoder.bytes) rmt_del_encoder(encoder.bytes);
+    encoder.copy = encoder.bytes = NULL;
+    rmt_del_channel(channel);
+    channel = NULL;
+    return err;
+}
+
+esp_err_t ws2812_wait(uint32_t timeout_ms)
+{
+    if (!in_flight) return ESP_OK;
+    return rmt_tx_wait_all_done(channel, timeout_ms);
+}
+
+esp_err_t ws2812_send(const uint8_t *wire, size_t len)
+{
+    esp_err_t err = ws2812_wait(100);
+    if (err != ESP_OK) return err;
+
+    rmt_transmit_config_t tx_config = { .loop_count = 0 };
+    encoder.encode_cycles = 0;
+    send_start_us = esp_timer_get_time();
+    in_flight = true;
+    err = rmt_transmit(channel, &encoder.base, wire, len, &tx_config);
+    if (err != ESP_OK) in_flight = false;
+    return err;
+}
+
+void ws2812_get_stats(ws2812_stats_t *out)
+{
+    portENTER_CRITICAL(&stats_lock);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_lock);
+}
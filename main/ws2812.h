@@ -0,0 +1,33 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+// WS2812 output on an RMT channel. Frames are sent straight from a buffer
+// of wire bytes (see pixel_pipeline.h), without the per-pixel copy of the
+// led_strip component; the RMT driver streams them through its ping-pong
+// symbol memory while the CPU moves on.
+
+typedef struct {
+    uint32_t frames;
+    uint32_t last_encode_us;    // CPU time spent encoding the last frame
+    uint32_t max_encode_us;
+    uint32_t avg_encode_us;     // moving average over ~16 frames
+    uint32_t last_transmit_us;  // from ws2812_send() to the end of the reset
+    int64_t last_done_us;       // esp_timer time that frame finished
+} ws2812_stats_t;
+
+esp_err_t ws2812_init(int gpio);
+
+// Starts sending len bytes from wire and returns straight away. wire must
+// not change until ws2812_wait() says the frame is out.
+esp_err_t ws2812_send(const uint8_t *wire, size_t len);
+
+// Waits for the frame in flight, if any.
+esp_err_t ws2812_wait(uint32_t timeout_ms);
+
+void ws2812_get_stats(ws2812_stats_t *stats);
+
+#endif // WS2812_H
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+"""Show a Matrix32 CPU profile (GET /profile) with function names.
+
+    tools/profile.py http://192.168.4.1 --ms 5000
+    tools/profile.py profile.json --elf build/Matrix32.elf
+
+Prints CPU use per task, idle time per core, render time per effect and
+the functions the sampler hit most often. Sampled addresses are looked up
+in the firmware ELF with addr2line from the ESP-IDF toolchain; the ELF
+must be the one running on the panel.
+"""
+
+import argparse
+import collections
+import json
+import subprocess
+import sys
+import urllib.request
+
+
+def load(path, ms):
+    if path.startswith("http://") or path.startswith("https://"):
+        url = "%s/profile?ms=%d" % (path.rstrip("/"), ms)
+        with urllib.request.urlopen(url, timeout=ms / 1000 + 30) as resp:
+            return resp.read()
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def symbolize(pcs, elf, addr2line):
+    """Maps each "0x..." address to a function name, or leaves it as is."""
+    if not pcs:
+        return {}
+    try:
+        out = subprocess.run([addr2line, "-f", "-e", elf] + pcs,
+                             capture_output=True, text=True, check=True).stdout
+    except (OSError, subprocess.CalledProcessError) as e:
+        print("addr2line failed (%s), showing raw addresses" % e, file=sys.stderr)
+        return {pc: pc for pc in pcs}
+    lines = out.splitlines()
+    names = {}
+    for n, pc in enumerate(pcs):
+        func = lines[2 * n] if 2 * n < len(lines) else "??"
+        names[pc] = pc if func == "??" else func
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="saved /profile JSON or panel base URL")
+    parser.add_argument("--ms", type=int, default=2000, help="profiling window")
+    parser.add_argument("--elf", default="build/Matrix32.elf", help="firmware image for symbols")
+    parser.add_argument("--addr2line", default="xtensa-esp32s3-elf-addr2line")
+    parser.add_argument("--save", help="keep a copy of the downloaded profile")
+    parser.add_argument("--top", type=int, default=20, help="functions to list")
+    args = parser.parse_args()
+
+    data = load(args.source, args.ms)
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+    profile = json.loads(data)
+
+    print("%d ms window at %d MHz, %d cores" % (profile["window_ms"], profile["cpu_mhz"], profile["cores"]))
+    print("idle: " + ", ".join("core %d %.1f%%" % (n, p) for n, p in enumerate(profile["idle_percent"])))
+
+    print("\n%-16s %6s %5s %10s" % ("task", "cpu%", "prio", "stack free"))
+    for task in sorted(profile["tasks"], key=lambda t: -t["cpu_percent"]):
+        print("%-16s %6.1f %5d %10d" % (task["name"], task["cpu_percent"], task["priority"], task["stack_free"]))
+
+    if profile["effects"]:
+        print("\n%-12s %7s %8s %8s %6s" % ("effect", "frames", "avg us", "max us", "cpu%"))
+        for e in profile["effects"]:
+            print("%-12s %7d %8d %8d %6.1f" % (e["mode"], e["frames"], e["avg_us"], e["max_us"], e["cpu_percent"]))
+
+    samples = profile["samples"]
+    names = symbolize([p["pc"] for p in samples["pcs"]], args.elf, args.addr2line)
+    funcs = collections.Counter()
+    for p in samples["pcs"]:
+        funcs[(names[p["pc"]], p["core"])] += p["count"]
+    total = samples["total"] or 1
+    print("\n%d samples (%d not kept)" % (samples["total"], samples["dropped"]))
+    print("%6s %5s  %s" % ("%", "core", "function"))
+    for (func, core), count in funcs.most_common(args.top):
+        print("%6.1f %5d  %s" % (count * 100 / total, core, func))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Decode a Matrix32 flight recording (GET /recording).
+
+    tools/recording.py http://192.168.4.1 --gif glitch.gif
+    tools/recording.py matrix32.rec --raw frames.rgb
+
+Without an output option it lists the recorded frames. --raw writes every
+frame as packed rgb, row-major; --gif needs Pillow. Frames are the values
+sent to the LEDs, so brightness is already applied (--normalize stretches
+them back to full range for viewing).
+"""
+
+import argparse
+import struct
+import sys
+import urllib.request
+
+MODES = ["static", "rainbow", "checkerboard", "gradient", "random", "palette", "expr"]
+SOURCES = ["http", "effect", "playlist", "network"]
+
+
+def load(path):
+    if path.startswith("http://") or path.startswith("https://"):
+        with urllib.request.urlopen(path.rstrip("/") + "/recording", timeout=30) as resp:
+            return resp.read()
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def decode(data):
+    """Yields (time_ms, mode, source, frame bytes) from the first keyframe on."""
+    if data[:4] != b"M32R" or data[4] != 1:
+        raise ValueError("not a version 1 Matrix32 recording")
+    width, height = data[5], data[6]
+    (count,) = struct.unpack_from("<I", data, 8)
+    size = width * height * 3
+    frame = None
+    pos = 12
+    frames = []
+    for _ in range(count):
+        flags, mode, source, time_ms, length = struct.unpack_from("<BBBIH", data, pos)
+        pos += 9
+        payload = data[pos:pos + length]
+        pos += length
+        if flags & 1:
+            frame = bytearray(size)
+        elif frame is None:
+            continue  # its reference frame was evicted
+        i = o = 0
+        while i < len(payload):
+            token = payload[i]
+            i += 1
+            n = (token & 0x7f) + 1
+            if not token & 0x80:
+                for k in range(n):
+                    frame[o + k] ^= payload[i + k]
+                i += n
+            o += n
+        if o != size:
+            raise ValueError("record at %d ms decodes to %d bytes, expected %d" % (time_ms, o, size))
+        frames.append((time_ms, mode, source, bytes(frame)))
+    return width, height, frames
+
+
+def name(table, value):
+    return table[value] if value < len(table) else "-"
+
+
+def write_gif(path, width, height, frames, scale, normalize):
+    try:
+        from PIL import Image
+    except ImportError:
+        sys.exit("--gif needs Pillow (pip install pillow)")
+    images, durations = [], []
+    for n, (time_ms, _, _, frame) in enumerate(frames):
+        if normalize:
+            peak = max(frame) or 1
+            frame = bytes(min(255, v * 255 // peak) for v in frame)
+        img = Image.frombytes("RGB", (width, height), frame)
+        images.append(img.resize((width * scale, height * scale), Image.NEAREST))
+        next_ms = frames[n + 1][0] if n + 1 < len(frames) else time_ms + 100
+        durations.append(max(20, next_ms - time_ms))
+    images[0].save(path, save_all=True, append_images=images[1:], duration=durations, loop=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="recording file or panel base URL")
+    parser.add_argument("--gif", help="write an animated GIF")
+    parser.add_argument("--raw", help="write packed rgb frames")
+    parser.add_argument("--save", help="keep a copy of the downloaded recording")
+    parser.add_argument("--scale", type=int, default=16, help="GIF pixel size")
+    parser.add_argument("--normalize", action="store_true", help="undo brightness scaling in the GIF")
+    args = parser.parse_args()
+
+    data = load(args.source)
+    if args.save:
+        with open(args.save, "wb") as f:
+            f.write(data)
+    width, height, frames = decode(data)
+    if not frames:
+        sys.exit("recording holds no complete frames")
+
+    start = frames[0][0]
+    print("%dx%d, %d frames over %.1f s (%d bytes)"
+          % (width, height, len(frames), (frames[-1][0] - start) / 1000, len(data)))
+    if not args.gif and not args.raw:
+        for time_ms, mode, source, _ in frames:
+            print("%10d ms  +%7d  %-12s %s" % (time_ms, time_ms - start, name(MODES, mode), name(SOURCES, source)))
+    if args.raw:
+        with open(args.raw, "wb") as f:
+            for frame in frames:
+                f.write(frame[3])
+    if args.gif:
+        write_gif(args.gif, width, height, frames, args.scale, args.normalize)
+
+
+if __name__ == "__main__":
+    main()